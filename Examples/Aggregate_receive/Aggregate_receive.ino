@@ -0,0 +1,108 @@
+// **********************************************************************************
+// Aggregated Receive RFM69 Example
+// Splits the frames built by RFM69_Aggregator (see Aggregate_send) back into readings.
+// Regular packets are printed as text.
+// **********************************************************************************
+// Copyright Felix Rusu 2018, http://www.LowPowerLab.com/contact
+// **********************************************************************************
+// License
+// **********************************************************************************
+// This program is free software; you can redistribute it 
+// and/or modify it under the terms of the GNU General    
+// Public License as published by the Free Software       
+// Foundation; either version 3 of the License, or        
+// (at your option) any later version.                    
+//                                                        
+// This program is distributed in the hope that it will   
+// be useful, but WITHOUT ANY WARRANTY; without even the  
+// implied warranty of MERCHANTABILITY or FITNESS FOR A   
+// PARTICULAR PURPOSE. See the GNU General Public        
+// License for more details.                              
+//                                                        
+// Licence can be viewed at                               
+// http://www.gnu.org/licenses/gpl-3.0.txt
+//
+// Please maintain this license information along with authorship
+// and copyright notices in any redistribution of this code
+// **********************************************************************************
+#include <RFM69.h>            //get it here: https://www.github.com/lowpowerlab/rfm69
+#include <RFM69_ATC.h>        //get it here: https://www.github.com/lowpowerlab/rfm69
+#include <RFM69_Aggregator.h> //get it here: https://www.github.com/lowpowerlab/rfm69
+#include <SPI.h>              //included with Arduino IDE install (www.arduino.cc)
+//*********************************************************************************************
+//************ IMPORTANT SETTINGS - YOU MUST CHANGE/CONFIGURE TO FIT YOUR HARDWARE *************
+//*********************************************************************************************
+#define NODEID      1
+#define NETWORKID   100
+//Match frequency to the hardware version of the radio on your Moteino (uncomment one):
+//#define FREQUENCY     RF69_433MHZ
+//#define FREQUENCY     RF69_868MHZ
+#define FREQUENCY     RF69_915MHZ
+#define ENCRYPTKEY    "sampleEncryptKey" //has to be same 16 characters/bytes on all nodes, not more not less!
+#define IS_RFM69HW_HCW  //uncomment only for RFM69HW/HCW! Leave out if you have RFM69W/CW!
+//*********************************************************************************************
+#define ENABLE_ATC    //comment out this line to disable AUTO TRANSMISSION CONTROL
+//*********************************************************************************************
+#define SERIAL_BAUD   115200
+
+//record types, must match the sender
+#define REC_UPTIME    1
+#define REC_TEMP      2
+#define REC_VCC       3
+
+#ifdef ENABLE_ATC
+  RFM69_ATC radio;
+#else
+  RFM69 radio;
+#endif
+
+void setup() {
+  Serial.begin(SERIAL_BAUD);
+  delay(10);
+  radio.initialize(FREQUENCY,NODEID,NETWORKID);
+#ifdef IS_RFM69HW_HCW
+  radio.setHighPower(); //must include this only for RFM69HW/HCW!
+#endif
+  radio.encrypt(ENCRYPTKEY);
+  Serial.println("\nListening...");
+}
+
+void loop() {
+  if (radio.receiveDone())
+  {
+    Serial.print('[');Serial.print(radio.SENDERID, DEC);Serial.print("] ");
+    if (RFM69_RecordReader::isAggregate(radio.DATA, radio.DATALEN))
+    {
+      RFM69_RecordReader records(radio.DATA, radio.DATALEN);
+      while (records.next())
+      {
+        const uint8_t* value = records.data();
+        if (records.type() == REC_UPTIME && records.length() == 4) {
+          uint32_t uptime; memcpy(&uptime, value, 4);
+          Serial.print(" uptime=");Serial.print(uptime);
+        }
+        else if (records.type() == REC_TEMP && records.length() == 1) {
+          Serial.print(" temp=");Serial.print((int8_t)value[0]);
+        }
+        else if (records.type() == REC_VCC && records.length() == 2) {
+          uint16_t vcc; memcpy(&vcc, value, 2);
+          Serial.print(" vcc=");Serial.print(vcc);
+        }
+        else {
+          Serial.print(" type");Serial.print(records.type());Serial.print(":");Serial.print(records.length());Serial.print("B");
+        }
+      }
+      if (records.error()) Serial.print(" (truncated frame)");
+    }
+    else
+      for (byte i = 0; i < radio.DATALEN; i++) Serial.print((char)radio.DATA[i]);
+    Serial.print("   [RX_RSSI:");Serial.print(radio.RSSI);Serial.print("]");
+
+    if (radio.ACKRequested())
+    {
+      radio.sendACK();
+      Serial.print(" - ACK sent");
+    }
+    Serial.println();
+  }
+}
@@ -0,0 +1,104 @@
+// **********************************************************************************
+// Aggregated Send RFM69 Example
+// Several small readings are packed into one frame (RFM69_Aggregator), so they share
+// one preamble, header, CRC and ACK instead of one sendWithRetry() each.
+// See Aggregate_receive for the gateway side.
+// **********************************************************************************
+// Copyright Felix Rusu 2018, http://www.LowPowerLab.com/contact
+// **********************************************************************************
+// License
+// **********************************************************************************
+// This program is free software; you can redistribute it 
+// and/or modify it under the terms of the GNU General    
+// Public License as published by the Free Software       
+// Foundation; either version 3 of the License, or        
+// (at your option) any later version.                    
+//                                                        
+// This program is distributed in the hope that it will   
+// be useful, but WITHOUT ANY WARRANTY; without even the  
+// implied warranty of MERCHANTABILITY or FITNESS FOR A   
+// PARTICULAR PURPOSE. See the GNU General Public        
+// License for more details.                              
+//                                                        
+// Licence can be viewed at                               
+// http://www.gnu.org/licenses/gpl-3.0.txt
+//
+// Please maintain this license information along with authorship
+// and copyright notices in any redistribution of this code
+// **********************************************************************************
+#include <RFM69.h>            //get it here: https://www.github.com/lowpowerlab/rfm69
+#include <RFM69_ATC.h>        //get it here: https://www.github.com/lowpowerlab/rfm69
+#include <RFM69_Aggregator.h> //get it here: https://www.github.com/lowpowerlab/rfm69
+#include <SPI.h>              //included with Arduino IDE install (www.arduino.cc)
+//*********************************************************************************************
+//************ IMPORTANT SETTINGS - YOU MUST CHANGE/CONFIGURE TO FIT YOUR HARDWARE *************
+//*********************************************************************************************
+#define NODEID      99
+#define NETWORKID   100
+#define GATEWAYID   1
+//Match frequency to the hardware version of the radio on your Moteino (uncomment one):
+//#define FREQUENCY     RF69_433MHZ
+//#define FREQUENCY     RF69_868MHZ
+#define FREQUENCY     RF69_915MHZ
+#define ENCRYPTKEY    "sampleEncryptKey" //has to be same 16 characters/bytes on all nodes, not more not less!
+#define IS_RFM69HW_HCW  //uncomment only for RFM69HW/HCW! Leave out if you have RFM69W/CW!
+//*********************************************************************************************
+#define ENABLE_ATC    //comment out this line to disable AUTO TRANSMISSION CONTROL
+//*********************************************************************************************
+#define SERIAL_BAUD   115200
+#define READ_PERIOD   500  //take a reading this often (ms)
+#define MAX_DELAY     5000 //a reading waits at most this long for others before the frame is sent (ms)
+
+//record types, must match the receiver
+#define REC_UPTIME    1
+#define REC_TEMP      2
+#define REC_VCC       3
+
+#ifdef ENABLE_ATC
+  RFM69_ATC radio;
+#else
+  RFM69 radio;
+#endif
+
+RFM69_Aggregator readings(radio, GATEWAYID, MAX_DELAY);
+
+void setup() {
+  Serial.begin(SERIAL_BAUD);
+  radio.initialize(FREQUENCY,NODEID,NETWORKID);
+#ifdef IS_RFM69HW_HCW
+  radio.setHighPower(); //must include this only for RFM69HW/HCW!
+#endif
+  radio.encrypt(ENCRYPTKEY);
+  Serial.println("\nAggregating readings...");
+}
+
+uint32_t lastRead = 0;
+uint8_t readingType = REC_UPTIME;
+void loop() {
+  if (millis() - lastRead >= READ_PERIOD)
+  {
+    lastRead = millis();
+    if (readingType == REC_UPTIME) {
+      uint32_t uptime = millis();
+      readings.add(REC_UPTIME, &uptime, sizeof(uptime));
+    }
+    else if (readingType == REC_TEMP) {
+      int8_t temp = radio.readTemperature(-1);
+      readings.add(REC_TEMP, &temp, sizeof(temp));
+    }
+    else {
+      uint16_t vcc = analogRead(A7);
+      readings.add(REC_VCC, &vcc, sizeof(vcc));
+    }
+    readingType = readingType == REC_VCC ? REC_UPTIME : readingType + 1;
+    Serial.print("Queued reading, ");Serial.print(readings.pending());Serial.println(" pending");
+  }
+
+  //sends the frame once the oldest reading is MAX_DELAY old (add() sends it when it's full)
+  uint8_t pending = readings.pending();
+  if (!readings.update())
+    Serial.println("Frame not ACKed, will retry");
+  else if (pending && !readings.pending()) {
+    Serial.print("Sent ");Serial.print(pending);Serial.println(" readings in one frame");
+  }
+}
@@ -0,0 +1,147 @@
+// **********************************************************************************
+// Energy accounting benchmark: runs the same sensor node firmware with different radio
+// strategies against an emulated radio and compares the charge they draw (RF69_ENERGY_ENABLE).
+// The node reports every -i seconds to a gateway that ACKs with the RSSI it heard (path loss -l dB),
+// the time between reports is not waited for but added with addSleepTime(), so a day of
+// reports takes a few seconds. The emulator takes the real airtime to transmit (modelAirtime()).
+// Printed per strategy: % of the time in each mode, charge per report, average current
+// and the projected life on a -c mAh battery, radio only.
+// Build: g++ -O2 -pthread -DRF69_ENERGY_ENABLE -I../.. -o EnergyBenchmark EnergyBenchmark.cpp ../../RFM69.cpp
+//          ../../RFM69_ATC.cpp ../../Linux/*.cpp
+// Usage: EnergyBenchmark [-r reports] [-i seconds] [-c mAh] [-l path loss dB]
+// **********************************************************************************
+// Copyright LowPowerLab LLC 2018, https://www.LowPowerLab.com/contact
+// **********************************************************************************
+// License
+// **********************************************************************************
+// This program is free software; you can redistribute it
+// and/or modify it under the terms of the GNU General
+// Public License as published by the Free Software
+// Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will
+// be useful, but WITHOUT ANY WARRANTY; without even the
+// implied warranty of MERCHANTABILITY or FITNESS FOR A
+// PARTICULAR PURPOSE. See the GNU General Public
+// License for more details.
+//
+// Licence can be viewed at
+// http://www.gnu.org/licenses/gpl-3.0.txt
+//
+// Please maintain this license information along with authorship
+// and copyright notices in any redistribution of this code
+// **********************************************************************************
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <RFM69.h>
+#include <RFM69_ATC.h>
+#include "Linux/Emulator.h"
+
+#if !defined(RF69_ENERGY_ENABLE)
+  #error "build with -DRF69_ENERGY_ENABLE"
+#endif
+
+#define NODEID      2
+#define GATEWAYID   1
+#define NETWORKID   100
+#define IRQ_PIN     7
+
+struct Strategy {
+  const char* name;
+  uint8_t idleMode;   // radio mode between reports
+  bool ack;           // sendWithRetry() instead of send()
+  bool highPower;     // RFM69HW at full power
+  int16_t atcTarget;  // RFM69_ATC auto power target, 0 = off (full power)
+};
+
+static const Strategy strategies[] = {
+  { "RX between reports",    RF69_MODE_RX,      true,  false, 0 },
+  { "STANDBY between",       RF69_MODE_STANDBY, true,  false, 0 },
+  { "sleep, no ACK",         RF69_MODE_SLEEP,   false, false, 0 },
+  { "sleep, ACK",            RF69_MODE_SLEEP,   true,  false, 0 },
+  { "sleep, ACK, HW +20dBm", RF69_MODE_SLEEP,   true,  true,  0 },
+  { "sleep, ACK, ATC -85",   RF69_MODE_SLEEP,   true,  false, -85 },
+};
+
+struct Gateway {
+  RFM69Emulator* emulator;
+  RFM69* node;
+  int pathLoss;
+};
+
+// the gateway ACKs every frame that requests it, with the RSSI byte when RFM69_ATC asks for it
+static void gatewayReceive(const uint8_t* frame, uint8_t length, void* context)
+{
+  Gateway* gw = (Gateway*)context;
+  if (length < 3 || frame[0] != GATEWAYID || !(frame[2] & RFM69_CTL_REQACK)) return;
+  int16_t rssi = gw->node->getOutputDBm() - gw->pathLoss;
+  uint8_t ack[4] = { NODEID, GATEWAYID, RFM69_CTL_SENDACK, (uint8_t)-rssi };
+  if (frame[2] & RFM69_CTL_RESERVE1) ack[2] |= RFM69_CTL_RESERVE1;
+  gw->emulator->inject(ack, (ack[2] & RFM69_CTL_RESERVE1) ? 4 : 3, rssi);
+}
+
+int main(int argc, char** argv)
+{
+  uint32_t reports = 200;
+  uint32_t intervalMs = 60000;
+  uint32_t capacity = 2400; // 2xAA
+  int pathLoss = 90;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "r:i:c:l:")) != -1) {
+    switch (opt) {
+      case 'r': reports = atoi(optarg); break;
+      case 'i': intervalMs = atoi(optarg) * 1000; break;
+      case 'c': capacity = atoi(optarg); break;
+      case 'l': pathLoss = atoi(optarg); break;
+      default:
+        fprintf(stderr, "Usage: %s [-r reports] [-i seconds] [-c mAh] [-l path loss dB]\n", argv[0]);
+        return 2;
+    }
+  }
+
+  SPIClass spi("emulator");
+  RFM69Emulator emulator;
+  if (!emulator.attach(spi, IRQ_PIN)) { fprintf(stderr, "emulator failed to start\n"); return 1; }
+  emulator.modelAirtime(true);
+  RFM69_ATC radio(SS, IRQ_PIN, false, &spi);
+  Gateway gw = { &emulator, &radio, pathLoss };
+  emulator.onTransmit(gatewayReceive, &gw);
+
+  printf("%u reports every %lus, %umAh, path loss %ddB\n", reports, (unsigned long)intervalMs / 1000, capacity, pathLoss);
+  printf("%-22s %7s %7s %7s %7s %7s %9s %9s %7s %8s\n", "strategy", "sleep%", "stby%", "synth%", "rx%", "tx%", "uC/rep", "nC/frame", "avg uA", "days");
+  char payload[] = "T:21.5 H:48 V:3.01";
+  for (uint8_t s = 0; s < sizeof(strategies) / sizeof(strategies[0]); s++) {
+    const Strategy& st = strategies[s];
+    if (!radio.initialize(RF69_915MHZ, NODEID, NETWORKID)) { fprintf(stderr, "initialize failed\n"); return 1; }
+    radio.setHighPower(st.highPower);
+    radio.setPowerLevel(31);
+    radio.enableAutoPower(st.atcTarget);
+    uint64_t frameCharge = 0;
+    uint32_t delivered = 0;
+    for (uint32_t i = 0; i < reports; i++) {
+      if (st.ack) delivered += radio.sendWithRetry(GATEWAYID, payload, sizeof(payload) - 1, 2, 40);
+      else radio.send(GATEWAYID, payload, sizeof(payload) - 1);
+      frameCharge += radio.getPacketCharge();
+      if (st.idleMode == RF69_MODE_RX) radio.receiveDone();
+      else if (st.idleMode == RF69_MODE_SLEEP) radio.sleep();
+      radio.addSleepTime(intervalMs);
+    }
+
+    uint32_t total = 0;
+    for (uint8_t m = RF69_MODE_SLEEP; m <= RF69_MODE_TX; m++) total += radio.getResidency(m);
+    printf("%-22s", st.name);
+    static const uint8_t columns[] = { RF69_MODE_SLEEP, RF69_MODE_STANDBY, RF69_MODE_SYNTH, RF69_MODE_RX, RF69_MODE_TX };
+    for (uint8_t c = 0; c < sizeof(columns); c++)
+      printf(" %7.3f", 100.0 * radio.getResidency(columns[c]) / total);
+    printf(" %9.1f %9lu %7lu %8.1f", (double)radio.getCharge() / reports, (unsigned long)(frameCharge / reports),
+           (unsigned long)radio.getAverageCurrent(), radio.getBatteryLife(capacity) / 24.0);
+    if (st.ack) printf("  acked %u/%u", delivered, reports);
+    if (st.atcTarget) printf(" at %ddBm", radio.getOutputDBm());
+    printf("\n");
+    radio.sleep();
+  }
+  return 0;
+}
@@ -0,0 +1,95 @@
+// **********************************************************************************
+// Fragmented Receive RFM69 Example
+// Reassembles the messages sent with RFM69_sendFragmented (see Fragmented_send).
+// Regular packets are printed as text.
+// **********************************************************************************
+// Copyright Felix Rusu 2018, http://www.LowPowerLab.com/contact
+// **********************************************************************************
+// License
+// **********************************************************************************
+// This program is free software; you can redistribute it 
+// and/or modify it under the terms of the GNU General    
+// Public License as published by the Free Software       
+// Foundation; either version 3 of the License, or        
+// (at your option) any later version.                    
+//                                                        
+// This program is distributed in the hope that it will   
+// be useful, but WITHOUT ANY WARRANTY; without even the  
+// implied warranty of MERCHANTABILITY or FITNESS FOR A   
+// PARTICULAR PURPOSE. See the GNU General Public        
+// License for more details.                              
+//                                                        
+// Licence can be viewed at                               
+// http://www.gnu.org/licenses/gpl-3.0.txt
+//
+// Please maintain this license information along with authorship
+// and copyright notices in any redistribution of this code
+// **********************************************************************************
+#include <RFM69.h>            //get it here: https://www.github.com/lowpowerlab/rfm69
+#include <RFM69_ATC.h>        //get it here: https://www.github.com/lowpowerlab/rfm69
+#include <RFM69_Fragment.h>   //get it here: https://www.github.com/lowpowerlab/rfm69
+#include <SPI.h>              //included with Arduino IDE install (www.arduino.cc)
+//*********************************************************************************************
+//************ IMPORTANT SETTINGS - YOU MUST CHANGE/CONFIGURE TO FIT YOUR HARDWARE *************
+//*********************************************************************************************
+#define NODEID      1
+#define NETWORKID   100
+//Match frequency to the hardware version of the radio on your Moteino (uncomment one):
+//#define FREQUENCY     RF69_433MHZ
+//#define FREQUENCY     RF69_868MHZ
+#define FREQUENCY     RF69_915MHZ
+#define ENCRYPTKEY    "sampleEncryptKey" //has to be same 16 characters/bytes on all nodes, not more not less!
+#define IS_RFM69HW_HCW  //uncomment only for RFM69HW/HCW! Leave out if you have RFM69W/CW!
+//*********************************************************************************************
+#define ENABLE_ATC    //comment out this line to disable AUTO TRANSMISSION CONTROL
+//*********************************************************************************************
+#define SERIAL_BAUD   115200
+
+#ifdef ENABLE_ATC
+  RFM69_ATC radio;
+#else
+  RFM69 radio;
+#endif
+
+uint8_t messageBuffer[512]; //largest message accepted
+RFM69_Reassembler reassembler(messageBuffer, sizeof(messageBuffer));
+
+void setup() {
+  Serial.begin(SERIAL_BAUD);
+  delay(10);
+  radio.initialize(FREQUENCY,NODEID,NETWORKID);
+#ifdef IS_RFM69HW_HCW
+  radio.setHighPower(); //must include this only for RFM69HW/HCW!
+#endif
+  radio.encrypt(ENCRYPTKEY);
+  Serial.println("\nListening...");
+}
+
+void loop() {
+  if (radio.receiveDone())
+  {
+    if (RFM69_Reassembler::isFragment(radio.DATA, radio.DATALEN))
+    {
+      //fragments are ACKed by the reassembler
+      if (reassembler.receive(radio))
+      {
+        Serial.print('[');Serial.print(reassembler.sender(), DEC);Serial.print("] ");
+        Serial.print(reassembler.length());Serial.println(" bytes:");
+        for (uint16_t i = 0; i < reassembler.length(); i++)
+          Serial.print((char)reassembler.data()[i]);
+        Serial.println();
+      }
+      return;
+    }
+
+    Serial.print('[');Serial.print(radio.SENDERID, DEC);Serial.print("] ");
+    for (byte i = 0; i < radio.DATALEN; i++) Serial.print((char)radio.DATA[i]);
+    Serial.print("   [RX_RSSI:");Serial.print(radio.RSSI);Serial.print("]");
+    if (radio.ACKRequested())
+    {
+      radio.sendACK();
+      Serial.print(" - ACK sent");
+    }
+    Serial.println();
+  }
+}
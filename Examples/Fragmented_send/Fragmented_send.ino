@@ -0,0 +1,84 @@
+// **********************************************************************************
+// Fragmented Send RFM69 Example
+// Sends a message larger than one frame (RFM69_sendFragmented), the receiver confirms
+// all fragments with one block ACK per round. See Fragmented_receive for the other side.
+// **********************************************************************************
+// Copyright Felix Rusu 2018, http://www.LowPowerLab.com/contact
+// **********************************************************************************
+// License
+// **********************************************************************************
+// This program is free software; you can redistribute it 
+// and/or modify it under the terms of the GNU General    
+// Public License as published by the Free Software       
+// Foundation; either version 3 of the License, or        
+// (at your option) any later version.                    
+//                                                        
+// This program is distributed in the hope that it will   
+// be useful, but WITHOUT ANY WARRANTY; without even the  
+// implied warranty of MERCHANTABILITY or FITNESS FOR A   
+// PARTICULAR PURPOSE. See the GNU General Public        
+// License for more details.                              
+//                                                        
+// Licence can be viewed at                               
+// http://www.gnu.org/licenses/gpl-3.0.txt
+//
+// Please maintain this license information along with authorship
+// and copyright notices in any redistribution of this code
+// **********************************************************************************
+#include <RFM69.h>            //get it here: https://www.github.com/lowpowerlab/rfm69
+#include <RFM69_ATC.h>        //get it here: https://www.github.com/lowpowerlab/rfm69
+#include <RFM69_Fragment.h>   //get it here: https://www.github.com/lowpowerlab/rfm69
+#include <SPI.h>              //included with Arduino IDE install (www.arduino.cc)
+//*********************************************************************************************
+//************ IMPORTANT SETTINGS - YOU MUST CHANGE/CONFIGURE TO FIT YOUR HARDWARE *************
+//*********************************************************************************************
+#define NODEID      99
+#define NETWORKID   100
+#define GATEWAYID   1
+//Match frequency to the hardware version of the radio on your Moteino (uncomment one):
+//#define FREQUENCY     RF69_433MHZ
+//#define FREQUENCY     RF69_868MHZ
+#define FREQUENCY     RF69_915MHZ
+#define ENCRYPTKEY    "sampleEncryptKey" //has to be same 16 characters/bytes on all nodes, not more not less!
+#define IS_RFM69HW_HCW  //uncomment only for RFM69HW/HCW! Leave out if you have RFM69W/CW!
+//*********************************************************************************************
+#define ENABLE_ATC    //comment out this line to disable AUTO TRANSMISSION CONTROL
+//*********************************************************************************************
+#define SERIAL_BAUD   115200
+#define SEND_PERIOD   10000 //send the log this often (ms)
+
+#ifdef ENABLE_ATC
+  RFM69_ATC radio;
+#else
+  RFM69 radio;
+#endif
+
+char logBuffer[300];
+
+void setup() {
+  Serial.begin(SERIAL_BAUD);
+  radio.initialize(FREQUENCY,NODEID,NETWORKID);
+#ifdef IS_RFM69HW_HCW
+  radio.setHighPower(); //must include this only for RFM69HW/HCW!
+#endif
+  radio.encrypt(ENCRYPTKEY);
+  Serial.println("\nSending fragmented log...");
+}
+
+uint32_t lastSend = 0;
+void loop() {
+  if (millis() - lastSend >= SEND_PERIOD)
+  {
+    lastSend = millis();
+    //build a log much larger than RF69_MAX_DATA_LEN
+    uint16_t len = 0;
+    for (uint8_t i = 0; i < 10 && len < sizeof(logBuffer) - 30; i++)
+      len += sprintf(logBuffer + len, "entry %d at %lums\n", i, millis());
+
+    uint32_t start = millis();
+    bool ok = RFM69_sendFragmented(radio, GATEWAYID, logBuffer, len);
+    Serial.print(len);Serial.print(" bytes ");
+    Serial.print(ok ? "delivered" : "failed");
+    Serial.print(" in ");Serial.print(millis() - start);Serial.println("ms");
+  }
+}
@@ -57,6 +57,10 @@
 //dial their power down to only the required level
 #define ENABLE_ATC    //comment out this line to disable AUTO TRANSMISSION CONTROL
 //*********************************************************************************************
+//Auto-ACK - the driver ACKs as soon as the packet is read, before loop() gets to it
+//This shortens the round trip so nodes can use a much shorter retryWaitTime
+//#define ENABLE_AUTOACK
+//*********************************************************************************************
 #define SERIAL_BAUD   115200
 
 #ifdef ENABLE_ATC
@@ -77,6 +81,9 @@ void setup() {
 #endif
   radio.encrypt(ENCRYPTKEY);
   radio.spyMode(spy);
+#ifdef ENABLE_AUTOACK
+  radio.enableAutoACK();
+#endif
   //radio.setFrequency(916000000); //set frequency to some custom frequency
   char buff[50];
   sprintf(buff, "\nListening at %d Mhz...", FREQUENCY==RF69_433MHZ ? 433 : FREQUENCY==RF69_868MHZ ? 868 : 915);
@@ -176,10 +183,10 @@ void loop() {
       Serial.print((char)radio.DATA[i]);
     Serial.print("   [RX_RSSI:");Serial.print(radio.RSSI);Serial.print("]");
     
-    if (radio.ACKRequested())
+    if (radio.ACKRequested() || radio.ACKSent())
     {
       byte theNodeID = radio.SENDERID;
-      radio.sendACK();
+      if (!radio.ACKSent()) radio.sendACK();
       Serial.print(" - ACK sent.");
 
       // When a node requests an ACK, respond to the ACK
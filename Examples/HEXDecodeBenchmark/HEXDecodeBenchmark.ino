@@ -0,0 +1,68 @@
+// Micro-benchmark of the OTA programmer HEX record decoding
+// Times the classic validateHEXData() + prepareSendBuffer() pair against the
+// single pass decodeHEXRecord() on a typical 16 data byte Intel HEX record,
+// and checks both produce the same bytes. Run it on the MCU that acts as the OTA Programmer.
+// **********************************************************************************
+// Copyright LowPowerLab LLC 2018, https://www.LowPowerLab.com/contact
+// **********************************************************************************
+// License
+// **********************************************************************************
+// This program is free software; you can redistribute it 
+// and/or modify it under the terms of the GNU General    
+// Public License as published by the Free Software       
+// Foundation; either version 3 of the License, or        
+// (at your option) any later version.                    
+//                                                        
+// This program is distributed in the hope that it will   
+// be useful, but WITHOUT ANY WARRANTY; without even the  
+// implied warranty of MERCHANTABILITY or FITNESS FOR A   
+// PARTICULAR PURPOSE. See the GNU General Public        
+// License for more details.                              
+//                                                        
+// Licence can be viewed at                               
+// http://www.gnu.org/licenses/gpl-3.0.txt
+//
+// Please maintain this license information along with authorship
+// and copyright notices in any redistribution of this code
+// **********************************************************************************
+#include <RFM69.h>         //get it here: https://github.com/lowpowerlab/rfm69
+#include <RFM69_OTA.h>     //get it here: https://github.com/lowpowerlab/RFM69
+#include <SPIFlash.h>      //get it here: https://github.com/lowpowerlab/spiflash
+
+#define SERIAL_BAUD   115200
+#define ITERATIONS    1000
+
+char record[] = "10042000FF4FA591B4912FB7F894662321F48C91D6"; //as sent by the host after FLX:seq:
+uint8_t classicBuf[57];
+uint8_t decodeBuf[57];
+
+void setup() {
+  Serial.begin(SERIAL_BAUD);
+  delay(100);
+}
+
+void loop() {
+  uint8_t recordLen = strlen(record);
+  volatile uint8_t sink = 0;
+  HEXRecord header;
+
+  uint32_t start = micros();
+  for (uint16_t i = 0; i < ITERATIONS; i++) {
+    uint8_t dataLen = validateHEXData(record, recordLen);
+    sink += prepareSendBuffer(record+8, classicBuf, dataLen, 0);
+  }
+  uint32_t classicUs = micros() - start;
+
+  start = micros();
+  for (uint16_t i = 0; i < ITERATIONS; i++) {
+    uint8_t seqLen = sprintf((char*)decodeBuf, "FLX:%u:", 0);
+    sink += seqLen + decodeHEXRecord(record, recordLen, decodeBuf+seqLen, sizeof(decodeBuf)-seqLen, header);
+  }
+  uint32_t decodeUs = micros() - start;
+
+  Serial.print(F("validateHEXData+prepareSendBuffer: ")); Serial.print(classicUs / (float)ITERATIONS); Serial.println(F(" us/record"));
+  Serial.print(F("decodeHEXRecord:                   ")); Serial.print(decodeUs / (float)ITERATIONS); Serial.println(F(" us/record"));
+  Serial.println(memcmp(classicBuf, decodeBuf, 6 + header.length) == 0 ? F("output matches") : F("OUTPUT MISMATCH!"));
+  Serial.println();
+  delay(5000);
+}
@@ -0,0 +1,523 @@
+// **********************************************************************************
+// Multithreaded native Linux gateway daemon
+// The work PiGateway does in one loop() is split into stages connected by bounded SPSC
+// rings (SPSCRing.h), each stage in its own thread:
+//   radio service  - one thread per radio: DIO0 handling, packet readout, ACKs (with the
+//                    node's pending commands as payload) and transmissions to nodes.
+//                    It only ever does non blocking pushes: when the decode ring is full the
+//                    packet is dropped and counted, it never waits on the stages behind it
+//   decode/dispatch - formats packets as "[id] payload SS:rssi" lines or binary frames (-B, see RFM69_Frame.h)
+//   command matching - parses host commands from stdin (same syntax as PiGateway: 123:MSG, RQ:123:MSG,
+//                    123:VOID, 123:VOID:MSG, RQ, RQ:VOID, SYSFREQ, UPTIME) and routes them to the radio,
+//                    which owns its RFM69_Queue of pending commands so ACKs never wait for another thread
+//   output         - writes to stdout, the only stage allowed to block on a slow reader
+// With -S every N seconds each stage's ring depth (now/max), queue wait latency (avg/max) and drops
+// are printed on stderr (full: pushes refused because the ring was full, for the radio these are dropped
+// packets, the other stages retry), plus the end to end latency from packet readout to stdout.
+// The driver keeps the received packet in static members (RFM69::DATA etc), so one radio per process:
+// run one daemon per radio.
+// With -e it runs against an emulated radio, -r <packets/s> makes it receive that many packets
+// from node 2 (every other one requesting an ACK) to load the pipeline.
+// Build: g++ -O2 -pthread -I../.. -o GatewayDaemon GatewayDaemon.cpp ../../RFM69.cpp ../../RFM69_ATC.cpp
+//          ../../RFM69_Queue.cpp ../../RFM69_Frame.cpp ../../Linux/*.cpp
+// Usage: GatewayDaemon [-s /dev/spidev0.0] [-g /dev/gpiochip0] [-i 25] [-b 915] [-n 1] [-N 100] [-k key] [-H]
+//                      [-B] [-S seconds] [-e [-r packets/s]]
+// **********************************************************************************
+// Copyright LowPowerLab LLC 2018, https://www.LowPowerLab.com/contact
+// **********************************************************************************
+// License
+// **********************************************************************************
+// This program is free software; you can redistribute it
+// and/or modify it under the terms of the GNU General
+// Public License as published by the Free Software
+// Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will
+// be useful, but WITHOUT ANY WARRANTY; without even the
+// implied warranty of MERCHANTABILITY or FITNESS FOR A
+// PARTICULAR PURPOSE. See the GNU General Public
+// License for more details.
+//
+// Licence can be viewed at
+// http://www.gnu.org/licenses/gpl-3.0.txt
+//
+// Please maintain this license information along with authorship
+// and copyright notices in any redistribution of this code
+// **********************************************************************************
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <atomic>
+#include <thread>
+#include <RFM69.h>
+#include <RFM69_ATC.h>
+#include <RFM69_Queue.h>
+#include <RFM69_Frame.h>
+#include "Linux/Emulator.h"
+#include "SPSCRing.h"
+
+#define QUEUE_CAPACITY          200 //pending commands per radio
+#define MAX_ACK_REQUEST_LENGTH  30  //same as PiGateway, leaves room for :OK/:INV confirmations
+#define LINE_LENGTH             (RFM69_FRAME_MAXLEN > 96 ? RFM69_FRAME_MAXLEN : 96)
+
+#define CMD_SEND     0 //send, and queue on failure if queueOnFail
+#define CMD_VOID     1 //remove the node's commands (all, or the one matching data)
+#define CMD_VOIDALL  2
+#define CMD_LIST     3
+#define CMD_SYSFREQ  4
+
+struct RxPacket {
+  uint64_t readUs;   //read out of the radio
+  uint64_t queuedUs;
+  uint16_t sender;
+  uint16_t target;
+  int16_t rssi;
+  uint8_t flags;
+  uint8_t length;
+  uint8_t data[RF69_MAX_DATA_LEN];
+};
+
+struct Command {
+  uint64_t queuedUs;
+  uint8_t op;
+  bool queueOnFail;
+  uint16_t node;
+  char data[RFM69_QUEUE_DATALEN];
+};
+
+struct OutLine {
+  uint64_t readUs;   //0 if not a packet
+  uint64_t queuedUs;
+  uint8_t length;
+  uint8_t data[LINE_LENGTH];
+};
+
+// queue wait latency of the items leaving one ring, written by its consumer only
+struct StageStats {
+  std::atomic<uint64_t> items, sumUs, maxUs;
+  StageStats() : items(0), sumUs(0), maxUs(0) {}
+  void add(uint64_t us)
+  {
+    items++;
+    sumUs += us;
+    if (us > maxUs.load(std::memory_order_relaxed)) maxUs.store(us, std::memory_order_relaxed);
+  }
+};
+
+static std::atomic<bool> running(true);
+static bool binaryOutput = false;
+
+static SPSCRing<RxPacket, 1024> decodeRing;  //radio -> decode
+static SPSCRing<Command, 64> commandRing;    //matching -> radio
+static SPSCRing<OutLine, 1024> packetOutRing; //decode -> output
+static SPSCRing<OutLine, 64> radioOutRing;   //radio -> output (RQ listings, MEMFULL)
+static SPSCRing<OutLine, 64> matchOutRing;   //matching -> output (replies, errors)
+static Doorbell decodeBell, commandBell, outputBell;
+static StageStats decodeStats, commandStats, outputStats, endToEndStats;
+static std::atomic<uint64_t> received(0), acks(0), sent(0), sendFailures(0);
+
+static uint64_t nowUs()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+}
+
+static void makeLine(OutLine& line, uint64_t readUs, const char* format, ...) __attribute__((format(printf, 3, 4)));
+static void makeLine(OutLine& line, uint64_t readUs, const char* format, ...)
+{
+  va_list args;
+  va_start(args, format);
+  int n = vsnprintf((char*)line.data, sizeof(line.data) - 1, format, args);
+  va_end(args);
+  if (n < 0) n = 0;
+  if (n > (int)sizeof(line.data) - 2) n = sizeof(line.data) - 2;
+  line.data[n++] = '\n';
+  line.length = n;
+  line.readUs = readUs;
+}
+
+// blocking push, for the stages that are allowed to wait on the ones behind them
+template <class T, uint32_t N>
+static void pushWait(SPSCRing<T, N>& ring, T& item, Doorbell& bell)
+{
+  item.queuedUs = nowUs();
+  while (!ring.push(item) && running) usleep(500);
+  bell.ring();
+}
+
+//=============================================================================
+// radio service stage
+//=============================================================================
+struct RadioStage {
+  RFM69_ATC* radio;
+  uint16_t nodeId;
+  RFM69_Request slots[QUEUE_CAPACITY];
+  RFM69_Queue queue;
+  RadioStage(RFM69_ATC* radio, uint16_t nodeId) : radio(radio), nodeId(nodeId), queue(slots, QUEUE_CAPACITY) {}
+
+  void output(OutLine& line) //never blocks, the listing is cut short when output is behind
+  {
+    line.queuedUs = nowUs();
+    if (radioOutRing.push(line)) outputBell.ring();
+  }
+
+  void readPacket()
+  {
+    RxPacket p;
+    p.readUs = nowUs();
+    p.sender = radio->SENDERID;
+    p.target = radio->TARGETID;
+    p.rssi = radio->RSSI;
+    p.flags = radio->ACK_REQUESTED ? RFM69_FRAME_ACKREQ : 0;
+    p.length = radio->DATALEN;
+    memcpy(p.data, radio->DATA, p.length);
+    received++;
+
+    // ACK first, the node is waiting; DATA is not valid after this
+    if (radio->ACKRequested())
+    {
+      char buff[RF69_MAX_DATA_LEN];
+      uint8_t len = queue.pack(p.sender, buff, MAX_ACK_REQUEST_LENGTH);
+      if (len) radio->sendACK(buff, len);
+      else radio->sendACK();
+      acks++;
+    }
+
+    if (p.length == 0) return; //ACK/empty packets are not forwarded, like PiGateway
+    p.queuedUs = nowUs();
+    if (decodeRing.push(p)) decodeBell.ring(); //full: dropped, counted by the ring
+  }
+
+  void execute(Command& c)
+  {
+    commandStats.add(nowUs() - c.queuedUs);
+    OutLine line;
+    switch (c.op) {
+      case CMD_SEND:
+        if (radio->sendWithRetry(c.node, c.data, strlen(c.data))) { sent++; return; }
+        sendFailures++;
+        if (!c.queueOnFail || queue.contains(c.node, c.data)) return;
+        if (!queue.insert(c.node, c.data))
+        {
+          makeLine(line, 0, "[%u] %s:MEMFULL", c.node, c.data);
+          output(line);
+        }
+        return;
+      case CMD_VOID:
+        queue.remove(c.node, c.data[0] ? c.data : NULL);
+        return;
+      case CMD_VOIDALL:
+        queue.clear();
+        return;
+      case CMD_LIST:
+        if (!queue.size()) { makeLine(line, 0, "RQ:EMPTY"); output(line); }
+        for (uint8_t i = queue.firstAll(); i != RFM69_QUEUE_NONE; i = queue.nextAll(i))
+        {
+          makeLine(line, 0, "RQ:%u:%s", queue.get(i).nodeId, queue.get(i).data);
+          output(line);
+        }
+        return;
+      case CMD_SYSFREQ:
+        makeLine(line, 0, "SYSFREQ:%u", radio->getFrequency());
+        output(line);
+        return;
+    }
+  }
+
+  void run()
+  {
+    // wake on DIO0 (the interrupt epoll) or on a command
+    int ep = epoll_create1(EPOLL_CLOEXEC);
+    struct epoll_event ev;
+    ev.events = EPOLLIN;
+    ev.data.fd = interruptFd();
+    epoll_ctl(ep, EPOLL_CTL_ADD, interruptFd(), &ev);
+    ev.data.fd = commandBell.fd();
+    epoll_ctl(ep, EPOLL_CTL_ADD, commandBell.fd(), &ev);
+
+    while (running)
+    {
+      if (radio->receiveDone()) { readPacket(); continue; }
+      Command c;
+      if (commandRing.pop(c)) { execute(c); continue; }
+      struct epoll_event events[2];
+      if (epoll_wait(ep, events, 2, 100) > 0) commandBell.clear();
+    }
+    close(ep);
+  }
+};
+
+//=============================================================================
+// decode/dispatch stage
+//=============================================================================
+static void decodeStage()
+{
+  RxPacket p;
+  OutLine line;
+  while (running)
+  {
+    if (!decodeRing.pop(p)) { decodeBell.wait(100); continue; }
+    decodeStats.add(nowUs() - p.queuedUs);
+    if (binaryOutput)
+    {
+      RFM69_FrameHeader header;
+      header.type = RFM69_FRAME_PACKET;
+      header.flags = p.flags;
+      header.sender = p.sender;
+      header.target = p.target;
+      header.rssi = p.rssi < -128 ? -128 : p.rssi;
+      header.length = p.length;
+      line.length = RFM69_encodeFrame(header, p.data, line.data);
+      line.readUs = p.readUs;
+    }
+    else
+    {
+      char payload[RF69_MAX_DATA_LEN + 1];
+      for (uint8_t i = 0; i < p.length; i++) //keep one packet per line
+        payload[i] = (p.data[i] == '\n' || p.data[i] == '\r' || p.data[i] == 0) ? ' ' : p.data[i];
+      payload[p.length] = 0;
+      makeLine(line, p.readUs, "[%u] %s SS:%d", p.sender, payload, p.rssi);
+    }
+    pushWait(packetOutRing, line, outputBell);
+  }
+}
+
+//=============================================================================
+// command matching stage, reads the host commands from stdin
+//=============================================================================
+static void reply(const char* text)
+{
+  OutLine line;
+  makeLine(line, 0, "%s", text);
+  pushWait(matchOutRing, line, outputBell);
+}
+
+static void processCommand(char* data, uint16_t nodeId)
+{
+  Command c;
+  memset(&c, 0, sizeof(c));
+  char buf[RFM69_QUEUE_DATALEN + 48];
+  if (strcmp(data, "UPTIME") == 0) { snprintf(buf, sizeof(buf), "UPTIME:%lu", millis()); reply(buf); return; }
+  if (strcmp(data, "SYSFREQ") == 0) { c.op = CMD_SYSFREQ; pushWait(commandRing, c, commandBell); return; }
+  if (strcmp(data, "RQ") == 0) { c.op = CMD_LIST; pushWait(commandRing, c, commandBell); return; }
+  if (strcmp(data, "RQ:VOID") == 0) { c.op = CMD_VOIDALL; pushWait(commandRing, c, commandBell); return; }
+
+  bool queueRequest = strncmp(data, "RQ:", 3) == 0;
+  char* p = queueRequest ? data + 3 : data;
+  char* colon = strchr(p, ':');
+  if (!colon || !colon[1]) return;
+  long target = atol(p);
+  char* command = colon + 1;
+  if (target <= 0 || target == nodeId || target > 1023)
+  {
+    snprintf(buf, sizeof(buf), "[%ld] %.*s:INV:ID-OUT-OF-RANGE", target, RFM69_QUEUE_DATALEN, command);
+    reply(buf);
+    return;
+  }
+
+  c.node = target;
+  if (strncmp(command, "VOID", 4) == 0)
+  {
+    c.op = CMD_VOID;
+    if (command[4] == ':' && command[5]) snprintf(c.data, sizeof(c.data), "%s", command + 5);
+  }
+  else
+  {
+    c.op = CMD_SEND;
+    c.queueOnFail = queueRequest;
+    snprintf(c.data, sizeof(c.data), "%s", command);
+  }
+  pushWait(commandRing, c, commandBell);
+}
+
+static void commandStage(uint16_t nodeId)
+{
+  char input[256];
+  size_t inputPos = 0;
+  while (running)
+  {
+    struct pollfd pfd = { STDIN_FILENO, POLLIN, 0 };
+    if (poll(&pfd, 1, 100) <= 0) continue;
+    char buf[256];
+    ssize_t n = read(STDIN_FILENO, buf, sizeof(buf));
+    if (n <= 0) return; //stdin closed, keep gatewaying
+    for (ssize_t i = 0; i < n; i++)
+    {
+      if (buf[i] == '\r') continue;
+      if (buf[i] != '\n') { if (inputPos < sizeof(input) - 1) input[inputPos++] = buf[i]; continue; }
+      input[inputPos] = 0;
+      if (inputPos) processCommand(input, nodeId);
+      inputPos = 0;
+    }
+  }
+}
+
+//=============================================================================
+// output stage
+//=============================================================================
+static bool writeAll(const uint8_t* p, size_t length)
+{
+  while (length) {
+    ssize_t n = write(STDOUT_FILENO, p, length);
+    if (n < 0) { if (errno == EINTR) continue; return false; }
+    p += n; length -= n;
+  }
+  return true;
+}
+
+static void outputStage()
+{
+  OutLine line;
+  while (running)
+  {
+    bool any = false;
+    while (radioOutRing.pop(line) || matchOutRing.pop(line) || packetOutRing.pop(line))
+    {
+      uint64_t now = nowUs();
+      outputStats.add(now - line.queuedUs);
+      if (!writeAll(line.data, line.length)) { running = false; return; }
+      if (line.readUs) endToEndStats.add(nowUs() - line.readUs);
+      any = true;
+    }
+    if (!any) outputBell.wait(100);
+  }
+}
+
+//=============================================================================
+// load generator for the emulated radio
+//=============================================================================
+static void injectStage(RFM69Emulator* emulator, uint16_t nodeId, unsigned rate)
+{
+  uint64_t next = nowUs();
+  uint32_t count = 0;
+  while (running)
+  {
+    char msg[RF69_MAX_DATA_LEN];
+    int len = snprintf(msg, sizeof(msg), "T:%u.%u H:%u #%u", 20 + count % 10, count % 10, 40 + count % 20, count);
+    emulator->injectPacket(2, nodeId, msg, len, count & 1, -40 - (int)(count % 50));
+    count++;
+    next += 1000000 / rate;
+    uint64_t now = nowUs();
+    if (next > now) usleep(next - now);
+  }
+}
+
+static void printStats(const char* name, StageStats& s, uint32_t depth, uint32_t maxDepth, uint32_t capacity, uint32_t drops)
+{
+  uint64_t items = s.items.exchange(0), sum = s.sumUs.exchange(0), max = s.maxUs.exchange(0);
+  fprintf(stderr, " %s[q:%u/%u max:%u lat avg:%lluus max:%lluus n:%llu full:%u]", name, depth, capacity, maxDepth,
+          (unsigned long long)(items ? sum / items : 0), (unsigned long long)max, (unsigned long long)items, drops);
+}
+
+static int bandConstant(int mhz)
+{
+  switch (mhz) {
+    case 315: return RF69_315MHZ;
+    case 433: return RF69_433MHZ;
+    case 868: return RF69_868MHZ;
+    default:  return RF69_915MHZ;
+  }
+}
+
+static void stop(int) { running = false; }
+
+static void usage(const char* prog)
+{
+  fprintf(stderr, "Usage: %s [-s spidev] [-g gpiochip] [-i irq line] [-b 315|433|868|915] [-n node id] [-N network id] [-k key] [-H] [-B] [-S seconds] [-e [-r packets/s]]\n", prog);
+}
+
+int main(int argc, char** argv)
+{
+  const char* spidev = "/dev/spidev0.0";
+  const char* gpiochip = "/dev/gpiochip0";
+  uint8_t irqPin = 25;
+  int band = 915;
+  uint16_t nodeId = 1;
+  uint8_t networkId = 100;
+  const char* key = NULL;
+  bool highPower = false;
+  bool emulated = false;
+  unsigned rate = 0;
+  unsigned statsInterval = 0;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "s:g:i:b:n:N:k:HBS:er:")) != -1) {
+    switch (opt) {
+      case 's': spidev = optarg; break;
+      case 'g': gpiochip = optarg; break;
+      case 'i': irqPin = atoi(optarg); break;
+      case 'b': band = atoi(optarg); break;
+      case 'n': nodeId = atoi(optarg); break;
+      case 'N': networkId = atoi(optarg); break;
+      case 'k': key = optarg; break;
+      case 'H': highPower = true; break;
+      case 'B': binaryOutput = true; break;
+      case 'S': statsInterval = atoi(optarg); break;
+      case 'e': emulated = true; break;
+      case 'r': rate = atoi(optarg); break;
+      default: usage(argv[0]); return 2;
+    }
+  }
+  if (key && strlen(key) != 16) { fprintf(stderr, "the key must be 16 characters\n"); return 2; }
+  signal(SIGINT, stop);
+  signal(SIGTERM, stop);
+  signal(SIGPIPE, SIG_IGN);
+
+  SPIClass spi(spidev);
+  RFM69Emulator emulator;
+  if (emulated) {
+    if (!emulator.attach(spi, irqPin)) { perror("emulator"); return 1; }
+  }
+  else if (!gpioOpenChip(gpiochip)) return 1;
+
+  RFM69_ATC radio(SS, irqPin, highPower, &spi);
+  if (!radio.initialize(bandConstant(band), nodeId, networkId)) {
+    fprintf(stderr, "RFM69 not found\n");
+    return 1;
+  }
+  if (highPower) radio.setHighPower();
+  radio.encrypt(key);
+
+  static RadioStage radioStage(&radio, nodeId);
+  std::thread radioThread(&RadioStage::run, &radioStage);
+  std::thread decodeThread(decodeStage);
+  std::thread outputThread(outputStage);
+  std::thread commandThread(commandStage, nodeId);
+  std::thread injectThread;
+  if (emulated && rate) injectThread = std::thread(injectStage, &emulator, nodeId, rate);
+
+  uint64_t lastStats = nowUs();
+  uint64_t lastReceived = 0;
+  while (running)
+  {
+    usleep(100000);
+    if (!statsInterval || nowUs() - lastStats < statsInterval * 1000000ULL) continue;
+    double seconds = (nowUs() - lastStats) / 1e6;
+    lastStats = nowUs();
+    uint64_t rx = received;
+    fprintf(stderr, "radio[rx:%llu %.0f/s dropped:%u acks:%llu sent:%llu fail:%llu]", (unsigned long long)rx, (rx - lastReceived) / seconds,
+            decodeRing.drops(), (unsigned long long)acks, (unsigned long long)sent, (unsigned long long)sendFailures);
+    lastReceived = rx;
+    printStats("decode", decodeStats, decodeRing.depth(), decodeRing.maxDepth(), decodeRing.capacity(), decodeRing.drops());
+    printStats("command", commandStats, commandRing.depth(), commandRing.maxDepth(), commandRing.capacity(), commandRing.drops());
+    printStats("output", outputStats, packetOutRing.depth(), packetOutRing.maxDepth(), packetOutRing.capacity(), packetOutRing.drops());
+    uint64_t items = endToEndStats.items.exchange(0), sum = endToEndStats.sumUs.exchange(0), max = endToEndStats.maxUs.exchange(0);
+    fprintf(stderr, " end2end[avg:%lluus max:%lluus]\n", (unsigned long long)(items ? sum / items : 0), (unsigned long long)max);
+  }
+
+  if (injectThread.joinable()) injectThread.join();
+  radioThread.join();
+  decodeThread.join();
+  outputThread.join();
+  commandThread.join();
+  return 0;
+}
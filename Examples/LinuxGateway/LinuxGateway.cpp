@@ -0,0 +1,120 @@
+// **********************************************************************************
+// Native Linux gateway: the RFM69 is wired to the host's SPI bus (ex: Raspberry Pi) and
+// driven directly by this process, no serial attached Moteino in between.
+// Received packets are printed as "[id] payload SS:rssi" (like the PiGateway sketch), ACKs
+// are sent when requested. DIO0 edges come from the GPIO character device and are
+// dispatched from the event loop (pollInterrupts), the process sleeps while idle.
+// With -e it runs against an emulated radio (Linux/Emulator.h) that receives a packet
+// from node 2 every second, no hardware needed.
+// Build: g++ -O2 -pthread -I../.. -o LinuxGateway LinuxGateway.cpp ../../RFM69.cpp ../../RFM69_ATC.cpp ../../Linux/*.cpp
+// Usage: LinuxGateway [-s /dev/spidev0.0] [-g /dev/gpiochip0] [-i 25] [-b 915] [-n 1] [-N 100] [-k key] [-H] [-e]
+//        -i is the GPIO line DIO0 is connected to, -H for RFM69HW/HCW
+// **********************************************************************************
+// Copyright LowPowerLab LLC 2018, https://www.LowPowerLab.com/contact
+// **********************************************************************************
+// License
+// **********************************************************************************
+// This program is free software; you can redistribute it
+// and/or modify it under the terms of the GNU General
+// Public License as published by the Free Software
+// Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will
+// be useful, but WITHOUT ANY WARRANTY; without even the
+// implied warranty of MERCHANTABILITY or FITNESS FOR A
+// PARTICULAR PURPOSE. See the GNU General Public
+// License for more details.
+//
+// Licence can be viewed at
+// http://www.gnu.org/licenses/gpl-3.0.txt
+//
+// Please maintain this license information along with authorship
+// and copyright notices in any redistribution of this code
+// **********************************************************************************
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <RFM69.h>
+#include <RFM69_ATC.h>
+#include "Linux/Emulator.h"
+
+static int bandConstant(int mhz)
+{
+  switch (mhz) {
+    case 315: return RF69_315MHZ;
+    case 433: return RF69_433MHZ;
+    case 868: return RF69_868MHZ;
+    default:  return RF69_915MHZ;
+  }
+}
+
+static void usage(const char* prog)
+{
+  fprintf(stderr, "Usage: %s [-s spidev] [-g gpiochip] [-i irq line] [-b 315|433|868|915] [-n node id] [-N network id] [-k key] [-H] [-e]\n", prog);
+}
+
+int main(int argc, char** argv)
+{
+  const char* spidev = "/dev/spidev0.0";
+  const char* gpiochip = "/dev/gpiochip0";
+  uint8_t irqPin = 25;
+  int band = 915;
+  uint16_t nodeId = 1;
+  uint8_t networkId = 100;
+  const char* key = NULL;
+  bool highPower = false;
+  bool emulated = false;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "s:g:i:b:n:N:k:He")) != -1) {
+    switch (opt) {
+      case 's': spidev = optarg; break;
+      case 'g': gpiochip = optarg; break;
+      case 'i': irqPin = atoi(optarg); break;
+      case 'b': band = atoi(optarg); break;
+      case 'n': nodeId = atoi(optarg); break;
+      case 'N': networkId = atoi(optarg); break;
+      case 'k': key = optarg; break;
+      case 'H': highPower = true; break;
+      case 'e': emulated = true; break;
+      default: usage(argv[0]); return 2;
+    }
+  }
+  if (key && strlen(key) != 16) { fprintf(stderr, "the key must be 16 characters\n"); return 2; }
+
+  SPIClass spi(spidev);
+  RFM69Emulator emulator;
+  if (emulated) {
+    if (!emulator.attach(spi, irqPin)) { perror("emulator"); return 1; }
+  }
+  else if (!gpioOpenChip(gpiochip)) return 1;
+
+  RFM69_ATC radio(SS, irqPin, highPower, &spi);
+  if (!radio.initialize(bandConstant(band), nodeId, networkId)) {
+    fprintf(stderr, "RFM69 not found\n");
+    return 1;
+  }
+  if (highPower) radio.setHighPower();
+  radio.encrypt(key);
+  setvbuf(stdout, NULL, _IOLBF, 0);
+  printf("GATEWAYSTART\nSYSFREQ:%u\n", radio.getFrequency());
+
+  uint32_t nextInjection = millis();
+  uint16_t count = 0;
+  while (true) {
+    if (emulated && millis() - nextInjection < 0x80000000UL) {
+      char msg[20];
+      int len = snprintf(msg, sizeof(msg), "emulated #%u", ++count);
+      emulator.injectPacket(2, nodeId, msg, len, true, -40 - count % 50);
+      nextInjection += 1000;
+    }
+
+    if (radio.receiveDone()) {
+      printf("[%u] %s SS:%d\n", radio.SENDERID, (char*)radio.DATA, radio.RSSI);
+      if (radio.ACKRequested()) radio.sendACK();
+    }
+    else pollInterrupts(emulated ? 10 : 1000); // sleep until DIO0 rises
+  }
+}
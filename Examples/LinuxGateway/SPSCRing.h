@@ -0,0 +1,95 @@
+// **********************************************************************************
+// Bounded single producer/single consumer ring buffer and an eventfd doorbell, used to
+// connect the GatewayDaemon stages. push() and pop() never block or take a lock, so a
+// producer (the radio service thread) is never held up by a slow consumer: when the ring
+// is full push() fails and the producer decides (drop and count, or retry later).
+// **********************************************************************************
+// Copyright LowPowerLab LLC 2018, https://www.LowPowerLab.com/contact
+// **********************************************************************************
+// License
+// **********************************************************************************
+// This program is free software; you can redistribute it
+// and/or modify it under the terms of the GNU General
+// Public License as published by the Free Software
+// Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will
+// be useful, but WITHOUT ANY WARRANTY; without even the
+// implied warranty of MERCHANTABILITY or FITNESS FOR A
+// PARTICULAR PURPOSE. See the GNU General Public
+// License for more details.
+//
+// Licence can be viewed at
+// http://www.gnu.org/licenses/gpl-3.0.txt
+//
+// Please maintain this license information along with authorship
+// and copyright notices in any redistribution of this code
+// **********************************************************************************
+#ifndef SPSCRING_h
+#define SPSCRING_h
+#include <stdint.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include <atomic>
+
+// N must be a power of 2, one slot is never used so a ring holds N-1 items
+template <class T, uint32_t N>
+class SPSCRing {
+  public:
+    SPSCRing() : _head(0), _tail(0), _maxDepth(0), _drops(0) {}
+
+    bool push(const T& item) // producer thread only
+    {
+      uint32_t head = _head.load(std::memory_order_relaxed);
+      uint32_t next = (head + 1) & (N - 1);
+      if (next == _tail.load(std::memory_order_acquire)) { _drops++; return false; }
+      _items[head] = item;
+      _head.store(next, std::memory_order_release);
+      uint32_t depth = (next - _tail.load(std::memory_order_relaxed)) & (N - 1);
+      if (depth > _maxDepth.load(std::memory_order_relaxed)) _maxDepth.store(depth, std::memory_order_relaxed);
+      return true;
+    }
+
+    bool pop(T& item) // consumer thread only
+    {
+      uint32_t tail = _tail.load(std::memory_order_relaxed);
+      if (tail == _head.load(std::memory_order_acquire)) return false;
+      item = _items[tail];
+      _tail.store((tail + 1) & (N - 1), std::memory_order_release);
+      return true;
+    }
+
+    uint32_t depth() { return (_head.load(std::memory_order_acquire) - _tail.load(std::memory_order_acquire)) & (N - 1); }
+    uint32_t maxDepth() { return _maxDepth.exchange(0); } // since the last call
+    uint32_t drops() { return _drops.load(); }             // pushes refused because the ring was full
+    static uint32_t capacity() { return N - 1; }
+
+  private:
+    T _items[N];
+    std::atomic<uint32_t> _head; // next slot to write, owned by the producer
+    std::atomic<uint32_t> _tail; // next slot to read, owned by the consumer
+    std::atomic<uint32_t> _maxDepth;
+    std::atomic<uint32_t> _drops;
+};
+
+// wakes a consumer blocked in wait()/poll() on fd(); ring() is a non blocking write
+class Doorbell {
+  public:
+    Doorbell() : _fd(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) {}
+    ~Doorbell() { close(_fd); }
+    int fd() { return _fd; }
+    void ring() { uint64_t one = 1; if (write(_fd, &one, sizeof(one)) < 0) return; }
+    void clear() { uint64_t count; if (read(_fd, &count, sizeof(count)) < 0) return; }
+    void wait(int timeoutMs)
+    {
+      struct pollfd pfd = { _fd, POLLIN, 0 };
+      if (poll(&pfd, 1, timeoutMs) > 0) clear();
+    }
+
+  private:
+    int _fd;
+};
+
+#endif
@@ -127,8 +127,6 @@ void sleep(uint32_t sleepTime) {
   }
   else
   { //sleeps MCU using the radio timer - should not be used if radio needs to be in RX mode!
-    uint32_t freq = radio.getFrequency();
-    
     uint32_t remainingSleepTime = sleepTime;
 
     while (remainingSleepTime) { //split into sleep(60s) calls if > 60s sleep
@@ -150,20 +148,15 @@ void sleep(uint32_t sleepTime) {
         listenModeSleep(sleepTime);
       }
   
-      //WAKEUP happens here (must reinit!)
-      radio.RFM69::initialize(FREQUENCY,NODEID,NETWORKID); //call base init!
-      #ifdef ENCRYPTKEY
-        radio.encrypt(ENCRYPTKEY);
-      #endif
-      radio.setFrequency(freq);
+      //WAKEUP happens here, endListenModeSleep() restored the radio settings
     }
   }
 }
 
 void listenModeSleep(uint16_t millisInterval) {
   radio.listenModeSleep(millisInterval);
-  LowPower.powerDown( SLEEP_FOREVER, ADC_OFF, BOD_OFF );
-  LowPower.powerDown( SLEEP_FOREVER, ADC_OFF, BOD_OFF );
-  LowPower.powerDown( SLEEP_FOREVER, ADC_OFF, BOD_OFF );
+  //the radio timer wakes the MCU more than once, sleep again until the interval is over
+  while (!radio.listenModeSleepDone())
+    LowPower.powerDown( SLEEP_FOREVER, ADC_OFF, BOD_OFF );
   radio.endListenModeSleep();
 }
\ No newline at end of file
@@ -238,6 +238,12 @@ void refreshLCD() {
   //u8glib picture loop
   lcd.firstPage();
   do {
+    //serve the radio between pages so a refresh doesn't hold ACKs for tens of ms
+    digitalWrite(PIN_LCD_CS, HIGH);
+    interrupts();
+    radio.process();
+    noInterrupts();
+
     lcd.setFont(u8g_font_profont10);
     lcd.setFontRefHeightText();
     lcd.setFontPosTop();
@@ -655,6 +661,8 @@ void setup() {
   LED_HIGH;
 
   radio.initialize(FREQUENCY,NODEID,NETWORKID);
+  radio.onPacket(onRadioPacket);
+  radio.keepReceiving();
 #ifdef ENCRYPTKEY
   radio.encrypt(ENCRYPTKEY);
 #endif
@@ -688,61 +696,64 @@ void setup() {
 }
 
 boolean newPacketReceived;
-void loop() {
-  handlePowerControl(); //checks any button presses and takes action
-  handle2Buttons();     //checks the general purpose buttons next to the LCD (R2+)
-  handleSerialData();   //checks for any serial input from the Pi computer
 
-  //process any received radio packets
-  if (radio.receiveDone())
+//called by radio.process() for every received data packet
+void onRadioPacket(RFM69& r, const RFM69_Packet& packet, void* context) {
+  LED_HIGH;
+  rssi = packet.rssi; //get this asap from transceiver
+  if (packet.dataLen > 0) //data packets have a payload
   {
-    LED_HIGH;
-    rssi = radio.RSSI; //get this asap from transceiver
-    if (radio.DATALEN > 0) //data packets have a payload
-    {
-      for (byte i=9;i<radio.DATALEN;i++) {
-        if (radio.DATA[i]=='\n' || radio.DATA[i]=='\r')
-          radio.DATA[i]=' '; //remove any newlines in the payload - this should only ever happen with noise data that actually made it through
-      }
-      Pbuff="";
-      Pbuff << '[' << radio.SENDERID << "] " << (char*)radio.DATA;
-      Serial << buff << F(" SS:") << rssi << endl; //this passes data to MightyHat / RaspberryPi
+    for (byte i=9;i<radio.DATALEN;i++) {
+      if (radio.DATA[i]=='\n' || radio.DATA[i]=='\r')
+        radio.DATA[i]=' '; //remove any newlines in the payload - this should only ever happen with noise data that actually made it through
+    }
+    Pbuff="";
+    Pbuff << '[' << packet.senderId << "] " << (char*)radio.DATA;
+    Serial << buff << F(" SS:") << rssi << endl; //this passes data to MightyHat / RaspberryPi
 #ifdef ENABLE_LCD
-      saveToHistory(buff, rssi);
+    saveToHistory(buff, rssi);
 #endif
-    }
+  }
 
-    //check if the packet is a wireless programming request
+  //check if the packet is a wireless programming request
 #ifdef ENABLE_WIRELESS_PROGRAMMING
-    CheckForWirelessHEX(radio, flash, false); //non verbose DEBUG
+  CheckForWirelessHEX(radio, flash, false); //non verbose DEBUG
 #endif
 
-    //respond to any ACK if requested
-    if (radio.ACKRequested())
-    {
-      REQUEST* aux=queue;
-      Pbuff="";
-      //walk queue and add pending commands to ACK payload (as many it can fit)
-      while (aux!=NULL) {
-        if (aux->nodeId==radio.SENDERID)
+  //respond to any ACK if requested
+  if (packet.ackRequested)
+  {
+    REQUEST* aux=queue;
+    Pbuff="";
+    //walk queue and add pending commands to ACK payload (as many it can fit)
+    while (aux!=NULL) {
+      if (aux->nodeId==packet.senderId)
+      {
+        //check if payload has room to add this queued command
+        if (Pbuff.length() + 1 + strlen(aux->data) <= MAX_ACK_REQUEST_LENGTH)
         {
-          //check if payload has room to add this queued command
-          if (Pbuff.length() + 1 + strlen(aux->data) <= MAX_ACK_REQUEST_LENGTH)
-          {
-            if (Pbuff.length()) Pbuff.print(' '); //prefix with a space any previous command in buffer
-            Pbuff.print(aux->data); //append command
-          }
+          if (Pbuff.length()) Pbuff.print(' '); //prefix with a space any previous command in buffer
+          Pbuff.print(aux->data); //append command
         }
-        aux=aux->next;
       }
-      if (Pbuff.length())
-        radio.sendACK(buff, Pbuff.length());
-      else
-        radio.sendACK();
+      aux=aux->next;
     }
-    LED_LOW;
-    newPacketReceived = true;
+    if (Pbuff.length())
+      radio.sendACK(buff, Pbuff.length());
+    else
+      radio.sendACK();
   }
+  LED_LOW;
+  newPacketReceived = true;
+}
+
+void loop() {
+  handlePowerControl(); //checks any button presses and takes action
+  handle2Buttons();     //checks the general purpose buttons next to the LCD (R2+)
+  handleSerialData();   //checks for any serial input from the Pi computer
+
+  //process any received radio packets, see onRadioPacket()
+  radio.process();
 
   readBattery();
 
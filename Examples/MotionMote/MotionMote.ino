@@ -227,7 +227,6 @@ void sleep(uint32_t sleepTime) {
   if (sleepTime < 262) { //sleeps just the MCU, using WDT (radio is not touched)
     longPowerDown(sleepTime);
   } else { //sleeps MCU using the radio timer - should not be used if radio needs to be in RX mode!
-    uint32_t freq = radio.getFrequency();
     if (sleepTime%262 && sleepTime > 262*2) {
       DEBUG("Sleeping "); DEBUGln(sleepTime-sleepTime%262-262); DEBUGFlush();
       listenModeSleep(sleepTime-sleepTime%262-262);
@@ -238,20 +237,15 @@ void sleep(uint32_t sleepTime) {
       listenModeSleep(sleepTime);
     }
 
-    //WAKEUP happens here (must reinit!)
-    radio.RFM69::initialize(FREQUENCY,NODEID,NETWORKID); //call base init!
-    #ifdef ENCRYPTKEY
-      radio.encrypt(ENCRYPTKEY);
-    #endif
-    radio.setFrequency(freq);
+    //WAKEUP happens here, endListenModeSleep() restored the radio settings
   }
 }
 
 void listenModeSleep(uint16_t millisInterval) {
   radio.listenModeSleep(millisInterval);
-  LowPower.powerDown( SLEEP_FOREVER, ADC_OFF, BOD_OFF );
-  LowPower.powerDown( SLEEP_FOREVER, ADC_OFF, BOD_OFF );
-  LowPower.powerDown( SLEEP_FOREVER, ADC_OFF, BOD_OFF );
+  //the radio timer wakes the MCU more than once, sleep again until the interval is over (or motion)
+  while (!radio.listenModeSleepDone() && !motionDetected)
+    LowPower.powerDown( SLEEP_FOREVER, ADC_OFF, BOD_OFF );
   radio.endListenModeSleep();
 }
 
@@ -0,0 +1,112 @@
+// **********************************************************************************
+// Linux host side of the PiGateway binary serial protocol (SERIAL_BINARY, see RFM69_Frame.h)
+// **********************************************************************************
+// Copyright LowPowerLab LLC 2018, https://www.LowPowerLab.com/contact
+// **********************************************************************************
+// License
+// **********************************************************************************
+// This program is free software; you can redistribute it
+// and/or modify it under the terms of the GNU General
+// Public License as published by the Free Software
+// Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will
+// be useful, but WITHOUT ANY WARRANTY; without even the
+// implied warranty of MERCHANTABILITY or FITNESS FOR A
+// PARTICULAR PURPOSE. See the GNU General Public
+// License for more details.
+//
+// Licence can be viewed at
+// http://www.gnu.org/licenses/gpl-3.0.txt
+//
+// Please maintain this license information along with authorship
+// and copyright notices in any redistribution of this code
+// **********************************************************************************
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdio.h>
+#include <termios.h>
+#include <unistd.h>
+#include <string>
+#include "GatewayHost.h"
+
+static speed_t baudConstant(long baud)
+{
+  switch (baud) {
+    case 9600:   return B9600;
+    case 19200:  return B19200;
+    case 38400:  return B38400;
+    case 57600:  return B57600;
+    case 230400: return B230400;
+    case 460800: return B460800;
+    case 921600: return B921600;
+    default:     return B115200;
+  }
+}
+
+bool GatewayHost::open(const char* device, long baud)
+{
+  close();
+  _fd = ::open(device, O_RDWR | O_NOCTTY);
+  if (_fd < 0) { perror(device); return false; }
+  struct termios tty;
+  if (tcgetattr(_fd, &tty) == 0) //a pty accepts these too, a pipe does not - that's fine
+  {
+    cfmakeraw(&tty);
+    cfsetispeed(&tty, baudConstant(baud));
+    cfsetospeed(&tty, baudConstant(baud));
+    tty.c_cflag |= CLOCAL | CREAD;
+    tty.c_cc[VMIN] = 0;
+    tty.c_cc[VTIME] = 0;
+    tcsetattr(_fd, TCSANOW, &tty);
+    tcflush(_fd, TCIOFLUSH);
+  }
+  decoder.reset();
+  return true;
+}
+
+void GatewayHost::close()
+{
+  if (_fd >= 0) ::close(_fd);
+  _fd = -1;
+}
+
+bool GatewayHost::sendLine(const char* line)
+{
+  if (_fd < 0) return false;
+  std::string out = std::string(line) + "\n"; //one write so the line is not split
+  const char* p = out.data();
+  size_t length = out.size();
+  while (length) {
+    ssize_t n = write(_fd, p, length);
+    if (n < 0) { if (errno == EINTR) continue; perror("write"); return false; }
+    p += n; length -= n;
+  }
+  return true;
+}
+
+int GatewayHost::process(int timeoutMs, FrameHandler handler, void* context)
+{
+  if (_fd < 0) return -1;
+  struct pollfd pfd = { _fd, POLLIN, 0 };
+  int ready = poll(&pfd, 1, timeoutMs);
+  if (ready < 0) return errno == EINTR ? 0 : -1;
+  if (ready == 0) return 0;
+  if (!(pfd.revents & POLLIN)) return -1; // hangup/error without data
+
+  uint8_t buf[512];
+  ssize_t n = read(_fd, buf, sizeof(buf));
+  if (n < 0) return (errno == EINTR || errno == EAGAIN) ? 0 : -1;
+  if (n == 0) return -1;
+
+  int frames = 0;
+  for (ssize_t i = 0; i < n; i++)
+    if (decoder.feed(buf[i]))
+    {
+      frames++;
+      if (handler) handler(decoder.header(), decoder.payload(), context);
+    }
+  return frames;
+}
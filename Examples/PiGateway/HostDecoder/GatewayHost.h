@@ -0,0 +1,57 @@
+// **********************************************************************************
+// Linux host side of the PiGateway binary serial protocol (SERIAL_BINARY, see RFM69_Frame.h)
+// Opens the gateway's serial port, decodes frames as bytes arrive and hands every
+// packet/text frame to a callback. Host commands ("123:MESSAGE", "RQ:123:MESSAGE", "FREERAM"...)
+// are still sent to the gateway as text lines.
+// Link with RFM69_Frame.cpp from the library root, see HostDecoder.cpp for an example.
+// **********************************************************************************
+// Copyright LowPowerLab LLC 2018, https://www.LowPowerLab.com/contact
+// **********************************************************************************
+// License
+// **********************************************************************************
+// This program is free software; you can redistribute it
+// and/or modify it under the terms of the GNU General
+// Public License as published by the Free Software
+// Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will
+// be useful, but WITHOUT ANY WARRANTY; without even the
+// implied warranty of MERCHANTABILITY or FITNESS FOR A
+// PARTICULAR PURPOSE. See the GNU General Public
+// License for more details.
+//
+// Licence can be viewed at
+// http://www.gnu.org/licenses/gpl-3.0.txt
+//
+// Please maintain this license information along with authorship
+// and copyright notices in any redistribution of this code
+// **********************************************************************************
+#ifndef GATEWAYHOST_h
+#define GATEWAYHOST_h
+#include <stdint.h>
+#include "RFM69_Frame.h"
+
+class GatewayHost {
+  public:
+    typedef void (*FrameHandler)(const RFM69_FrameHeader& header, const uint8_t* payload, void* context);
+
+    GatewayHost() : _fd(-1) {}
+    ~GatewayHost() { close(); }
+
+    bool open(const char* device, long baud=115200); // any tty works, including a pty connected to an emulated gateway
+    void close();
+    int fd() { return _fd; } // to poll() it together with other descriptors
+
+    bool sendLine(const char* line); // \n is appended
+    // waits up to timeoutMs for data, then decodes everything available and calls handler for each valid frame
+    // returns the # of frames handled, -1 when the port was closed or failed
+    int process(int timeoutMs, FrameHandler handler, void* context=0);
+
+    RFM69_FrameDecoder decoder; // frames/crcErrors/overruns counters
+
+  protected:
+    int _fd;
+};
+
+#endif
@@ -0,0 +1,137 @@
+// **********************************************************************************
+// Prints the packets forwarded by a PiGateway built with SERIAL_BINARY
+// Packets are printed in the text format of the regular gateway sketches ("[id] payload SS:rssi")
+// with non printable payload bytes escaped as \xNN, or as hex with -x. Text frames (gateway
+// replies, debug output) are printed as is. Lines typed on stdin are sent to the gateway, so
+// commands like "123:MESSAGE" or "FREERAM" work as with the text protocol.
+// Build: g++ -O2 -I../../.. -o HostDecoder HostDecoder.cpp GatewayHost.cpp ../../../RFM69_Frame.cpp
+// Usage: HostDecoder -d /dev/ttyAMA0 [-b 115200] [-x] [-s]
+//        -s prints the frame/error counters and packets per second every 10 seconds
+// **********************************************************************************
+// Copyright LowPowerLab LLC 2018, https://www.LowPowerLab.com/contact
+// **********************************************************************************
+// License
+// **********************************************************************************
+// This program is free software; you can redistribute it
+// and/or modify it under the terms of the GNU General
+// Public License as published by the Free Software
+// Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will
+// be useful, but WITHOUT ANY WARRANTY; without even the
+// implied warranty of MERCHANTABILITY or FITNESS FOR A
+// PARTICULAR PURPOSE. See the GNU General Public
+// License for more details.
+//
+// Licence can be viewed at
+// http://www.gnu.org/licenses/gpl-3.0.txt
+//
+// Please maintain this license information along with authorship
+// and copyright notices in any redistribution of this code
+// **********************************************************************************
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <string>
+#include "GatewayHost.h"
+
+static bool hexPayload = false;
+static uint32_t packets = 0;
+
+static uint32_t nowMs()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000UL + ts.tv_nsec / 1000000UL;
+}
+
+static void printFrame(const RFM69_FrameHeader& header, const uint8_t* payload, void*)
+{
+  if (header.type == RFM69_FRAME_TEXT)
+  {
+    printf("%s\n", (const char*)payload);
+    return;
+  }
+  if (header.type != RFM69_FRAME_PACKET) return; // newer frame types
+
+  packets++;
+  printf("[%u] ", header.sender);
+  for (uint8_t i = 0; i < header.length; i++)
+  {
+    if (hexPayload) printf("%02X", payload[i]);
+    else if (payload[i] >= 0x20 && payload[i] < 0x7F && payload[i] != '\\') putchar(payload[i]);
+    else printf("\\x%02X", payload[i]);
+  }
+  printf(" SS:%d%s\n", header.rssi, (header.flags & RFM69_FRAME_ACKREQ) ? " ACKREQ" : "");
+}
+
+static void usage(const char* prog)
+{
+  fprintf(stderr, "Usage: %s -d <serial device> [-b <baud>] [-x] [-s]\n", prog);
+}
+
+int main(int argc, char** argv)
+{
+  const char* device = NULL;
+  long baud = 115200;
+  bool stats = false;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "d:b:xs")) != -1) {
+    switch (opt) {
+      case 'd': device = optarg; break;
+      case 'b': baud = atol(optarg); break;
+      case 'x': hexPayload = true; break;
+      case 's': stats = true; break;
+      default: usage(argv[0]); return 2;
+    }
+  }
+  if (!device) { usage(argv[0]); return 2; }
+
+  GatewayHost gateway;
+  if (!gateway.open(device, baud)) return 1;
+  setvbuf(stdout, NULL, _IOLBF, 0);
+
+  std::string command;
+  bool stdinOpen = true;
+  uint32_t lastStats = nowMs();
+  uint32_t lastPackets = 0;
+  while (true) {
+    if (stdinOpen)
+    {
+      struct pollfd pfd = { STDIN_FILENO, POLLIN, 0 };
+      if (poll(&pfd, 1, 0) > 0)
+      {
+        char buf[256];
+        ssize_t n = read(STDIN_FILENO, buf, sizeof(buf));
+        if (n <= 0) stdinOpen = false;
+        for (ssize_t i = 0; i < n; i++)
+        {
+          if (buf[i] == '\r') continue;
+          if (buf[i] != '\n') { command += buf[i]; continue; }
+          if (!command.empty() && !gateway.sendLine(command.c_str())) return 1;
+          command.clear();
+        }
+      }
+    }
+
+    if (gateway.process(stdinOpen ? 20 : 1000, printFrame) < 0)
+    {
+      fprintf(stderr, "%s: closed\n", device);
+      return 1;
+    }
+
+    if (stats && nowMs() - lastStats >= 10000)
+    {
+      uint32_t elapsed = nowMs() - lastStats;
+      fprintf(stderr, "frames:%u crcErrors:%u overruns:%u packets/s:%.1f\n", gateway.decoder.frames,
+              gateway.decoder.crcErrors, gateway.decoder.overruns, (packets - lastPackets) * 1000.0 / elapsed);
+      lastStats += elapsed;
+      lastPackets = packets;
+    }
+  }
+}
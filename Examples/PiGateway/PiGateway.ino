@@ -4,6 +4,8 @@
 // This is a buffered gateway sketch that receives packets from end node Moteinos, formats them as ASCII strings
 //      with the end node [ID] and passes them to Pi/host computer via serial port
 //     (ex: "messageFromNode" from node 123 gets passed to serial as "[123] messageFromNode")
+//     With SERIAL_BINARY defined, packets and all other output are sent as binary frames instead (see RFM69_Frame.h),
+//     which carry any payload byte unchanged and need about half the bytes; decode them with HostDecoder on the host
 // It also listens to serial messages that should be sent to listening end nodes
 //     (ex: "123:messageToNode" sends "messageToNode" to node 123)
 // Make sure to adjust the settings to match your transceiver settings (frequency, HW etc).
@@ -13,8 +15,10 @@
 #include <RFM69.h>      //get it here: https://github.com/lowpowerlab/rfm69
 #include <RFM69_ATC.h>  //get it here: https://github.com/lowpowerlab/RFM69
 #include <RFM69_OTA.h>  //get it here: https://github.com/lowpowerlab/RFM69
+#include <RFM69_Queue.h> //get it here: https://github.com/lowpowerlab/RFM69
+#include <RFM69_Poll.h>  //get it here: https://github.com/lowpowerlab/RFM69
+#include <RFM69_Frame.h> //get it here: https://github.com/lowpowerlab/RFM69
 #include <SPIFlash.h>   //get it here: https://github.com/lowpowerlab/spiflash
-#include <PString.h>    //easy string manipulator: http://arduiniana.org/libraries/pstring/
 #include <Streaming.h>  //easy C++ style output operators: http://arduiniana.org/libraries/streaming/
 //****************************************************************************************************************
 //**** IMPORTANT RADIO SETTINGS - YOU MUST CHANGE/CONFIGURE TO MATCH YOUR HARDWARE TRANSCEIVER CONFIGURATION! ****
@@ -30,42 +34,46 @@
 //*****************************************************************************************************************************
 #define DEBUG_EN            //comment out if you don't want any serial verbose output
 #define SERIAL_BAUD   115200 // Serial baud rate must match your Pi/host computer serial port baud rate!
+//#define SERIAL_BINARY       //uncomment to send binary frames to the host instead of text lines
 //*****************************************************************************************************************************
+#ifdef SERIAL_BINARY
+  RFM69_FrameWriter host(Serial); //text output is sent as one RFM69_FRAME_TEXT frame per line
+  #define HOST host
+#else
+  #define HOST Serial
+#endif
+
 #ifdef DEBUG_EN
-  #define DEBUG(input)   Serial.print(input)
-  #define DEBUGln(input) Serial.println(input)
+  #define DEBUG(input)   HOST.print(input)
+  #define DEBUGln(input) HOST.println(input)
 #else
   #define DEBUG(input)
   #define DEBUGln(input)
 #endif
 
-#define PRINT_UPTIME Serial<< F("UPTIME:") << millis() << endl;
-#define PRINT_FREQUENCY Serial << F("SYSFREQ:") << radio.getFrequency() << endl;
+#define PRINT_UPTIME HOST << F("UPTIME:") << millis() << endl;
+#define PRINT_FREQUENCY HOST << F("SYSFREQ:") << radio.getFrequency() << endl;
 
 #define LED_HIGH digitalWrite(LED_BUILTIN, HIGH)
 #define LED_LOW digitalWrite(LED_BUILTIN, LOW)
 //******************************************** BEGIN ADVANCED variables ********************************************************************************
 #if defined(MOTEINO_M0) || defined(MOTEINO_MEGA)
   #define RAMSIZE 16384
+  #define QUEUE_CAPACITY 100 //# of pending commands, 64 bytes each
 #else
   #define RAMSIZE 2048
+  #define QUEUE_CAPACITY 8
 #endif
 
-#define MAX_BUFFER_LENGTH       61 //limit parameter update requests to 20 chars. ex: Parameter:LongRequest
+#define MAX_BUFFER_LENGTH       RFM69_QUEUE_DATALEN //limit parameter update requests to 20 chars. ex: Parameter:LongRequest
 #define MAX_ACK_REQUEST_LENGTH  30 //60 is max for ACK (with ATC enabled), but need to allow appending :OK and :INV to confirmations from node
+#define POLL_SLEEP_INTERVAL     60 //seconds polling nodes (RFM69_PollNode, see Poll_node) are told to sleep once their commands are delivered
 
-typedef struct req {
-  uint16_t nodeId;
-  char data[MAX_BUFFER_LENGTH]; //+1 for the null terminator
-  struct req *next;
-}REQUEST;
-
-//dynamically allocated queue (FIFO) data structure
-REQUEST* queue = NULL;
-byte size_of_queue = 0;
+//statically allocated queue (FIFO per node) of pending commands
+RFM69_Request queueSlots[QUEUE_CAPACITY];
+RFM69_Queue queue(queueSlots, QUEUE_CAPACITY);
 
 char buff[61]; //61 max payload for radio packets
-PString Pbuff(buff, sizeof(buff)); //easy string manipulator
 int rssi=0; //signed!
 //******************************************** END ADVANCED variables ********************************************************************************
 //******************************************** BEGIN GENERAL variables ********************************************************************************
@@ -75,6 +83,8 @@ int rssi=0; //signed!
   RFM69 radio;
 #endif
 
+RFM69_PollGateway poller(radio, queue, POLL_SLEEP_INTERVAL); //delivers queued commands in batches to nodes that poll on wake
+
 SPIFlash flash(SS_FLASHMEM, 0xEF30); //EF30 for 4mbit Windbond FlashMEM chip
 //******************************************** END GENERAL variables ********************************************************************************
 
@@ -99,7 +109,7 @@ void setup() {
   radio.setFrequency(FREQUENCY_EXACT); //set frequency to some custom frequency
 #endif
 
-  Serial << endl << "GATEWAYSTART" << endl;
+  HOST << endl << "GATEWAYSTART" << endl;
   PRINT_FREQUENCY;
   PRINT_UPTIME;
 
@@ -119,13 +129,22 @@ void loop() {
   {
     LED_HIGH;
     rssi = radio.RSSI; //get this asap from transceiver
+    //a polling node woke up: answer right away with its pending commands, the poll itself carries no data for the host
+    if (poller.reply()) {
+      LED_LOW;
+      return;
+    }
     if (radio.DATALEN > 0) //data packets have a payload
     {
+#ifdef SERIAL_BINARY
+      host.writePacket(radio.SENDERID, radio.TARGETID, rssi, radio.ACK_REQUESTED ? RFM69_FRAME_ACKREQ : 0, radio.DATA, radio.DATALEN);
+#else
       for (byte i=9;i<radio.DATALEN;i++) {
         if (radio.DATA[i]=='\n' || radio.DATA[i]=='\r')
           radio.DATA[i]=' '; //remove any newlines in the payload - this should only ever happen with noise data that actually made it through
       }
       Serial << F("[") << radio.SENDERID << F("] ") << (char*)radio.DATA << " SS:" << rssi << endl; //this passes data to host computer (Pi)
+#endif
     }
 
     //check if the packet is a wireless programming request
@@ -136,23 +155,10 @@ void loop() {
     //respond to any ACK if requested
     if (radio.ACKRequested())
     {
-      REQUEST* aux=queue;
-      Pbuff="";
-      //walk queue and add pending commands to ACK payload (as many it can fit)
-      while (aux!=NULL) {
-        if (aux->nodeId==radio.SENDERID)
-        {
-          //check if payload has room to add this queued command
-          if (Pbuff.length() + 1 + strlen(aux->data) <= MAX_ACK_REQUEST_LENGTH)
-          {
-            if (Pbuff.length()) Pbuff.print(' '); //prefix with a space any previous command in buffer
-            Pbuff.print(aux->data); //append command
-          }
-        }
-        aux=aux->next;
-      }
-      if (Pbuff.length())
-        radio.sendACK(buff, Pbuff.length());
+      //add this node's pending commands to ACK payload (as many it can fit)
+      byte len = queue.pack(radio.SENDERID, buff, MAX_ACK_REQUEST_LENGTH);
+      if (len)
+        radio.sendACK(buff, len);
       else
         radio.sendACK();
     }
@@ -160,22 +166,6 @@ void loop() {
   }
 }
 
-boolean insert(uint16_t new_id, char new_data[]) { 
-  REQUEST* aux;
-  REQUEST* new_node = (REQUEST*)malloc(sizeof(REQUEST));
-  if (new_node == NULL) return false;
-  new_node->nodeId = new_id; 
-  strcpy(new_node->data, new_data);
-  new_node->next = NULL;
-  if (queue == NULL) queue = new_node;
-  else {
-      aux = queue;
-      while(aux->next != NULL) aux=aux->next;
-      aux->next=new_node;
-  }
-  return true;
-}
-
 //processCommand - parse the command and send it to target
 //if target is non-responsive it(sleeppy node?) then queue command to send when target wakes and asks for an ACK
 //SPECIAL COMMANDS FROM HOST:
@@ -196,11 +186,11 @@ void processCommand(char data[], boolean allowDuplicate=false) {
   ptr = strtok(data, ":");
 
   if (strcmp(data, "FREERAM")==0)
-    Serial << F("FREERAM:") << freeRAM() << ':' << RAMSIZE << endl;
+    HOST << F("FREERAM:") << freeRAM() << ':' << RAMSIZE << endl;
   if (strcmp(data, "RQ")==0)
   {
     ptr = strtok(NULL, ":");  //move to next :
-    if (ptr == NULL) printQueue(queue);
+    if (ptr == NULL) printQueue();
     else isQueueRequest = true;
   }
   if (strcmp(data, "SYSFREQ")==0)
@@ -208,12 +198,12 @@ void processCommand(char data[], boolean allowDuplicate=false) {
   if (strcmp(data, "UPTIME")==0)
     PRINT_UPTIME;
   if (strcmp(data, "NETWORKID")==0)
-    Serial << F("NETWORKID:") << NETWORKID << endl;
+    HOST << F("NETWORKID:") << NETWORKID << endl;
   if (strcmp(data, "ENCRYPTKEY")==0)
 #ifdef ENCRYPTKEY
-    Serial << F("ENCRYPTKEY:") << ENCRYPTKEY << endl;
+    HOST << F("ENCRYPTKEY:") << ENCRYPTKEY << endl;
 #else
-    Serial << F("ENCRYPTKEY:NONE") << endl;
+    HOST << F("ENCRYPTKEY:NONE") << endl;
 #endif
 
   if(ptr != NULL) {                  // delimiter found, valid command
@@ -221,28 +211,9 @@ void processCommand(char data[], boolean allowDuplicate=false) {
 
     //if "RQ:VOID" then flush entire requst queue
     if (isQueueRequest && strcmp(dataPart, "VOID")==0) {
-      REQUEST* aux = queue;
-      byte removed=0;
-  
-      while(aux != NULL) {
-        if (aux == queue) {
-          if (aux->next == NULL) {
-            free(queue);
-            queue=NULL;
-            removed++;
-            break;
-          }
-          else {
-            queue = queue->next;
-            free(aux);
-            removed++;
-            aux = queue;
-            continue;
-          }
-        }
-      }
+      byte removed=queue.size();
+      queue.clear();
       DEBUG("DEBUG:VOIDED_commands:");DEBUGln(removed);
-      size_of_queue = size_of_queue - removed;
       return;
     }
 
@@ -255,7 +226,6 @@ void processCommand(char data[], boolean allowDuplicate=false) {
 
     //check target nodeID is valid
     if (targetId > 0 && targetId != NODEID && targetId<=1023) {
-      REQUEST* aux;
       byte removed=0;
 
       //check if VOID command - if YES then remove command(s) to that target nodeID
@@ -267,48 +237,8 @@ void processCommand(char data[], boolean allowDuplicate=false) {
         if (dataPart[4]==':' && strlen(dataPart)>5)
           removeAll=false;
 
-        //iterate over queue
-        aux = queue;
-        while(aux != NULL) {
-          if (aux->nodeId==targetId)
-          {
-            if (removeAll || (!removeAll && strcmp(aux->data, dataPart+5)==0))
-            {
-              if (aux == queue)
-              {
-                if (aux->next == NULL)
-                {
-                  free(queue);
-                  queue=NULL;
-                  removed++;
-                  break;
-                }
-                else
-                {
-                  queue = queue->next;
-                  free(aux);
-                  removed++;
-                  aux = queue;
-                  continue;
-                }
-              }
-              else
-              {
-                REQUEST* prev=queue;
-                while(prev->next != NULL && prev->next != aux) prev = prev->next; //find previous
-                if (prev->next == NULL) break;
-                prev->next=prev->next->next;
-                free(aux);
-                removed++;
-                aux=prev->next;
-              }
-            }
-            else aux=aux->next;
-          }
-          else aux=aux->next;
-        }
+        removed = queue.remove(targetId, removeAll ? NULL : dataPart+5);
         DEBUG("DEBUG:VOIDED_commands:");DEBUGln(removed);
-        size_of_queue = size_of_queue - removed;
         return;
       }
 
@@ -323,58 +253,34 @@ void processCommand(char data[], boolean allowDuplicate=false) {
 
       if (!isQueueRequest) return; //just return at this time if not queued request
 
-      //check for duplicate
-      if (!allowDuplicate) {
-        //walk queue and check for duplicates
-        aux = queue;
-        while(aux != NULL)
-        {
-          //DEBUGln("While");
-          if (aux->nodeId==targetId)
-          {
-            if (strcmp(aux->data, dataPart)==0)
-            {
-              DEBUGln(F("DEBUG:processCommand_skip_duplicate"));  
-              return;
-            }
-          }
-          aux = aux->next;
-        }
+      //check for duplicate (only among this node's queued commands)
+      if (!allowDuplicate && queue.contains(targetId, dataPart)) {
+        DEBUGln(F("DEBUG:processCommand_skip_duplicate"));  
+        return;
       }
 
       //all checks OK, attempt to add to queue
-      if (insert(targetId, dataPart))
-      {
-        //DEBUG(F("-> inserted: ")); 
-        //DEBUG(targetId);
-        //DEBUG("_");
-        //DEBUGln(dataPart);
-        size_of_queue++;
-      }
-      else
+      if (!queue.insert(targetId, dataPart))
       {
         DEBUGln(F("DEBUG:INSERT_FAIL:MEM_FULL"));
-        Serial << F("[") << targetId << F("] ") << dataPart << F(":MEMFULL") << endl;
+        HOST << F("[") << targetId << F("] ") << dataPart << F(":MEMFULL") << endl;
       }
     }
     else { 
       //DEBUG(F("DEBUG:INSERT_FAIL - INVALID nodeId:")); DEBUGln(targetId);
-      Serial<< '[' << targetId <<"] " << dataPart << F(":INV:ID-OUT-OF-RANGE") << endl;
+      HOST << '[' << targetId <<"] " << dataPart << F(":INV:ID-OUT-OF-RANGE") << endl;
     }
   }
 }
 
-void printQueue(REQUEST* p) {
-  if (!size_of_queue) {
-    Serial << F("RQ:EMPTY") << endl;
+void printQueue() {
+  if (!queue.size()) {
+    HOST << F("RQ:EMPTY") << endl;
     return;
   }
 
-  REQUEST* aux=p;
-  while (aux!=NULL) {
-    Serial << F("RQ:") << aux->nodeId << ':' << aux->data << endl;
-    aux=aux->next;
-  }
+  for (byte i = queue.firstAll(); i != RFM69_QUEUE_NONE; i = queue.nextAll(i))
+    HOST << F("RQ:") << queue.get(i).nodeId << ':' << queue.get(i).data << endl;
 }
 
 // here's the processing of single char/bytes as soon as they're coming from UART
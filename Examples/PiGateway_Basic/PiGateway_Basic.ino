@@ -3,6 +3,7 @@
 // This is a basic gateway sketch that receives packets from end node Moteinos, formats them as ASCII strings
 //      with the end node [ID] and passes them to Pi/host computer via serial port
 //     (ex: "messageFromNode" from node 123 gets passed to serial as "[123] messageFromNode")
+//     With SERIAL_BINARY defined, packets and all other output are sent as binary frames instead (see RFM69_Frame.h)
 // It also listens to serial messages that should be sent to listening end nodes
 //     (ex: "123:messageToNode" sends "messageToNode" to node 123)
 // Make sure to adjust the settings to match your transceiver settings (frequency, HW etc).
@@ -12,6 +13,7 @@
 #include <RFM69.h>         //get it here: https://github.com/lowpowerlab/rfm69
 #include <RFM69_ATC.h>     //get it here: https://github.com/lowpowerlab/RFM69
 #include <RFM69_OTA.h>     //get it here: https://github.com/lowpowerlab/RFM69
+#include <RFM69_Frame.h>   //get it here: https://github.com/lowpowerlab/RFM69
 #include <SPIFlash.h>      //get it here: https://github.com/lowpowerlab/spiflash
 //****************************************************************************************************************
 //**** IMPORTANT RADIO SETTINGS - YOU MUST CHANGE/CONFIGURE TO MATCH YOUR HARDWARE TRANSCEIVER CONFIGURATION! ****
@@ -29,10 +31,18 @@
 // Serial baud rate must match your Pi/host computer serial port baud rate!
 #define DEBUG_EN     //comment out if you don't want any serial verbose output
 #define SERIAL_BAUD   19200
+//#define SERIAL_BINARY       //uncomment to send binary frames to the host instead of text lines
 //*****************************************************************************************************************************
+#ifdef SERIAL_BINARY
+  RFM69_FrameWriter host(Serial); //text output is sent as one RFM69_FRAME_TEXT frame per line
+  #define HOST host
+#else
+  #define HOST Serial
+#endif
+
 #ifdef DEBUG_EN
-  #define DEBUG(input)   {Serial.print(input);}
-  #define DEBUGln(input) {Serial.println(input);}
+  #define DEBUG(input)   {HOST.print(input);}
+  #define DEBUGln(input) {HOST.println(input);}
 #else
   #define DEBUG(input);
   #define DEBUGln(input);
@@ -111,6 +121,9 @@ void loop() {
   {
     LED_HIGH;
     int rssi = radio.RSSI;
+#ifdef SERIAL_BINARY
+    host.writePacket(radio.SENDERID, radio.TARGETID, rssi, radio.ACK_REQUESTED ? RFM69_FRAME_ACKREQ : 0, radio.DATA, radio.DATALEN);
+#else
     Serial.print('[');Serial.print(radio.SENDERID);Serial.print("] ");
     if (radio.DATALEN > 0)
     {
@@ -119,6 +132,7 @@ void loop() {
       Serial.print("   [RSSI:");Serial.print(rssi);Serial.print(']');
     }
     Serial.println();
+#endif
     
     CheckForWirelessHEX(radio, flash, false); //non verbose DEBUG
 
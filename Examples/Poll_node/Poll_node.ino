@@ -0,0 +1,105 @@
+// **********************************************************************************
+// Polling Node RFM69 Example
+// Sleeps radio and MCU (radio listen mode timer), and on every wake polls the gateway
+// (RFM69_PollNode) for the commands queued for it, in batches until none are left, then
+// sleeps for as long as the gateway suggests. See PiGateway for the other side.
+// *** NOTE: This example is only applicable to AVR Moteinos, not SAMD Moteinos.  ***
+// **********************************************************************************
+// Copyright Felix Rusu 2018, http://www.LowPowerLab.com/contact
+// **********************************************************************************
+// License
+// **********************************************************************************
+// This program is free software; you can redistribute it 
+// and/or modify it under the terms of the GNU General    
+// Public License as published by the Free Software       
+// Foundation; either version 3 of the License, or        
+// (at your option) any later version.                    
+//                                                        
+// This program is distributed in the hope that it will   
+// be useful, but WITHOUT ANY WARRANTY; without even the  
+// implied warranty of MERCHANTABILITY or FITNESS FOR A   
+// PARTICULAR PURPOSE. See the GNU General Public        
+// License for more details.                              
+//                                                        
+// Licence can be viewed at                               
+// http://www.gnu.org/licenses/gpl-3.0.txt
+//
+// Please maintain this license information along with authorship
+// and copyright notices in any redistribution of this code
+#include <RFM69.h>            //get it here: https://www.github.com/lowpowerlab/rfm69
+#include <RFM69_ATC.h>        //get it here: https://www.github.com/lowpowerlab/rfm69
+#include <RFM69_Poll.h>       //get it here: https://www.github.com/lowpowerlab/rfm69
+#include <SPI.h>              //included with Arduino IDE install (www.arduino.cc)
+#include <LowPower.h>         //get library from: https://github.com/lowpowerlab/lowpower
+//*********************************************************************************************
+//************ IMPORTANT SETTINGS - YOU MUST CHANGE/CONFIGURE TO FIT YOUR HARDWARE *************
+//*********************************************************************************************
+#define NODEID      123
+#define NETWORKID   200
+#define GATEWAYID   1
+//Match frequency to the hardware version of the radio on your Moteino (uncomment one):
+//#define FREQUENCY     RF69_433MHZ
+//#define FREQUENCY     RF69_868MHZ
+#define FREQUENCY     RF69_915MHZ
+#define ENCRYPTKEY    "sampleEncryptKey" //has to be same 16 characters/bytes on all nodes, not more not less!
+#define IS_RFM69HW_HCW  //uncomment only for RFM69HW/HCW! Leave out if you have RFM69W/CW!
+//*********************************************************************************************
+#define ENABLE_ATC    //comment out this line to disable AUTO TRANSMISSION CONTROL
+//*********************************************************************************************
+#define SERIAL_BAUD   115200
+#define MAX_POLLS     10   //polls per wake, bounds the time awake if the gateway keeps queueing
+#define RETRY_SLEEP   30   //seconds to sleep when the gateway did not answer
+
+#ifdef ENABLE_ATC
+  RFM69_ATC radio;
+#else
+  RFM69 radio;
+#endif
+
+RFM69_PollNode poller(radio, GATEWAYID);
+
+void setup() {
+  Serial.begin(SERIAL_BAUD);
+  pinMode(LED_BUILTIN, OUTPUT);
+  radio.initialize(FREQUENCY,NODEID,NETWORKID);
+#ifdef IS_RFM69HW_HCW
+  radio.setHighPower(); //must include this only for RFM69HW/HCW!
+#endif
+  radio.encrypt(ENCRYPTKEY);
+#ifdef ENABLE_ATC
+  radio.enableAutoPower(-80);
+#endif
+}
+
+void handleCommand(const char* cmd) {
+  Serial.print("Command: ");Serial.println(cmd);
+  if (strcmp(cmd, "LED:ON") == 0) digitalWrite(LED_BUILTIN, HIGH);
+  else if (strcmp(cmd, "LED:OFF") == 0) digitalWrite(LED_BUILTIN, LOW);
+}
+
+// sleeps radio and MCU, in listen mode timer steps of up to 65s
+void sleepFor(uint32_t seconds) {
+  Serial.flush();
+  uint32_t ms = seconds * 1000;
+  while (ms) {
+    uint32_t step = ms > 65000 ? 65000 : ms;
+    radio.listenModeSleep(step);
+    while (!radio.listenModeSleepDone())
+      LowPower.powerDown(SLEEP_FOREVER, ADC_OFF, BOD_OFF);
+    radio.endListenModeSleep();
+    ms -= step;
+  }
+}
+
+void loop() {
+  uint16_t sleepInterval = RETRY_SLEEP;
+  for (uint8_t polls = 0; polls < MAX_POLLS; polls++) {
+    if (!poller.poll()) break; //gateway not heard (or not polling aware), try again later
+    sleepInterval = poller.sleepInterval();
+    while (const char* cmd = poller.next()) handleCommand(cmd);
+    if (!poller.more()) break;
+  }
+  radio.sleep();
+  Serial.print("Sleeping ");Serial.print(sleepInterval);Serial.println("s");
+  sleepFor(sleepInterval ? sleepInterval : 1);
+}
@@ -0,0 +1,91 @@
+// Benchmark of the RFM69_Queue pending command queue used by gateways
+// Fills the queue with commands spread over many node IDs, up to MAX_SLOTS which is sized
+// to what fits in RAM, and times insert, the ACK time lookup (pack) and removal at each
+// depth. The ACK lookup time should stay flat as the queue grows.
+// **********************************************************************************
+// Copyright LowPowerLab LLC 2018, https://www.LowPowerLab.com/contact
+// **********************************************************************************
+// License
+// **********************************************************************************
+// This program is free software; you can redistribute it 
+// and/or modify it under the terms of the GNU General    
+// Public License as published by the Free Software       
+// Foundation; either version 3 of the License, or        
+// (at your option) any later version.                    
+//                                                        
+// This program is distributed in the hope that it will   
+// be useful, but WITHOUT ANY WARRANTY; without even the  
+// implied warranty of MERCHANTABILITY or FITNESS FOR A   
+// PARTICULAR PURPOSE. See the GNU General Public        
+// License for more details.                              
+//                                                        
+// Licence can be viewed at                               
+// http://www.gnu.org/licenses/gpl-3.0.txt
+//
+// Please maintain this license information along with authorship
+// and copyright notices in any redistribution of this code
+// **********************************************************************************
+#include <RFM69.h>         //get it here: https://github.com/lowpowerlab/rfm69
+#include <RFM69_Queue.h>   //get it here: https://github.com/lowpowerlab/rfm69
+
+#define SERIAL_BAUD   115200
+#define NODES         200  //commands are spread round robin over node IDs 2..NODES+1
+
+#if defined(MOTEINO_M0) || defined(MOTEINO_MEGA)
+  #define MAX_SLOTS   200
+#else
+  #define MAX_SLOTS   20   //20*64 bytes, the most that fits next to the core on a 2KB ATmega328p
+#endif
+
+RFM69_Request slots[MAX_SLOTS];
+char ackBuf[31];
+
+void setup() {
+  Serial.begin(SERIAL_BAUD);
+  delay(100);
+}
+
+void loop() {
+  uint8_t capacity = MAX_SLOTS;
+  RFM69_Queue queue(slots, capacity);
+
+  Serial.print(F("slots:")); Serial.print(capacity); Serial.print(F(" bytes:")); Serial.print(sizeof(slots));
+  Serial.print(F(" FREERAM:")); Serial.println(freeRAM());
+  Serial.println(F("depth\tinsert_us\tack_us\tremove_us"));
+  for (uint8_t depth = 1; depth <= capacity; depth++)
+  {
+    uint16_t nodeId = 2 + (depth-1) % NODES;
+    uint32_t start = micros();
+    queue.insert(nodeId, "CMD:ON");
+    uint32_t insertUs = micros() - start;
+
+    //worst case for the old linked list: the node whose commands were queued first
+    start = micros();
+    queue.pack(2, ackBuf, sizeof(ackBuf)-1);
+    uint32_t ackUs = micros() - start;
+
+    //remove and reinsert the newest command to time removal at this depth
+    start = micros();
+    queue.remove(nodeId, "CMD:ON");
+    uint32_t removeUs = micros() - start;
+    queue.insert(nodeId, "CMD:ON");
+
+    Serial.print(depth); Serial.print('\t'); Serial.print(insertUs); Serial.print('\t');
+    Serial.print(ackUs); Serial.print('\t'); Serial.println(removeUs);
+  }
+  Serial.println();
+  delay(10000);
+}
+
+//returns # of unfragmented free RAM bytes (free end of heap)
+extern "C" char *sbrk(int i);
+int freeRAM() {
+#ifdef __arm__
+  char top=0;
+  return &top - reinterpret_cast<char*>(sbrk(0));
+#else
+  extern int __heap_start, *__brkval; 
+  int v; 
+  return (int) &v - (__brkval == 0 ? (int) &__heap_start : (int) __brkval); 
+#endif
+}
@@ -0,0 +1,121 @@
+// **********************************************************************************
+// TDMA Node RFM69 Example
+// Follows the gateway beacons (RFM69_TDMANode): wakes up to hear each beacon, reports
+// once per superframe in its own slot and sleeps in between, radio and MCU, with the
+// radio's listen mode timer. See TDMA_gateway for the other side.
+// *** NOTE: This example is only applicable to AVR Moteinos, not SAMD Moteinos.  ***
+// **********************************************************************************
+// Copyright Felix Rusu 2018, http://www.LowPowerLab.com/contact
+// **********************************************************************************
+// License
+// **********************************************************************************
+// This program is free software; you can redistribute it 
+// and/or modify it under the terms of the GNU General    
+// Public License as published by the Free Software       
+// Foundation; either version 3 of the License, or        
+// (at your option) any later version.                    
+//                                                        
+// This program is distributed in the hope that it will   
+// be useful, but WITHOUT ANY WARRANTY; without even the  
+// implied warranty of MERCHANTABILITY or FITNESS FOR A   
+// PARTICULAR PURPOSE. See the GNU General Public        
+// License for more details.                              
+//                                                        
+// Licence can be viewed at                               
+// http://www.gnu.org/licenses/gpl-3.0.txt
+//
+// Please maintain this license information along with authorship
+// and copyright notices in any redistribution of this code
+// **********************************************************************************
+#include <RFM69.h>            //get it here: https://www.github.com/lowpowerlab/rfm69
+#include <RFM69_ATC.h>        //get it here: https://www.github.com/lowpowerlab/rfm69
+#include <RFM69_TDMA.h>       //get it here: https://www.github.com/lowpowerlab/rfm69
+#include <SPI.h>              //included with Arduino IDE install (www.arduino.cc)
+#include <LowPower.h>         //get library from: https://github.com/lowpowerlab/lowpower
+//*********************************************************************************************
+//************ IMPORTANT SETTINGS - YOU MUST CHANGE/CONFIGURE TO FIT YOUR HARDWARE *************
+//*********************************************************************************************
+#define NODEID      99
+#define NETWORKID   100
+//Match frequency to the hardware version of the radio on your Moteino (uncomment one):
+//#define FREQUENCY     RF69_433MHZ
+//#define FREQUENCY     RF69_868MHZ
+#define FREQUENCY     RF69_915MHZ
+#define ENCRYPTKEY    "sampleEncryptKey" //has to be same 16 characters/bytes on all nodes, not more not less!
+#define IS_RFM69HW_HCW  //uncomment only for RFM69HW/HCW! Leave out if you have RFM69W/CW!
+//*********************************************************************************************
+#define ENABLE_ATC    //comment out this line to disable AUTO TRANSMISSION CONTROL
+//*********************************************************************************************
+#define SERIAL_BAUD   115200
+#define SEARCH_TIME   5000 //ms to listen for a beacon when out of sync
+#define MIN_SLEEP     20   //shorter waits are spent awake (radio asleep)
+
+#ifdef ENABLE_ATC
+  RFM69_ATC radio;
+#else
+  RFM69 radio;
+#endif
+
+RFM69_TDMANode tdma(radio, NODEID);
+bool reported = false; //sent our reading in this superframe
+
+void setup() {
+  Serial.begin(SERIAL_BAUD);
+  radio.initialize(FREQUENCY,NODEID,NETWORKID);
+#ifdef IS_RFM69HW_HCW
+  radio.setHighPower(); //must include this only for RFM69HW/HCW!
+#endif
+  radio.encrypt(ENCRYPTKEY);
+#ifdef ENABLE_ATC
+  radio.enableAutoPower(-80);
+#endif
+  Serial.println("\nSearching for a beacon...");
+}
+
+// listens for up to ms, true when a beacon resynchronized us
+bool listenForBeacon(uint16_t ms) {
+  uint32_t start = millis();
+  while (millis() - start < ms)
+    if (radio.receiveDone() && tdma.receive()) return true;
+  return false;
+}
+
+// sleeps radio and MCU for ms, millis() doesn't run meanwhile so the scheduler is told
+void sleepFor(uint32_t ms) {
+  Serial.flush();
+  if (ms < MIN_SLEEP) {
+    radio.sleep();
+    delay(ms);
+    return;
+  }
+  if (ms > 65000) ms = 65000;
+  radio.listenModeSleep(ms);
+  while (!radio.listenModeSleepDone())
+    LowPower.powerDown(SLEEP_FOREVER, ADC_OFF, BOD_OFF);
+  radio.endListenModeSleep();
+  tdma.slept(ms);
+}
+
+void loop() {
+  if (!tdma.synced()) {
+    if (!listenForBeacon(SEARCH_TIME)) return;
+    Serial.print("Synced to gateway ");Serial.println(tdma.gateway());
+    reported = false;
+  }
+  else if (tdma.untilBeacon() == 0) {
+    if (listenForBeacon(tdma.beaconWindow())) reported = false;
+  }
+
+  if (!reported && tdma.untilSlot() == 0) {
+    char buff[20];
+    sprintf(buff, "up %lus", tdma.now() / 1000);
+    bool ok = tdma.send(buff, strlen(buff));
+    Serial.print(tdma.slot() < 0 ? "contention: " : "slot: ");
+    Serial.println(ok ? "ACK" : "no ACK");
+    reported = true; //once per superframe, a new slot comes with the next beacon
+  }
+
+  uint32_t wait = tdma.untilBeacon();
+  if (!reported && tdma.untilSlot() < wait) wait = tdma.untilSlot();
+  if (wait) sleepFor(wait);
+}
@@ -0,0 +1,302 @@
+// **********************************************************************************
+// Linux host side of the OTA wireless programming protocol
+// Reads an Intel HEX file and feeds it to a Moteino running the Programmer sketch over
+// its serial port. The Programmer then sends it wirelessly to the target node.
+// If the Programmer supports it (FLX?STREAM), records are pipelined: up to the window
+// reported by the Programmer are buffered on the Programmer MCU so the radio never waits
+// on the serial round trip. Older Programmer sketches fall back to one record per ACK.
+// Build: g++ -O2 -o HostProgrammer HostProgrammer.cpp
+// Usage: HostProgrammer -d /dev/ttyUSB0 -t 123 -f sketch.hex [-b 115200] [-l] [-v]
+//        -l forces the legacy lockstep protocol, -v prints every serial line
+// Works against any tty, including a pty connected to an emulated Programmer.
+// **********************************************************************************
+// Copyright LowPowerLab LLC 2018, https://www.LowPowerLab.com/contact
+// **********************************************************************************
+// License
+// **********************************************************************************
+// This program is free software; you can redistribute it
+// and/or modify it under the terms of the GNU General
+// Public License as published by the Free Software
+// Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will
+// be useful, but WITHOUT ANY WARRANTY; without even the
+// implied warranty of MERCHANTABILITY or FITNESS FOR A
+// PARTICULAR PURPOSE. See the GNU General Public
+// License for more details.
+//
+// Licence can be viewed at
+// http://www.gnu.org/licenses/gpl-3.0.txt
+//
+// Please maintain this license information along with authorship
+// and copyright notices in any redistribution of this code
+// **********************************************************************************
+#include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+#include <string>
+#include <vector>
+
+#define LINE_TIMEOUT_MS  5000 //no progress from the Programmer for this long aborts the transfer
+#define EOF_TIMEOUT_MS  10000 //the target may need a while to ACK FLX?EOF (retries + channel shift)
+
+static int fd = -1;
+static bool verbose = false;
+static std::string rxLine;
+
+static uint32_t nowMs()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000UL + ts.tv_nsec / 1000000UL;
+}
+
+static speed_t baudConstant(long baud)
+{
+  switch (baud) {
+    case 9600:   return B9600;
+    case 19200:  return B19200;
+    case 38400:  return B38400;
+    case 57600:  return B57600;
+    case 230400: return B230400;
+    case 460800: return B460800;
+    case 921600: return B921600;
+    default:     return B115200;
+  }
+}
+
+static bool openSerial(const char* device, long baud)
+{
+  fd = open(device, O_RDWR | O_NOCTTY);
+  if (fd < 0) { perror(device); return false; }
+  struct termios tty;
+  if (tcgetattr(fd, &tty) == 0) //a pty accepts these too, a pipe does not - that's fine
+  {
+    cfmakeraw(&tty);
+    cfsetispeed(&tty, baudConstant(baud));
+    cfsetospeed(&tty, baudConstant(baud));
+    tty.c_cflag |= CLOCAL | CREAD;
+    tty.c_cc[VMIN] = 0;
+    tty.c_cc[VTIME] = 0;
+    tcsetattr(fd, TCSANOW, &tty);
+    tcflush(fd, TCIOFLUSH);
+  }
+  return true;
+}
+
+static bool writeLine(const std::string& line)
+{
+  std::string out = line + "\n";
+  const char* p = out.data();
+  size_t left = out.size();
+  while (left) {
+    ssize_t n = write(fd, p, left);
+    if (n < 0) { if (errno == EINTR) continue; perror("write"); return false; }
+    p += n; left -= n;
+  }
+  if (verbose) printf("> %s\n", line.c_str());
+  return true;
+}
+
+// reads one \n terminated line from the Programmer, returns false on timeout
+static bool readLine(std::string& line, uint32_t timeoutMs)
+{
+  uint32_t start = nowMs();
+  while (1) {
+    size_t eol = rxLine.find('\n');
+    if (eol != std::string::npos) {
+      line = rxLine.substr(0, eol);
+      rxLine.erase(0, eol + 1);
+      if (!line.empty() && line[line.size()-1] == '\r') line.erase(line.size()-1);
+      if (line.empty()) continue;
+      if (verbose) printf("< %s\n", line.c_str());
+      return true;
+    }
+    uint32_t elapsed = nowMs() - start;
+    if (elapsed >= timeoutMs) return false;
+    struct pollfd pfd = { fd, POLLIN, 0 };
+    int r = poll(&pfd, 1, timeoutMs - elapsed);
+    if (r < 0 && errno != EINTR) { perror("poll"); return false; }
+    if (r > 0) {
+      char buf[256];
+      ssize_t n = read(fd, buf, sizeof(buf));
+      if (n > 0) rxLine.append(buf, n);
+      else if (n == 0 || (errno != EAGAIN && errno != EINTR)) return false;
+    }
+  }
+}
+
+static bool startsWith(const std::string& s, const char* prefix)
+{
+  return s.compare(0, strlen(prefix), prefix) == 0;
+}
+
+// CRC32 (IEEE 802.3), must match updateCRC32() in RFM69_OTA.cpp
+static uint32_t updateCRC32(uint32_t crc, uint8_t data)
+{
+  crc ^= data;
+  for (int i = 0; i < 8; i++)
+    crc = (crc >> 1) ^ (0xEDB88320UL & (0 - (crc & 1)));
+  return crc;
+}
+
+static uint8_t byteFromHex(const char* hex)
+{
+  char tmp[3] = { hex[0], hex[1], 0 };
+  return (uint8_t)strtoul(tmp, NULL, 16);
+}
+
+// loads the data records (type 00) of an Intel HEX file, returned without the leading ':'
+// the OTA protocol only carries data records, so they are also accumulated in the image CRC32
+static bool loadHEX(const char* path, std::vector<std::string>& records, uint32_t& imageCRC)
+{
+  FILE* f = fopen(path, "r");
+  if (!f) { perror(path); return false; }
+  char line[600];
+  uint32_t lineNo = 0;
+  imageCRC = 0xFFFFFFFF;
+  while (fgets(line, sizeof(line), f)) {
+    lineNo++;
+    size_t len = strcspn(line, "\r\n");
+    line[len] = 0;
+    if (len == 0) continue;
+    if (line[0] != ':' || len < 11 || (len - 1) % 2) {
+      fprintf(stderr, "%s:%u: not an Intel HEX record\n", path, lineNo);
+      fclose(f);
+      return false;
+    }
+    for (char* p = line + 1; *p; p++) *p = toupper(*p);
+    uint8_t dataLen = byteFromHex(line + 1);
+    uint8_t type = byteFromHex(line + 7);
+    if (len != 11 + dataLen * 2u) {
+      fprintf(stderr, "%s:%u: bad record length\n", path, lineNo);
+      fclose(f);
+      return false;
+    }
+    if (type == 0x00) {
+      for (uint8_t i = 0; i < dataLen; i++)
+        imageCRC = updateCRC32(imageCRC, byteFromHex(line + 9 + i * 2));
+      records.push_back(line + 1);
+    }
+    else if (type != 0x01 && type != 0x03 && type != 0x05)
+      fprintf(stderr, "%s:%u: warning, record type %02X is not supported by OTA, skipped\n", path, lineNo, type);
+  }
+  fclose(f);
+  imageCRC = ~imageCRC;
+  return true;
+}
+
+static void usage(const char* prog)
+{
+  fprintf(stderr, "Usage: %s -d <serial device> -t <target node id> -f <file.hex> [-b <baud>] [-l] [-v]\n", prog);
+}
+
+int main(int argc, char** argv)
+{
+  const char* device = NULL;
+  const char* hexFile = NULL;
+  long baud = 115200;
+  long target = 0;
+  bool legacy = false;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "d:t:f:b:lv")) != -1) {
+    switch (opt) {
+      case 'd': device = optarg; break;
+      case 't': target = atol(optarg); break;
+      case 'f': hexFile = optarg; break;
+      case 'b': baud = atol(optarg); break;
+      case 'l': legacy = true; break;
+      case 'v': verbose = true; break;
+      default: usage(argv[0]); return 2;
+    }
+  }
+  if (!device || !hexFile || target < 1 || target > 1023) { usage(argv[0]); return 2; }
+
+  std::vector<std::string> records;
+  uint32_t imageCRC;
+  if (!loadHEX(hexFile, records, imageCRC)) return 1;
+  if (records.empty()) { fprintf(stderr, "%s: no data records\n", hexFile); return 1; }
+  if (!openSerial(device, baud)) return 1;
+
+  std::string line;
+  char buf[64];
+
+  // opening the port may reset the Programmer, so retry the target selection until it answers
+  snprintf(buf, sizeof(buf), "TO:%ld", target);
+  std::string toOK = std::string(buf) + ":OK";
+  bool selected = false;
+  for (int attempt = 0; attempt < 5 && !selected; attempt++) {
+    if (!writeLine(buf)) return 1;
+    uint32_t start = nowMs();
+    while (!selected && nowMs() - start < 1000 && readLine(line, 1000 - (nowMs() - start)))
+      selected = line == toOK;
+  }
+  if (!selected) { fprintf(stderr, "Programmer did not answer %s\n", buf); return 1; }
+
+  // handshake, FLX?STREAM is answered with FLX?OK:STREAM:<window> or rejected by older Programmer sketches
+  unsigned window = 1;
+  bool stream = false;
+  bool handshake = false;
+  for (int pass = legacy ? 1 : 0; pass < 2 && !handshake; pass++) {
+    if (!writeLine(pass == 0 ? "FLX?STREAM" : "FLX?")) return 1;
+    while (readLine(line, LINE_TIMEOUT_MS)) {
+      if (startsWith(line, "FLX?OK:STREAM:")) { stream = true; window = atoi(line.c_str() + 14); handshake = true; break; }
+      if (line == "FLX?OK") { handshake = true; break; }
+      if (startsWith(line, "FLX?NOK")) { fprintf(stderr, "Target refused the handshake: %s\n", line.c_str()); return 1; }
+      if (startsWith(line, "UNKNOWN_CMD")) break; //older Programmer, retry with FLX?
+    }
+  }
+  if (!handshake) { fprintf(stderr, "Handshake with target %ld failed\n", target); return 1; }
+  if (window < 1) window = 1;
+  printf("Handshake OK, %s mode, window %u, %u records\n", stream ? "streaming" : "lockstep", window, (unsigned)records.size());
+
+  // sent: next record to write to serial, accepted: records the Programmer buffered (BUF), done: records the target ACKed (OK)
+  size_t sent = 0, accepted = 0, done = 0;
+  uint32_t startTime = nowMs();
+  while (done < records.size()) {
+    bool lineIdle = stream ? sent == accepted : sent == done;
+    if (lineIdle && sent < records.size() && sent - done < window) {
+      snprintf(buf, sizeof(buf), "FLX:%u:", (unsigned)sent);
+      if (!writeLine(buf + records[sent])) return 1;
+      sent++;
+      continue;
+    }
+    if (!readLine(line, LINE_TIMEOUT_MS)) { fprintf(stderr, "\nTimeout at record %u\n", (unsigned)done); return 1; }
+    unsigned seq;
+    char status[8];
+    if (startsWith(line, "FLX:INV")) { fprintf(stderr, "\nProgrammer rejected record %u: %s\n", (unsigned)sent - 1, line.c_str()); return 1; }
+    if (sscanf(line.c_str(), "FLX:%u:%7s", &seq, status) == 2) {
+      if (strcmp(status, "BUF") == 0 && seq == accepted) accepted++;
+      else if (strcmp(status, "OK") == 0 && seq == done) {
+        done++;
+        if (!stream) accepted = done;
+        if (!verbose) { printf("\r%u/%u", (unsigned)done, (unsigned)records.size()); fflush(stdout); }
+      }
+      else if (strcmp(status, "FULL") == 0) { fprintf(stderr, "\nProgrammer window overrun at %u\n", seq); return 1; }
+    }
+    else if (startsWith(line, "Timeout")) { fprintf(stderr, "\nProgrammer aborted: %s\n", line.c_str()); return 1; }
+  }
+
+  if (stream) snprintf(buf, sizeof(buf), "FLX?EOF:%08X", imageCRC); //older Programmer sketches only know the bare FLX?EOF
+  else snprintf(buf, sizeof(buf), "FLX?EOF");
+  if (!writeLine(buf)) return 1;
+  while (readLine(line, EOF_TIMEOUT_MS)) {
+    if (line == "FLX?OK") {
+      printf("\nFLASH IMG TRANSMISSION SUCCESS, %u records in %.1fs, CRC32 %08X\n", (unsigned)records.size(), (nowMs() - startTime) / 1000.0, imageCRC);
+      return 0;
+    }
+    if (startsWith(line, "FLX?NOK") || startsWith(line, "Timeout")) break;
+  }
+  fprintf(stderr, "\nFLASH IMG TRANSMISSION FAIL: %s\n", line.c_str());
+  return 1;
+}
@@ -157,7 +157,7 @@ void loop(){
       } else {
         Serial << F("Invalid BR300KBPS:") << newBR << endl;
       }
-    } else if (inputLen==4 && strstr(input, "FLX?")==input) {
+    } else if ((inputLen==4 || inputLen==10) && strstr(input, "FLX?")==input) { //FLX? or FLX?STREAM
       if (targetID==0)
         Serial.println("TO?");
       else
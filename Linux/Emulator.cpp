@@ -0,0 +1,330 @@
+#if defined(__linux__) && !defined(ARDUINO)
+#include "Emulator.h"
+
+#include "Linux.h"
+#include "SPI.h"
+#include "../RFM69registers.h"
+
+#include <errno.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#define MODE_SLEEP   0
+#define MODE_STANDBY 1
+#define MODE_SYNTH   2
+#define MODE_TX      3
+#define MODE_RX      4
+#define NOISE_FLOOR  -125 /* dBm reported by REG_RSSIVALUE when nothing is received */
+#define AIR_LIMIT    64   /* injected frames waiting for the receiver, the oldest is lost beyond that */
+#define SENT_LIMIT   1024 /* transmitted frames kept for transmitted(), the oldest is dropped beyond that */
+
+static uint64_t monotonicUs()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+}
+
+RFM69Emulator::RFM69Emulator() : devSpiFd(-1), devIrqFd(-1), hostSpiFd(-1), hostIrqFd(-1), txHandler(0), txContext(0)
+{
+	memset(regs, 0, sizeof(regs));
+	regs[REG_OPMODE] = RF_OPMODE_SEQUENCER_ON | RF_OPMODE_STANDBY;
+	regs[REG_OSC1] = RF_OSC1_RCCAL_DONE;
+	regs[REG_RSSICONFIG] = RF_RSSI_DONE;
+	regs[REG_TEMP2] = 0x95 + 25; /* ~25C with COURSE_TEMP_COEF */
+	regs[REG_PREAMBLELSB] = 3;
+	payloadReady = packetSent = false;
+	crcOk = true;
+	dio0 = 0;
+	packetRSSI = NOISE_FLOOR;
+	rssiLatched = false;
+	airtime = false;
+	timerAt = 0;
+	addressPhase = true;
+	writing = false;
+	address = 0;
+}
+
+RFM69Emulator::~RFM69Emulator()
+{
+	stop();
+}
+
+bool RFM69Emulator::start()
+{
+	if (thread.joinable()) return true;
+	int spi[2], irq[2];
+	if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, spi) < 0) return false;
+	if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, irq) < 0) { close(spi[0]); close(spi[1]); return false; }
+	hostSpiFd = spi[0]; devSpiFd = spi[1];
+	hostIrqFd = irq[0]; devIrqFd = irq[1];
+	thread = std::thread(&RFM69Emulator::run, this);
+	return true;
+}
+
+void RFM69Emulator::stop()
+{
+	if (!thread.joinable()) return;
+	shutdown(hostSpiFd, SHUT_RDWR); /* the emulator thread sees EOF */
+	thread.join();
+	close(hostSpiFd); close(devSpiFd); close(hostIrqFd); close(devIrqFd);
+	hostSpiFd = devSpiFd = hostIrqFd = devIrqFd = -1;
+}
+
+bool RFM69Emulator::attach(SPIClass &spi, uint8_t irqPin)
+{
+	if (!start()) return false;
+	spi.setFd(hostSpiFd, SPI_TRANSPORT_SOCKET);
+	gpioBindFd(irqPin, hostIrqFd);
+	return true;
+}
+
+void RFM69Emulator::run()
+{
+	uint8_t op[2];
+	size_t have = 0;
+	while (true) {
+		int timeoutMs = -1;
+		{
+			std::lock_guard<std::recursive_mutex> guard(lock);
+			if (timerAt) {
+				uint64_t now = monotonicUs();
+				timeoutMs = timerAt > now ? (timerAt - now + 999) / 1000 : 0;
+			}
+		}
+		struct pollfd pfd = { devSpiFd, POLLIN, 0 };
+		int ready = poll(&pfd, 1, timeoutMs);
+		if (ready < 0 && errno != EINTR) return;
+		if (ready <= 0) { listenTimer(); continue; }
+		ssize_t n = read(devSpiFd, op + have, 2 - have);
+		if (n < 0 && errno == EINTR) continue;
+		if (n <= 0) return;
+		have += n;
+		if (have < 2) continue;
+		have = 0;
+
+		std::lock_guard<std::recursive_mutex> guard(lock);
+		if (op[0] == SPI_SOCKET_SELECT) addressPhase = true;
+		else if (op[0] == SPI_SOCKET_DESELECT) addressPhase = true;
+		else if (op[0] == SPI_SOCKET_TRANSFER) {
+			uint8_t miso = spiTransfer(op[1]);
+			if (write(devSpiFd, &miso, 1) != 1) return;
+		}
+	}
+}
+
+uint8_t RFM69Emulator::spiTransfer(uint8_t data)
+{
+	if (addressPhase) {
+		addressPhase = false;
+		writing = data & 0x80;
+		address = data & 0x7F;
+		return 0;
+	}
+	uint8_t miso = 0;
+	if (writing) writeRegister(address, data);
+	else miso = readRegister(address);
+	if (address != REG_FIFO) address = (address + 1) & 0x7F; /* bursts auto increment, except on the FIFO */
+	return miso;
+}
+
+uint8_t RFM69Emulator::readRegister(uint8_t addr)
+{
+	switch (addr) {
+		case REG_FIFO: {
+			if (fifo.empty()) return 0;
+			uint8_t b = fifo.front();
+			fifo.pop_front();
+			if (fifo.empty() && payloadReady) { payloadReady = false; updateDIO0(); }
+			return b;
+		}
+		case REG_IRQFLAGS1: /* the whole frame arrives at once, so the sync word matched as long as it is in the FIFO */
+			return RF_IRQFLAGS1_MODEREADY | (payloadReady ? RF_IRQFLAGS1_SYNCADDRESSMATCH : 0);
+		case REG_IRQFLAGS2:
+			return (fifo.empty() ? 0 : RF_IRQFLAGS2_FIFONOTEMPTY) | (packetSent ? RF_IRQFLAGS2_PACKETSENT : 0)
+			     | (payloadReady ? RF_IRQFLAGS2_PAYLOADREADY : 0) | (payloadReady && crcOk ? RF_IRQFLAGS2_CRCOK : 0);
+		case REG_RSSIVALUE: {
+			int16_t rssi = (payloadReady || rssiLatched) ? packetRSSI : NOISE_FLOOR;
+			if (!payloadReady && (regs[REG_OPMODE] >> 2 & 0x07) == MODE_RX) rssiLatched = false;
+			return (uint8_t)(-2 * rssi);
+		}
+		default:
+			return regs[addr];
+	}
+}
+
+void RFM69Emulator::writeRegister(uint8_t addr, uint8_t value)
+{
+	switch (addr) {
+		case REG_FIFO:
+			if (fifo.size() < 66) fifo.push_back(value);
+			if ((regs[REG_OPMODE] >> 2 & 0x07) == MODE_TX && fifo.size() == fifo.front() + 1u) { transmit(); updateDIO0(); } /* TxStartCondition FifoNotEmpty */
+			return;
+		case REG_OPMODE: {
+			bool wasListening = listening();
+			regs[addr] = value & ~RF_OPMODE_LISTENABORT;
+			timerAt = 0;
+			if (listening() && (regs[REG_DIOMAPPING1] & 0xC0) == RF_DIOMAPPING1_DIO0_11) {
+				if (!wasListening) { pulseDIO0(); pulseDIO0(); }
+				timerAt = monotonicUs() + listenIdleUs();
+			}
+			enterMode((value >> 2) & 0x07);
+			return;
+		}
+		case REG_IRQFLAGS2:
+			if (value & RF_IRQFLAGS2_FIFOOVERRUN) { fifo.clear(); payloadReady = false; updateDIO0(); }
+			return;
+		case REG_PACKETCONFIG2:
+			regs[addr] = value & ~RF_PACKET2_RXRESTART;
+			if (value & RF_PACKET2_RXRESTART) { /* the driver also uses it in standby to drop a stale PayloadReady */
+				fifo.clear(); payloadReady = false; updateDIO0(); deliver();
+			}
+			return;
+		case REG_RSSICONFIG:
+			regs[addr] = RF_RSSI_DONE;
+			return;
+		default:
+			regs[addr] = value;
+	}
+}
+
+void RFM69Emulator::enterMode(uint8_t newMode)
+{
+	packetSent = false;
+	if (newMode == MODE_TX && !fifo.empty()) transmit();
+	else if (newMode == MODE_RX || listening()) {
+		if (!payloadReady) fifo.clear();
+		deliver();
+	}
+	updateDIO0();
+}
+
+/* sends the frame in the FIFO */
+void RFM69Emulator::transmit()
+{
+	uint8_t length = fifo.front();
+	fifo.pop_front();
+	std::vector<uint8_t> frame;
+	while (length-- && !fifo.empty()) { frame.push_back(fifo.front()); fifo.pop_front(); }
+	fifo.clear();
+	payloadReady = false; /* an unread packet went with the FIFO */
+	if (airtime) {
+		/* preamble, sync word, length byte, frame, CRC */
+		uint32_t bytes = (regs[REG_PREAMBLEMSB] << 8 | regs[REG_PREAMBLELSB]) + ((regs[REG_SYNCCONFIG] >> 3 & 0x07) + 1) + 1 + frame.size() + 2;
+		uint32_t divider = regs[REG_BITRATEMSB] << 8 | regs[REG_BITRATELSB];
+		usleep((uint64_t)bytes * 8 * divider / 32); /* bit time = divider / 32MHz */
+	}
+	packetSent = true;
+	if (sent.size() >= SENT_LIMIT) sent.pop_front(); /* nobody collects them, ex: a daemon */
+	sent.push_back(frame);
+	if (txHandler) txHandler(frame.data(), frame.size(), txContext);
+}
+
+/* listen mode: the RX periods are not modeled, a frame on air is received whenever listen mode is on */
+bool RFM69Emulator::listening()
+{
+	return regs[REG_OPMODE] & RF_OPMODE_LISTEN_ON;
+}
+
+/* moves the next injected frame into the FIFO when the receiver is free */
+void RFM69Emulator::deliver()
+{
+	if (((regs[REG_OPMODE] >> 2 & 0x07) != MODE_RX && !listening()) || payloadReady) return;
+	while (!air.empty() && !airCRC.front() && !(regs[REG_PACKETCONFIG1] & RF_PACKET1_CRCAUTOCLEAR_OFF)) {
+		air.pop_front(); airRSSI.pop_front(); airCRC.pop_front(); /* CRC auto-clear drops it */
+	}
+	if (air.empty()) return;
+	std::vector<uint8_t> &frame = air.front();
+	fifo.clear();
+	fifo.push_back(frame.size());
+	fifo.insert(fifo.end(), frame.begin(), frame.end());
+	packetRSSI = airRSSI.front();
+	crcOk = airCRC.front();
+	rssiLatched = true;
+	air.pop_front();
+	airRSSI.pop_front();
+	airCRC.pop_front();
+	payloadReady = true;
+	updateDIO0();
+}
+
+/* DIO0 is PayloadReady in RX and PacketSent in TX (DIO mapping 01/00), see RFM69::receiveBegin()
+ * SyncAddress and CrcOk (mappings 10/00 in RX) rise with PayloadReady since frames arrive whole */
+void RFM69Emulator::updateDIO0()
+{
+	uint8_t m = regs[REG_OPMODE] >> 2 & 0x07;
+	uint8_t level = ((m == MODE_RX || listening()) && payloadReady) || (m == MODE_TX && packetSent);
+	if (level == dio0) return;
+	dio0 = level;
+	if (write(devIrqFd, &level, 1) != 1) return;
+}
+
+/* a rising and a falling edge, DIO0 is low between the listen timer pulses */
+void RFM69Emulator::pulseDIO0()
+{
+	uint8_t levels[2] = { 1, 0 };
+	if (dio0) return;
+	if (write(devIrqFd, levels, 2) != 2) return;
+}
+
+/* the listen idle period ended: RX starts and the RSSI (threshold 255) pulses DIO0 */
+void RFM69Emulator::listenTimer()
+{
+	std::lock_guard<std::recursive_mutex> guard(lock);
+	if (!timerAt || monotonicUs() < timerAt) return;
+	pulseDIO0();
+	timerAt += listenIdleUs();
+}
+
+uint32_t RFM69Emulator::listenIdleUs()
+{
+	static const uint32_t resolution[4] = { 0, 64, 4100, 262000 };
+	uint32_t us = resolution[regs[REG_LISTEN1] >> 6 & 0x03] * regs[REG_LISTEN2];
+	return us ? us : 64;
+}
+
+void RFM69Emulator::inject(const void *frame, uint8_t length, int16_t rssi, bool crcOk)
+{
+	std::lock_guard<std::recursive_mutex> guard(lock);
+	const uint8_t *p = static_cast<const uint8_t*>(frame);
+	if (air.size() >= AIR_LIMIT) { air.pop_front(); airRSSI.pop_front(); airCRC.pop_front(); } /* the receiver is not keeping up */
+	air.push_back(std::vector<uint8_t>(p, p + (length > 65 ? 65 : length)));
+	airRSSI.push_back(rssi);
+	airCRC.push_back(crcOk);
+	deliver();
+}
+
+void RFM69Emulator::injectPacket(uint16_t sender, uint16_t target, const void *data, uint8_t length, bool requestACK, int16_t rssi)
+{
+	uint8_t frame[65];
+	if (length > 61) length = 61;
+	frame[0] = target;
+	frame[1] = sender;
+	frame[2] = (requestACK ? 0x40 : 0) | ((target & 0x300) >> 6) | ((sender & 0x300) >> 8); /* RFM69_CTL_REQACK, 10 bit addresses */
+	memcpy(frame + 3, data, length);
+	inject(frame, length + 3, rssi);
+}
+
+bool RFM69Emulator::transmitted(std::vector<uint8_t> &frame)
+{
+	std::lock_guard<std::recursive_mutex> guard(lock);
+	if (sent.empty()) return false;
+	frame.swap(sent.front());
+	sent.pop_front();
+	return true;
+}
+
+uint8_t RFM69Emulator::reg(uint8_t addr)
+{
+	std::lock_guard<std::recursive_mutex> guard(lock);
+	return regs[addr & 0x7F];
+}
+
+uint8_t RFM69Emulator::mode()
+{
+	std::lock_guard<std::recursive_mutex> guard(lock);
+	return regs[REG_OPMODE] >> 2 & 0x07;
+}
+#endif
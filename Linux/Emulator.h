@@ -0,0 +1,96 @@
+#pragma once
+
+/* Emulated RFM69 for running the driver without hardware (tests, daemon development).
+ * Speaks the SPI_TRANSPORT_SOCKET protocol of Linux/SPI.h on one end of a socketpair
+ * and drives DIO0 through another one, from its own thread:
+ *
+ *   RFM69Emulator emu;
+ *   emu.attach(spi, RF69_IRQ_PIN);  // spi.setFd() + gpioBindFd()
+ *   RFM69 radio(SS, RF69_IRQ_PIN, false, &spi);
+ *   radio.initialize(...);
+ *   emu.injectPacket(2, 1, "hello", 5);          // node 2 sends "hello" to node 1
+ *   while (!radio.receiveDone()) pollInterrupts(10);
+ *
+ * It models the register file, the FIFO, the modes (listen mode receives all the time) and the
+ * PayloadReady/PacketSent/SyncAddressMatch flags. It does not model AES (payloads are passed in the clear), timing or RF,
+ * except the transmit airtime when enabled with modelAirtime() and the listen mode timer (DIO0 mapped to 11, as set by
+ * listenModeSleep()): DIO0 pulses twice when listen mode starts and once at the end of every idle period. */
+
+#include <stdint.h>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class SPIClass;
+
+class RFM69Emulator {
+public:
+	typedef void (*TransmitHandler)(const uint8_t *frame, uint8_t length, void *context);
+
+	RFM69Emulator();
+	~RFM69Emulator();
+
+	bool start();
+	void stop();
+	int spiFd() { return hostSpiFd; }
+	int irqFd() { return hostIrqFd; }
+	bool attach(SPIClass &spi, uint8_t irqPin); /* start() + connect spi and the DIO0 pin */
+
+	/* frame is what follows the length byte on air: target, sender, CTL, payload
+	 * crcOk = false: the frame was corrupted on air, dropped unless CRC auto-clear is off, then received without CrcOk
+	 * up to 64 frames wait for the receiver, beyond that the oldest is lost */
+	void inject(const void *frame, uint8_t length, int16_t rssi = -60, bool crcOk = true);
+	void injectPacket(uint16_t sender, uint16_t target, const void *data, uint8_t length, bool requestACK = false, int16_t rssi = -60);
+
+	/* frames the driver transmitted (same layout as inject), oldest first, the last 1024 are kept */
+	bool transmitted(std::vector<uint8_t> &frame);
+	/* called from the emulator thread for every transmitted frame, ex: to answer with an ACK */
+	void onTransmit(TransmitHandler handler, void *context) { txHandler = handler; txContext = context; }
+
+	uint8_t reg(uint8_t addr);
+	uint8_t mode();
+	/* when on, the switch to TX takes the frame's airtime at the configured bitrate/preamble/sync size
+	 * before PacketSent is set, so the driver spends a realistic time in TX (ex: energy accounting) */
+	void modelAirtime(bool on) { airtime = on; }
+
+private:
+	void run();
+	uint8_t spiTransfer(uint8_t data);
+	uint8_t readRegister(uint8_t addr);
+	void writeRegister(uint8_t addr, uint8_t value);
+	void enterMode(uint8_t newMode);
+	void transmit();
+	bool listening();
+	void deliver();
+	void updateDIO0();
+	void pulseDIO0();
+	void listenTimer();
+	uint32_t listenIdleUs();
+
+	int devSpiFd, devIrqFd, hostSpiFd, hostIrqFd;
+	std::thread thread;
+	std::recursive_mutex lock; /* recursive: onTransmit handlers may inject() */
+
+	uint8_t regs[0x80];
+	std::deque<uint8_t> fifo;
+	bool payloadReady;
+	bool crcOk;        /* of the frame in the FIFO */
+	bool packetSent;
+	uint8_t dio0;
+	int16_t packetRSSI;
+	bool airtime;
+	uint64_t timerAt;  /* monotonic us of the next listen timer pulse, 0 = off */
+	bool rssiLatched;  /* packetRSSI is reported until read once back in RX, then the noise floor */
+	std::deque<std::vector<uint8_t> > air;     /* injected, not yet received */
+	std::deque<std::vector<uint8_t> > sent;    /* transmitted by the driver */
+	std::deque<int16_t> airRSSI;
+	std::deque<bool> airCRC;
+
+	bool addressPhase;
+	bool writing;
+	uint8_t address;
+
+	TransmitHandler txHandler;
+	void *txContext;
+};
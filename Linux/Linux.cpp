@@ -0,0 +1,208 @@
+#if defined(__linux__) && !defined(ARDUINO)
+#include "Linux.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/ioctl.h>
+#include <time.h>
+#include <unistd.h>
+#include <linux/gpio.h>
+
+#define NO_FD -1
+
+struct pin_state {
+	int lineFd;      /* GPIO handle (input/output) or event (interrupt) fd on the chip */
+	int boundFd;     /* set with gpioBindFd() */
+	uint8_t level;
+	uint8_t output;
+	int edge;        /* RISING/FALLING/CHANGE when attached */
+	void (*isr)();
+};
+
+static pin_state pins[256];
+static bool pinsReady = false;
+static int chipFd = NO_FD;
+static int epollFd = NO_FD;
+
+static void initPins()
+{
+	if (pinsReady) return;
+	for (int i = 0; i < 256; i++) {
+		pins[i].lineFd = NO_FD;
+		pins[i].boundFd = NO_FD;
+		pins[i].level = LOW;
+		pins[i].output = false;
+		pins[i].edge = 0;
+		pins[i].isr = 0;
+	}
+	pinsReady = true;
+}
+
+static uint64_t monotonicUs()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+}
+
+static uint64_t startUs = monotonicUs();
+
+unsigned long millis() { return (monotonicUs() - startUs) / 1000; }
+unsigned long micros() { return monotonicUs() - startUs; }
+
+void delay(unsigned long ms)
+{
+	struct timespec ts = { (time_t)(ms / 1000), (long)(ms % 1000) * 1000000L };
+	while (nanosleep(&ts, &ts) < 0 && errno == EINTR);
+}
+
+void delayMicroseconds(unsigned int us)
+{
+	struct timespec ts = { (time_t)(us / 1000000), (long)(us % 1000000) * 1000L };
+	while (nanosleep(&ts, &ts) < 0 && errno == EINTR);
+}
+
+bool gpioOpenChip(const char* path)
+{
+	initPins();
+	if (chipFd != NO_FD) close(chipFd);
+	chipFd = open(path, O_RDWR | O_CLOEXEC);
+	if (chipFd < 0) { perror(path); chipFd = NO_FD; return false; }
+	return true;
+}
+
+void gpioBindFd(uint8_t pin, int fd)
+{
+	initPins();
+	pins[pin].boundFd = fd;
+	fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+}
+
+static void releaseLine(uint8_t pin)
+{
+	if (pins[pin].lineFd != NO_FD) {
+		if (epollFd != NO_FD) epoll_ctl(epollFd, EPOLL_CTL_DEL, pins[pin].lineFd, 0);
+		close(pins[pin].lineFd);
+	}
+	pins[pin].lineFd = NO_FD;
+}
+
+void pinMode(uint8_t pin, uint8_t mode)
+{
+	initPins();
+	pins[pin].output = mode == OUTPUT;
+	if (pins[pin].boundFd != NO_FD || chipFd == NO_FD || pin == SS) return;
+	releaseLine(pin);
+	struct gpiohandle_request req;
+	memset(&req, 0, sizeof(req));
+	req.lineoffsets[0] = pin;
+	req.lines = 1;
+	req.flags = mode == OUTPUT ? GPIOHANDLE_REQUEST_OUTPUT : GPIOHANDLE_REQUEST_INPUT;
+	req.default_values[0] = pins[pin].level;
+	strcpy(req.consumer_label, "RFM69");
+	if (ioctl(chipFd, GPIO_GET_LINEHANDLE_IOCTL, &req) < 0) { perror("GPIO_GET_LINEHANDLE_IOCTL"); return; }
+	pins[pin].lineFd = req.fd;
+}
+
+void digitalWrite(uint8_t pin, uint8_t val)
+{
+	initPins();
+	pins[pin].level = val ? HIGH : LOW;
+	if (pins[pin].lineFd == NO_FD || !pins[pin].output) return;
+	struct gpiohandle_data data;
+	memset(&data, 0, sizeof(data));
+	data.values[0] = pins[pin].level;
+	ioctl(pins[pin].lineFd, GPIOHANDLE_SET_LINE_VALUES_IOCTL, &data);
+}
+
+int digitalRead(uint8_t pin)
+{
+	initPins();
+	if (pins[pin].lineFd != NO_FD) {
+		struct gpiohandle_data data;
+		if (ioctl(pins[pin].lineFd, GPIOHANDLE_GET_LINE_VALUES_IOCTL, &data) == 0)
+			pins[pin].level = data.values[0] ? HIGH : LOW;
+	}
+	return pins[pin].level;
+}
+
+int interruptFd()
+{
+	if (epollFd == NO_FD) epollFd = epoll_create1(EPOLL_CLOEXEC);
+	return epollFd;
+}
+
+void attachInterrupt(uint8_t pin, void (*func)(), int mode)
+{
+	initPins();
+	detachInterrupt(pin);
+	int fd = pins[pin].boundFd;
+	if (fd == NO_FD) {
+		if (chipFd == NO_FD) { fprintf(stderr, "attachInterrupt(%u): no GPIO chip open and no fd bound\n", pin); return; }
+		releaseLine(pin);
+		struct gpioevent_request req;
+		memset(&req, 0, sizeof(req));
+		req.lineoffset = pin;
+		req.handleflags = GPIOHANDLE_REQUEST_INPUT;
+		req.eventflags = mode == RISING ? GPIOEVENT_REQUEST_RISING_EDGE : (mode == FALLING ? GPIOEVENT_REQUEST_FALLING_EDGE : GPIOEVENT_REQUEST_BOTH_EDGES);
+		strcpy(req.consumer_label, "RFM69 IRQ");
+		if (ioctl(chipFd, GPIO_GET_LINEEVENT_IOCTL, &req) < 0) { perror("GPIO_GET_LINEEVENT_IOCTL"); return; }
+		fd = pins[pin].lineFd = req.fd;
+		fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+	}
+	pins[pin].edge = mode;
+	pins[pin].isr = func;
+	struct epoll_event ev;
+	ev.events = EPOLLIN;
+	ev.data.u32 = pin;
+	epoll_ctl(interruptFd(), EPOLL_CTL_ADD, fd, &ev);
+}
+
+void detachInterrupt(uint8_t pin)
+{
+	initPins();
+	if (!pins[pin].isr) return;
+	pins[pin].isr = 0;
+	if (pins[pin].boundFd != NO_FD) epoll_ctl(interruptFd(), EPOLL_CTL_DEL, pins[pin].boundFd, 0);
+	else releaseLine(pin);
+}
+
+static int dispatch(uint8_t pin)
+{
+	pin_state &p = pins[pin];
+	int calls = 0;
+	if (p.boundFd != NO_FD) {
+		uint8_t levels[64];
+		ssize_t n;
+		while ((n = read(p.boundFd, levels, sizeof(levels))) > 0)
+			for (ssize_t i = 0; i < n; i++) {
+				uint8_t level = levels[i] ? HIGH : LOW;
+				bool fire = (p.edge == CHANGE && level != p.level) || (p.edge == RISING && level && !p.level) || (p.edge == FALLING && !level && p.level);
+				p.level = level;
+				if (fire && p.isr) { p.isr(); calls++; }
+			}
+		return calls;
+	}
+	struct gpioevent_data events[16];
+	ssize_t n;
+	while (p.lineFd != NO_FD && (n = read(p.lineFd, events, sizeof(events))) > 0)
+		for (ssize_t i = 0; i < n / (ssize_t)sizeof(events[0]); i++) {
+			p.level = events[i].id == GPIOEVENT_EVENT_RISING_EDGE ? HIGH : LOW;
+			if (p.isr) { p.isr(); calls++; } /* the kernel already filtered the edges */
+		}
+	return calls;
+}
+
+int pollInterrupts(int timeoutMs)
+{
+	initPins();
+	struct epoll_event events[8];
+	int n = epoll_wait(interruptFd(), events, 8, timeoutMs);
+	if (n < 0) return errno == EINTR ? 0 : -1;
+	int calls = 0;
+	for (int i = 0; i < n; i++)
+		calls += dispatch(events[i].data.u32);
+	return calls;
+}
+#endif
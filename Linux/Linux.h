@@ -0,0 +1,71 @@
+#pragma once
+
+/* Linux userspace backend: lets the driver run as a native process (gateway daemon)
+ * with the radio on spidev + a GPIO character device, or on an emulated device.
+ *
+ * Pins are GPIO line offsets on the chip opened with gpioOpenChip(), or any pin bound
+ * to a file descriptor with gpioBindFd() (emulated device: every byte read from the fd
+ * is the new DIO level, 0 or 1).
+ * Interrupts are not asynchronous: edges are collected with epoll and the attached
+ * handlers are called from pollInterrupts(), which RFM69::receiveDone() calls with a
+ * zero timeout. A daemon blocks in pollInterrupts(timeout) (or in its own epoll on
+ * interruptFd()) instead of spinning on receiveDone(). */
+
+#include <stdint.h>
+#include <stdlib.h> /* abs */
+#include <cstdio>   /* sprintf and sscanf */
+#include <cstring>  /* memcpy and memcmp */
+
+#include "Serial.h"
+
+#define RF69_LINUX
+
+#define HIGH    1
+#define LOW     0
+#define CHANGE  1
+#define FALLING 2
+#define RISING  3
+
+#define INPUT   0
+#define OUTPUT  1
+
+#define SS      0xFF /* no GPIO, chip select is driven by spidev */
+
+/* interrupts are identified by their pin */
+#define digitalPinToInterrupt(p) (p)
+
+enum PRINT_TYPE {
+	HEX = 16,
+	DEC = 10,
+	BIN = 2,
+};
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define F(str) str
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t val);
+int digitalRead(uint8_t pin);
+void attachInterrupt(uint8_t pin, void (*func)(), int mode);
+void detachInterrupt(uint8_t pin);
+/* handlers only run from pollInterrupts(), so there is nothing to mask */
+inline void noInterrupts() {}
+inline void interrupts() {}
+
+/* GPIO character device (ex: /dev/gpiochip0), needed for real pins only */
+bool gpioOpenChip(const char* path);
+/* bind a pin to a file descriptor instead of a GPIO line (emulated devices, tests) */
+void gpioBindFd(uint8_t pin, int fd);
+
+/* waits up to timeoutMs (0 = don't wait, -1 = forever) for edges and calls the attached handlers
+ * returns the # of handlers called, -1 on error */
+int pollInterrupts(int timeoutMs);
+/* epoll fd that becomes readable when pollInterrupts() has something to dispatch */
+int interruptFd();
@@ -0,0 +1,123 @@
+#if defined(__linux__) && !defined(ARDUINO)
+#include "SPI.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+#include <linux/spi/spidev.h>
+
+SPIClass SPI;
+
+SPIClass::SPIClass(const char *device) : device(device), fd(-1), transport(SPI_TRANSPORT_SPIDEV), selected(false), clock(4000000)
+{
+
+}
+
+SPIClass::~SPIClass()
+{
+  end();
+}
+
+bool SPIClass::begin()
+{
+  if (fd >= 0) return true;
+  fd = open(device, O_RDWR | O_CLOEXEC);
+  if (fd < 0) { perror(device); return false; }
+  transport = SPI_TRANSPORT_SPIDEV;
+  uint8_t mode = SPI_MODE_0;
+  uint8_t bits = 8;
+  if (ioctl(fd, SPI_IOC_WR_MODE, &mode) < 0 || ioctl(fd, SPI_IOC_WR_BITS_PER_WORD, &bits) < 0)
+    perror("spidev setup");
+  return true;
+}
+
+void SPIClass::setFd(int fd, uint8_t transport)
+{
+  this->fd = fd;
+  this->transport = transport;
+}
+
+static bool writeAll(int fd, const uint8_t *buf, size_t count)
+{
+  while (count) {
+    ssize_t n = write(fd, buf, count);
+    if (n < 0) { if (errno == EINTR) continue; return false; }
+    buf += n; count -= n;
+  }
+  return true;
+}
+
+static bool readAll(int fd, uint8_t *buf, size_t count)
+{
+  while (count) {
+    ssize_t n = read(fd, buf, count);
+    if (n < 0) { if (errno == EINTR) continue; return false; }
+    if (n == 0) return false;
+    buf += n; count -= n;
+  }
+  return true;
+}
+
+void SPIClass::beginTransaction(SPISettings settings)
+{
+  clock = settings.clock;
+  selected = true;
+  if (fd >= 0 && transport == SPI_TRANSPORT_SOCKET) {
+    uint8_t op[2] = { SPI_SOCKET_SELECT, 0 };
+    writeAll(fd, op, 2);
+  }
+}
+
+// full duplex, in place: buf is sent and replaced by what was received
+void SPIClass::transfer(void *buf, size_t count)
+{
+  uint8_t *p = static_cast<uint8_t*>(buf);
+  if (fd < 0 || !count) return;
+  if (transport == SPI_TRANSPORT_SOCKET) {
+    for (size_t i = 0; i < count; i++) {
+      uint8_t op[2] = { SPI_SOCKET_TRANSFER, p[i] };
+      if (!writeAll(fd, op, 2) || !readAll(fd, p + i, 1)) p[i] = 0;
+    }
+    return;
+  }
+  struct spi_ioc_transfer xfer;
+  memset(&xfer, 0, sizeof(xfer));
+  xfer.tx_buf = (unsigned long)p;
+  xfer.rx_buf = (unsigned long)p;
+  xfer.len = count;
+  xfer.speed_hz = clock;
+  xfer.bits_per_word = 8;
+  xfer.cs_change = selected; // keep CS asserted until endTransaction()
+  if (ioctl(fd, SPI_IOC_MESSAGE(1), &xfer) < 0) memset(p, 0, count);
+}
+
+uint8_t SPIClass::transfer(uint8_t data)
+{
+  transfer(&data, 1);
+  return data;
+}
+
+void SPIClass::endTransaction(void)
+{
+  selected = false;
+  if (fd < 0) return;
+  if (transport == SPI_TRANSPORT_SOCKET) {
+    uint8_t op[2] = { SPI_SOCKET_DESELECT, 0 };
+    writeAll(fd, op, 2);
+    return;
+  }
+  struct spi_ioc_transfer xfer; // empty transfer without cs_change releases CS
+  memset(&xfer, 0, sizeof(xfer));
+  xfer.speed_hz = clock;
+  ioctl(fd, SPI_IOC_MESSAGE(1), &xfer);
+}
+
+void SPIClass::end()
+{
+  if (fd >= 0 && transport == SPI_TRANSPORT_SPIDEV) close(fd);
+  fd = -1;
+}
+#endif
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstddef>
+#include <stdint.h>
+
+/* SPI over a file descriptor:
+ *  - SPI_TRANSPORT_SPIDEV: a spidev device (ex: /dev/spidev0.0), CS is held for the
+ *    whole beginTransaction()..endTransaction() so register bursts stay in one frame
+ *  - SPI_TRANSPORT_SOCKET: a stream socket to an emulated device (see Emulator.h), each
+ *    operation is 2 bytes {op, data} and a transfer is answered with the MISO byte */
+#define SPI_TRANSPORT_SPIDEV 0
+#define SPI_TRANSPORT_SOCKET 1
+
+#define SPI_SOCKET_SELECT    0x01
+#define SPI_SOCKET_TRANSFER  0x02
+#define SPI_SOCKET_DESELECT  0x03
+
+#define SPI_HAS_TRANSACTION
+
+#define SPI_CLOCK_DIV2  0
+#define SPI_CLOCK_DIV8  0
+#define SPI_CLOCK_DIV16 0
+#define SPI_MODE0 0
+
+#define MSBFIRST 0
+#define LSBFIRST 1
+
+class SPISettings {
+private:
+  uint32_t clock;
+public:
+  SPISettings(uint32_t clock, uint8_t bitOrder __attribute__((unused)), uint8_t dataMode __attribute__((unused))) : clock(clock) {
+  }
+  SPISettings() : clock(4000000) {
+  }
+  friend class SPIClass;
+};
+
+
+class SPIClass {
+private:
+  const char *device;
+  int fd;
+  uint8_t transport;
+  bool selected;
+  uint32_t clock;
+public:
+  // device is opened by begin(), or give an already open fd with setFd()
+  SPIClass(const char *device = "/dev/spidev0.0");
+  ~SPIClass();
+  bool begin();
+  void setFd(int fd, uint8_t transport = SPI_TRANSPORT_SOCKET);
+  int getFd() { return fd; }
+
+  void usingInterrupt(uint8_t interruptNumber __attribute__((unused))) {}
+  void notUsingInterrupt(uint8_t interruptNumber __attribute__((unused))) {}
+
+  void beginTransaction(SPISettings settings);
+  uint8_t transfer(uint8_t data);
+  void transfer(void *buf, size_t count);
+  void endTransaction(void);
+
+  void end();
+
+  void setBitOrder(uint8_t bitOrder __attribute__((unused))) {}
+  void setDataMode(uint8_t dataMode __attribute__((unused))) {}
+  void setClockDivider(uint8_t clockDiv __attribute__((unused))) {}
+};
+
+extern SPIClass SPI;
@@ -0,0 +1,65 @@
+#if defined(__linux__) && !defined(ARDUINO)
+#include "Serial.h"
+
+#include "Linux.h"
+
+#include <poll.h>
+#include <unistd.h>
+
+SerialDebug Serial(STDOUT_FILENO);
+
+SerialDebug::SerialDebug(int fd) : fd(fd), inFd(STDIN_FILENO), timeout(0) {}
+void SerialDebug::setFd(int fd) { this->fd = inFd = fd; }
+
+static void write_str(int fd, const char *s) { if (write(fd, s, strlen(s)) < 0) return; }
+
+void SerialDebug::begin(long baud __attribute__((unused))) {}
+void SerialDebug::print(int val, int type) {
+	char buf[40];
+	if (type == BIN) {
+		int i = 0;
+		for (int bit = 7; bit >= 0; bit--) buf[i++] = (val >> bit) & 1 ? '1' : '0'; /* registers are 8 bit */
+		buf[i] = 0;
+	}
+	else snprintf(buf, sizeof(buf), type == HEX ? "%X" : "%d", val);
+	write_str(fd, buf);
+}
+void SerialDebug::print(int val) { print(val, DEC); }
+void SerialDebug::print(unsigned int val) { print((unsigned long)val); }
+void SerialDebug::print(long val) { char buf[24]; snprintf(buf, sizeof(buf), "%ld", val); write_str(fd, buf); }
+void SerialDebug::print(unsigned long val) { char buf[24]; snprintf(buf, sizeof(buf), "%lu", val); write_str(fd, buf); }
+void SerialDebug::print(char val) { char buf[2] = { val, 0 }; write_str(fd, buf); }
+void SerialDebug::print(const char *val) { write_str(fd, val); }
+void SerialDebug::print(float val) { char buf[32]; snprintf(buf, sizeof(buf), "%.2f", val); write_str(fd, buf); }
+void SerialDebug::println() { write_str(fd, "\n"); }
+void SerialDebug::println(int val) { print(val); println(); }
+void SerialDebug::println(unsigned int val) { print(val); println(); }
+void SerialDebug::println(long val) { print(val); println(); }
+void SerialDebug::println(unsigned long val) { print(val); println(); }
+void SerialDebug::println(const char *val) { print(val); println(); }
+void SerialDebug::println(const char *val, int type __attribute__((unused))) { print(val); println(); }
+void SerialDebug::println(int val, int type) { print(val, type); println(); }
+void SerialDebug::println(float val) { print(val); println(); }
+void SerialDebug::setTimeout(int val) { timeout = val; }
+int SerialDebug::available() {
+	struct pollfd pfd = { inFd, POLLIN, 0 };
+	return poll(&pfd, 1, 0) > 0 ? 1 : 0;
+}
+int SerialDebug::read() {
+	unsigned char c;
+	return available() && ::read(inFd, &c, 1) == 1 ? c : -1;
+}
+int SerialDebug::readBytesUntil(const char terminator, const char *buf, int len)
+{
+	char *out = const_cast<char*>(buf);
+	int n = 0;
+	while (n < len) {
+		struct pollfd pfd = { inFd, POLLIN, 0 };
+		if (poll(&pfd, 1, timeout) <= 0) break;
+		int c = read();
+		if (c < 0 || c == terminator) break;
+		out[n++] = c;
+	}
+	return n;
+}
+#endif
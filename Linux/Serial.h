@@ -0,0 +1,36 @@
+#pragma once
+
+/* Serial on Linux is the process' stdout/stdin, or any other fd with setFd() (ex: the master of a pty) */
+
+class SerialDebug {
+private:
+	int fd, inFd;
+	long timeout;
+public:
+	SerialDebug(int fd);
+	void setFd(int fd); /* both directions */
+	void begin(long baud);
+	void print(int val, int type);
+	void print(int val);
+	void print(unsigned int val);
+	void print(long val);
+	void print(unsigned long val);
+	void print(char val);
+	void print(const char *val);
+	void print(float val);
+
+	void println();
+	void println(int val);
+	void println(unsigned int val);
+	void println(long val);
+	void println(unsigned long val);
+	void println(const char *val);
+	void println(const char *val, int type);
+	void println(int val, int type);
+	void println(float val);
+
+	void setTimeout(int val); /* ms readBytesUntil() waits for each byte, as Arduino's Stream */
+	int available();
+	int read();
+	int readBytesUntil(const char, const char*, int len);
+};
@@ -0,0 +1,69 @@
+/* Auto-ACK against the emulated radio: a packet is only ACKed if the application gets it. One that comes in while
+ * sendWithRetry() waits for its own ACK is dropped without an ACK, so its sender retries and it gets through.
+ * Build: g++ -O2 -pthread -I../.. -o AutoACKTest AutoACKTest.cpp ../../RFM69.cpp ../Linux.cpp ../SPI.cpp ../Serial.cpp ../Emulator.cpp
+ * Run: ./AutoACKTest, exits non-zero on failure */
+
+#include <RFM69.h>
+#include "../Emulator.h"
+#include "Test.h"
+
+#define IRQ_PIN   7
+#define GATEWAY   1
+#define SENDER    2 /* reports to the gateway, retries until ACKed */
+#define NODE      3 /* the gateway sends it a command */
+
+struct Air {
+	RFM69Emulator *emu;
+	uint8_t acksToSender;
+	bool reportSent;
+};
+
+static void injectReport(Air &air)
+{
+	air.emu->injectPacket(SENDER, GATEWAY, "report", 6, true);
+}
+
+static void peers(const uint8_t *frame, uint8_t length, void *context)
+{
+	Air &air = *static_cast<Air*>(context);
+	if (length < 3) return;
+	if (frame[0] == SENDER && (frame[2] & 0x80)) air.acksToSender++; /* RFM69_CTL_SENDACK */
+	if (frame[0] == NODE && (frame[2] & 0x40)) { /* RFM69_CTL_REQACK */
+		if (!air.reportSent) { injectReport(air); air.reportSent = true; } /* on air while the gateway waits for NODE */
+		uint8_t ack[3] = { GATEWAY, NODE, 0x80 };
+		air.emu->inject(ack, sizeof(ack));
+	}
+}
+
+int main()
+{
+	SPIClass spi("emulator");
+	RFM69Emulator emu;
+	if (!emu.attach(spi, IRQ_PIN)) { printf("emulator failed to start\n"); return 1; }
+	RFM69 radio(SS, IRQ_PIN, false, &spi);
+	CHECK(radio.initialize(RF69_868MHZ, GATEWAY, 100));
+	radio.enableAutoACK();
+
+	Air air = { &emu, 0, false };
+	emu.onTransmit(peers, &air);
+	CHECK(radio.sendWithRetry(NODE, "cmd", 3, 2, 50));
+	CHECK(air.reportSent);
+	CHECK(air.acksToSender == 0); /* dropped by the ACK wait, not ACKed */
+
+	/* the sender's retry */
+	if (!air.acksToSender) injectReport(air);
+	int delivered = 0;
+	unsigned long start = millis();
+	while (millis() - start < 100) {
+		if (radio.receiveDone()) {
+			CHECK(radio.SENDERID == SENDER && strcmp((const char*)radio.DATA, "report") == 0);
+			CHECK(radio.ACKSent());
+			delivered++;
+		}
+		pollInterrupts(2);
+	}
+	CHECK(delivered == 1);
+	CHECK(air.acksToSender == 1);
+	emu.onTransmit(NULL, NULL);
+	return testResult("AutoACKTest");
+}
@@ -0,0 +1,84 @@
+/* Forward error correction against the emulated radio: frames hit by a burst of flipped bits (bad CRC) are corrected
+ * as long as the burst is no longer than the interleaving depth, longer bursts and invisible errors are dropped,
+ * getFECCorrected() and getFECFailed() count both.
+ * Build: g++ -O2 -pthread -DRF69_FEC_ENABLE -I../.. -o FECTest FECTest.cpp ../../RFM69.cpp ../Linux.cpp ../SPI.cpp ../Serial.cpp ../Emulator.cpp
+ * Run: ./FECTest, exits non-zero on failure */
+
+#include <vector>
+#include <RFM69.h>
+#include "../Emulator.h"
+#include "Test.h"
+
+#if !defined(RF69_FEC_ENABLE)
+#error build with -DRF69_FEC_ENABLE
+#endif
+
+#define IRQ_PIN   7
+#define NODEID    1
+#define SENDER    2
+#define MESSAGE   "hello fec world"
+
+/* flips length bits from bit first on, MSB of each byte goes on air first */
+static std::vector<uint8_t> burst(const std::vector<uint8_t> &frame, uint16_t first, uint16_t length)
+{
+	std::vector<uint8_t> hit = frame;
+	for (uint16_t p = first; p < first + length; p++) hit[p / 8] ^= 0x80 >> (p % 8);
+	return hit;
+}
+
+/* true if the frame came through with the message intact */
+static bool receive(RFM69Emulator &emu, RFM69 &radio, const std::vector<uint8_t> &frame, bool crcOk)
+{
+	emu.inject(frame.data(), frame.size(), -60, crcOk);
+	bool done = waitFor([&] { return radio.receiveDone(); }, 50);
+	return done && radio.SENDERID == SENDER && radio.DATALEN == strlen(MESSAGE) && memcmp(radio.DATA, MESSAGE, radio.DATALEN) == 0;
+}
+
+int main()
+{
+	SPIClass spi("emulator");
+	RFM69Emulator emu;
+	if (!emu.attach(spi, IRQ_PIN)) { printf("emulator failed to start\n"); return 1; }
+	RFM69 radio(SS, IRQ_PIN, false, &spi);
+	CHECK(radio.initialize(RF69_868MHZ, SENDER, 100));
+	CHECK(radio.enableFEC());
+
+	/* the coded frame as SENDER puts it on air, then receive it as NODEID */
+	radio.send(NODEID, MESSAGE, strlen(MESSAGE));
+	std::vector<uint8_t> frame;
+	CHECK(emu.transmitted(frame));
+	radio.setAddress(NODEID);
+	uint16_t n = frame.size(); /* codewords, also the interleaving depth in bits */
+	CHECK(n == 2 * (3 + strlen(MESSAGE)));
+
+	CHECK(receive(emu, radio, frame, true));
+	CHECK(radio.getFECCorrected() == 0 && radio.getFECFailed() == 0);
+
+	/* one bit in every codeword */
+	CHECK(receive(emu, radio, burst(frame, 0, n), false));
+	CHECK(radio.getFECCorrected() == n && radio.getFECFailed() == 0);
+
+	/* a shorter burst across byte boundaries */
+	CHECK(receive(emu, radio, burst(frame, 13, 20), false));
+	CHECK(radio.getFECCorrected() == n + 20 && radio.getFECFailed() == 0);
+
+	/* the same burst in the last bits of the frame */
+	CHECK(receive(emu, radio, burst(frame, n * 8 - 20, 20), false));
+	CHECK(radio.getFECCorrected() == n + 40 && radio.getFECFailed() == 0);
+
+	/* one bit too long: its first and last bit land in the same codeword */
+	CHECK(!receive(emu, radio, burst(frame, 5, n + 1), false));
+	CHECK(radio.getFECCorrected() == n + 40 && radio.getFECFailed() == 1);
+
+	/* codeword 9 xor 0x33 (bits 0, 1, 4 and 5) is another valid codeword: the CRC failed but nothing looks wrong */
+	std::vector<uint8_t> invisible = frame;
+	for (uint8_t bit = 0; bit < 8; bit++)
+		if (0x33 & (1 << bit)) invisible = burst(invisible, 9 + bit * n, 1);
+	CHECK(!receive(emu, radio, invisible, false));
+	CHECK(radio.getFECFailed() == 2);
+
+	/* still receiving after the dropped ones */
+	CHECK(receive(emu, radio, burst(frame, 100, 7), false));
+	CHECK(radio.getFECCorrected() == n + 47 && radio.getFECFailed() == 2);
+	return testResult("FECTest");
+}
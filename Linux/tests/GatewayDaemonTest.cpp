@@ -0,0 +1,117 @@
+/* GatewayDaemon against the emulated radio (-e -r): under load the rx count in every -S stats line keeps growing
+ * (the receiver used to stall), at a modest packet rate the pipeline also drops nothing and the generated packets come
+ * out on stdout in order. A packet on air while the gateway sends an ACK is lost as with a real (half duplex) radio,
+ * so a few of those are allowed.
+ * Build: g++ -O2 -pthread -I../.. -o GatewayDaemon ../../Examples/LinuxGateway/GatewayDaemon.cpp ../../RFM69.cpp ../../RFM69_ATC.cpp
+ *          ../../RFM69_Queue.cpp ../../RFM69_Frame.cpp ../Linux.cpp ../SPI.cpp ../Serial.cpp ../Emulator.cpp
+ *        g++ -O2 -pthread -I../.. -o GatewayDaemonTest GatewayDaemonTest.cpp ../Linux.cpp ../SPI.cpp ../Serial.cpp
+ * Run: ./GatewayDaemonTest ./GatewayDaemon, exits non-zero on failure */
+
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <string>
+#include "Test.h"
+
+#define SECONDS   5
+
+struct Run {
+	int stats;                /* -S lines */
+	unsigned long long rx;    /* the last rx count */
+	bool growing;             /* rx grew from one stats line to the next */
+	unsigned dropped;         /* packets the radio stage could not hand to the decode stage */
+	long lines;               /* packets on stdout */
+	long last;                /* the number the last one carried */
+	bool inOrder;
+	int status;
+};
+
+/* hands complete lines to handle() */
+template <typename Handler> static bool readLines(int fd, std::string &pending, Handler handle)
+{
+	char buf[4096];
+	ssize_t n = read(fd, buf, sizeof(buf));
+	if (n <= 0) return false;
+	pending.append(buf, n);
+	size_t end;
+	while ((end = pending.find('\n')) != std::string::npos) {
+		handle(pending.substr(0, end));
+		pending.erase(0, end + 1);
+	}
+	return true;
+}
+
+/* runs the daemon for SECONDS with the emulator generating rate packets/s */
+static Run run(const char *daemonPath, const char *rate)
+{
+	Run r = { 0, 0, true, 0, 0, -1, true, -1 };
+	int out[2], err[2];
+	if (pipe(out) < 0 || pipe(err) < 0) { perror("pipe"); return r; }
+	pid_t daemon = fork();
+	if (daemon == 0) {
+		int null = open("/dev/null", O_RDONLY); /* no host commands */
+		dup2(null, STDIN_FILENO);
+		dup2(out[1], STDOUT_FILENO);
+		dup2(err[1], STDERR_FILENO);
+		execl(daemonPath, daemonPath, "-e", "-r", rate, "-S", "1", (char*)NULL);
+		_exit(127);
+	}
+	close(out[1]);
+	close(err[1]);
+
+	std::string outPending, errPending;
+	struct pollfd fds[2] = { { out[0], POLLIN, 0 }, { err[0], POLLIN, 0 } };
+	unsigned long start = millis();
+	while (millis() - start < SECONDS * 1000UL) {
+		if (poll(fds, 2, 100) <= 0) continue;
+		if (fds[0].revents) readLines(out[0], outPending, [&](const std::string &line) {
+			/* [2] T:20.0 H:40 #0 SS:-40 */
+			size_t hash = line.find(" #");
+			if (line.compare(0, 4, "[2] ") != 0 || hash == std::string::npos) { r.inOrder = false; return; }
+			long n = atol(line.c_str() + hash + 2);
+			r.inOrder &= n > r.last;
+			r.last = n;
+			r.lines++;
+		});
+		if (fds[1].revents) readLines(err[0], errPending, [&](const std::string &line) {
+			unsigned long long rx;
+			const char *radio = strstr(line.c_str(), "radio[rx:");
+			if (!radio || sscanf(radio, "radio[rx:%llu %*s dropped:%u", &rx, &r.dropped) != 2) return;
+			r.growing &= rx > r.rx;
+			r.rx = rx;
+			r.stats++;
+		});
+	}
+	kill(daemon, SIGTERM);
+	waitpid(daemon, &r.status, 0);
+	close(out[0]);
+	close(err[0]);
+	printf("-r %s: rx:%llu in %d stats lines, dropped:%u, %ld of %ld packets on stdout\n", rate, r.rx, r.stats, r.dropped, r.lines, r.last + 1);
+	return r;
+}
+
+int main(int argc, char **argv)
+{
+	if (argc < 2) { printf("usage: %s <GatewayDaemon binary>\n", argv[0]); return 2; }
+
+	/* flat out: the receiver keeps up, the emulator drops what it cannot take */
+	Run r = run(argv[1], "2000");
+	CHECK(WIFEXITED(r.status) && WEXITSTATUS(r.status) == 0);
+	CHECK(r.stats >= SECONDS - 1);
+	CHECK(r.growing);
+	CHECK(r.inOrder);
+
+	/* a modest rate: nothing dropped on the way */
+	r = run(argv[1], "200");
+	CHECK(WIFEXITED(r.status) && WEXITSTATUS(r.status) == 0);
+	CHECK(r.stats >= SECONDS - 1);
+	CHECK(r.growing);
+	CHECK(r.dropped == 0);
+	CHECK(r.inOrder);
+	CHECK(r.lines >= (long)r.rx && r.rx > 0);
+	CHECK(r.lines >= (r.last + 1) * 98 / 100); /* out of the generated ones */
+	return testResult("GatewayDaemonTest");
+}
@@ -0,0 +1,161 @@
+/* Listen mode against the emulated radio: wake-on-radio arm/wake with 10 bit addresses, bursts,
+ * the listenModeSleep() timer and the registers written back when each of them ends.
+ * Build: g++ -O2 -pthread -DRF69_LISTENMODE_ENABLE -I../.. -o ListenModeTest ListenModeTest.cpp ../../RFM69.cpp ../Linux.cpp ../SPI.cpp ../Serial.cpp ../Emulator.cpp
+ * Run: ./ListenModeTest, exits non-zero on failure */
+
+#include <vector>
+#include <RFM69.h>
+#include <RFM69registers.h>
+#include "../Emulator.h"
+#include "Test.h"
+
+#if !defined(RF69_LISTENMODE_ENABLE)
+  #error "build with -DRF69_LISTENMODE_ENABLE"
+#endif
+
+#define IRQ_PIN   7
+#define NODEID    300 /* 10 bit addresses */
+#define BURSTER   513
+
+static const uint8_t savedRegs[] = {
+	REG_FRFMSB, REG_FRFMID, REG_FRFLSB, REG_BITRATEMSB, REG_BITRATELSB, REG_FDEVMSB, REG_FDEVLSB, REG_RXBW,
+	REG_DIOMAPPING1, REG_PACKETCONFIG1, REG_PACKETCONFIG2, REG_SYNCVALUE1, REG_SYNCVALUE2, REG_RSSITHRESH, REG_RXTIMEOUT2 };
+
+static std::vector<uint8_t> snapshot(RFM69Emulator &emu)
+{
+	std::vector<uint8_t> v;
+	for (uint8_t i = 0; i < sizeof(savedRegs); i++) v.push_back(emu.reg(savedRegs[i]));
+	return v;
+}
+
+/* burst frame as listenModeSendBurst() sends it: target, sender, CTL, ms remaining (2, LE), data */
+static void injectBurst(RFM69Emulator &emu, uint16_t to, uint16_t from, uint16_t remainingMs, const char *data)
+{
+	uint8_t frame[64];
+	uint8_t len = strlen(data);
+	frame[0] = to;
+	frame[1] = from;
+	frame[2] = ((to & 0x300) >> 6) | ((from & 0x300) >> 8);
+	frame[3] = remainingMs;
+	frame[4] = remainingMs >> 8;
+	memcpy(frame + 5, data, len);
+	emu.inject(frame, len + 5);
+}
+
+static void testWakeOnRadio(RFM69Emulator &emu, RFM69 &radio)
+{
+	std::vector<uint8_t> before = snapshot(emu);
+	radio.listenModeStart();
+	CHECK(radio.listenModeState() == RF69_LISTEN_ARMED);
+	CHECK(emu.reg(REG_OPMODE) & RF_OPMODE_LISTEN_ON);
+
+	/* same low address byte, other node: the 10 bit address must not match */
+	injectBurst(emu, NODEID & 0xFF, BURSTER, 900, "other");
+	CHECK(!waitFor([&] { return radio.listenModeReceiveDone(); }, 50));
+	CHECK(radio.listenModeState() == RF69_LISTEN_ARMED);
+
+	injectBurst(emu, NODEID, BURSTER, 700, "wake up");
+	CHECK(waitFor([&] { return radio.listenModeReceiveDone(); }, 200));
+	CHECK(radio.listenModeState() == RF69_LISTEN_WOKEN);
+	CHECK(radio.SENDERID == BURSTER);
+	CHECK(radio.TARGETID == NODEID);
+	CHECK(radio.DATALEN == 7 && strcmp((const char*)radio.DATA, "wake up") == 0);
+	CHECK(radio.RF69_LISTEN_BURST_REMAINING_MS == 700);
+	CHECK(!(emu.reg(REG_OPMODE) & RF_OPMODE_LISTEN_ON));
+
+	radio.listenModeStart(); /* armed again from WOKEN, the saved registers are kept */
+	injectBurst(emu, RF69_BROADCAST_ADDR, 2, 10, "all");
+	CHECK(waitFor([&] { return radio.listenModeReceiveDone(); }, 200));
+	CHECK(strcmp((const char*)radio.DATA, "all") == 0);
+
+	radio.listenModeEnd();
+	CHECK(radio.listenModeState() == RF69_LISTEN_OFF);
+	CHECK(snapshot(emu) == before);
+
+	/* back to normal packets */
+	emu.injectPacket(2, NODEID, "norm", 4);
+	CHECK(waitFor([&] { return radio.receiveDone(); }, 200));
+	CHECK(strcmp((const char*)radio.DATA, "norm") == 0);
+}
+
+static void testSleepTimer(RFM69Emulator &emu, RFM69 &radio)
+{
+	std::vector<uint8_t> before = snapshot(emu);
+	unsigned long start = millis();
+	radio.listenModeSleep(100);
+	CHECK(radio.listenModeState() == RF69_LISTEN_TIMER);
+	/* the pulses as the timer starts are not the end of the interval */
+	pollInterrupts(20);
+	CHECK(!radio.listenModeSleepDone());
+	/* one wait per DIO0 edge, as an MCU sleeping until it is woken */
+	uint8_t wakes = 0;
+	while (!radio.listenModeSleepDone() && millis() - start < 1000)
+		if (pollInterrupts(1000) > 0) wakes++;
+	unsigned long elapsed = millis() - start;
+	CHECK(radio.listenModeSleepDone());
+	CHECK(elapsed >= 90 && elapsed < 300);
+	CHECK(wakes >= 1);
+	radio.endListenModeSleep();
+	CHECK(radio.listenModeState() == RF69_LISTEN_OFF);
+	CHECK(snapshot(emu) == before);
+
+	emu.injectPacket(2, NODEID, "after", 5);
+	CHECK(waitFor([&] { return radio.receiveDone(); }, 200));
+	CHECK(strcmp((const char*)radio.DATA, "after") == 0);
+}
+
+static void testBurst(RFM69Emulator &emu, RFM69 &radio)
+{
+	uint32_t rx = 256, idle = 100000; /* 100ms cycle, the burst lasts as long */
+	radio.listenModeSetDurations(rx, idle);
+	radio.setAddress(BURSTER);
+	std::vector<uint8_t> before = snapshot(emu);
+	unsigned long start = millis();
+	radio.listenModeSendBurst(NODEID, "hi", 2);
+	unsigned long elapsed = millis() - start;
+	CHECK(elapsed >= 90 && elapsed < 300);
+	CHECK(snapshot(emu) == before);
+
+	std::vector<uint8_t> frame, first;
+	int frames = 0;
+	uint16_t lastRemaining = 0xFFFF;
+	bool decreasing = true;
+	while (emu.transmitted(frame)) {
+		if (!frames++) first = frame;
+		if (frame.size() < 5) continue;
+		uint16_t remaining = frame[3] | frame[4] << 8;
+		decreasing &= remaining <= lastRemaining;
+		lastRemaining = remaining;
+	}
+	CHECK(frames > 1);
+	CHECK(decreasing);
+	CHECK(first.size() == 7);
+	CHECK(first[0] == (NODEID & 0xFF) && first[1] == (BURSTER & 0xFF));
+	CHECK((first[2] & 0x0F) == (((NODEID & 0x300) >> 6) | ((BURSTER & 0x300) >> 8)));
+	CHECK(first[5] == 'h' && first[6] == 'i');
+
+	/* a broadcast burst ignores wakeAck: it runs the whole cycle without RX gaps for every node to hear it */
+	start = millis();
+	CHECK(!radio.listenModeSendBurst(RF69_BROADCAST_ADDR, "hi", 2, true));
+	elapsed = millis() - start;
+	CHECK(elapsed >= 90 && elapsed < 300);
+	CHECK(emu.transmitted(first));
+	CHECK(first.size() == 7 && !(first[2] & RFM69_CTL_REQACK));
+	while (emu.transmitted(frame)) {}
+	radio.setAddress(NODEID);
+}
+
+int main()
+{
+	SPIClass spi("emulator");
+	RFM69Emulator emu;
+	if (!emu.attach(spi, IRQ_PIN)) { printf("emulator failed to start\n"); return 1; }
+	RFM69 radio(SS, IRQ_PIN, false, &spi);
+	CHECK(radio.initialize(RF69_868MHZ, NODEID, 100));
+	radio.encrypt("sampleEncryptKey");
+
+	testWakeOnRadio(emu, radio);
+	testSleepTimer(emu, radio);
+	testBurst(emu, radio);
+	return testResult("ListenModeTest");
+}
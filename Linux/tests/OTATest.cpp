@@ -0,0 +1,171 @@
+/* OTA programming end to end: HostProgrammer feeds a HEX file over a pty to the Programmer side of RFM69_OTA
+ * (CheckForSerialHEX() on the emulated radio, as the Programmer sketch), the target node answers over the air from
+ * the emulator's onTransmit handler. Runs the streaming and the legacy lockstep protocol, with one ACK lost in each.
+ * Build: g++ -O2 -o HostProgrammer ../../Examples/WirelessProgramming_OTA/HostProgrammer/HostProgrammer.cpp
+ *        g++ -O2 -pthread -I../.. -o OTATest OTATest.cpp ../../RFM69.cpp ../../RFM69_OTA.cpp ../Linux.cpp ../SPI.cpp ../Serial.cpp ../Emulator.cpp
+ * Run: ./OTATest ./HostProgrammer, exits non-zero on failure */
+
+#include <fcntl.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <sys/wait.h>
+#include <termios.h>
+#include <unistd.h>
+#include <vector>
+#include <RFM69.h>
+#include <RFM69_OTA.h>
+#include "../Emulator.h"
+#include "Test.h"
+
+#define IRQ_PIN     7
+#define PROGRAMMER  1
+#define TARGET      123
+#define RECORDS     40
+
+/* the target side is simulated below, its flash is never used */
+SPIFlash::SPIFlash(uint8_t, uint16_t) {}
+void SPIFlash::wakeup() {}
+uint16_t SPIFlash::readDeviceId() { return 0; }
+void SPIFlash::blockErase32K(uint32_t) {}
+void SPIFlash::writeByte(uint32_t, uint8_t) {}
+void SPIFlash::writeBytes(uint32_t, const void*, uint16_t) {}
+
+/* the target node, as HandleWirelessHEXData() answers: FLX? and FLX?EOF:crc with FLX?OK, FLX:seq:data with FLX:seq:OK */
+struct Target {
+	RFM69Emulator *emu;
+	std::vector<uint8_t> image;
+	uint16_t seq;
+	uint16_t dropSeq; /* the ACK of this record is lost once */
+	bool eof;
+};
+
+static void ack(Target &t, const uint8_t *frame, const char *payload)
+{
+	uint8_t reply[64];
+	uint8_t len = strlen(payload);
+	reply[0] = frame[1];
+	reply[1] = frame[0];
+	reply[2] = 0x80; /* RFM69_CTL_SENDACK */
+	memcpy(reply + 3, payload, len);
+	t.emu->inject(reply, len + 3);
+}
+
+static void targetNode(const uint8_t *frame, uint8_t length, void *context)
+{
+	Target &t = *static_cast<Target*>(context);
+	if (length < 7 || frame[0] != TARGET || !(frame[2] & 0x40)) return; /* RFM69_CTL_REQACK */
+	const char *data = (const char*)frame + 3;
+	uint8_t dataLen = length - 3;
+	char reply[32];
+
+	if (dataLen == 4 && memcmp(data, "FLX?", 4) == 0) ack(t, frame, "FLX?OK");
+	else if (dataLen == 16 && memcmp(data, "FLX?EOF:", 8) == 0) {
+		uint32_t crc = 0xFFFFFFFF, expected;
+		for (size_t i = 0; i < t.image.size(); i++) crc = updateCRC32(crc, t.image[i]);
+		t.eof = CRC32fromHEX(data + 8, expected) && expected == ~crc;
+		ack(t, frame, t.eof ? "FLX?OK" : "FLX?NOK:CRC");
+	}
+	else if (memcmp(data, "FLX:", 4) == 0) {
+		char *end;
+		uint16_t seq = strtoul(data + 4, &end, 10);
+		if (*end != ':') return;
+		if (seq == t.seq) {
+			t.image.insert(t.image.end(), (const uint8_t*)end + 1, frame + length);
+			t.seq++;
+		}
+		else if (seq + 1 != t.seq) return;
+		if (seq == t.dropSeq) { t.dropSeq = 0xFFFF; return; }
+		snprintf(reply, sizeof(reply), "FLX:%u:OK", seq);
+		ack(t, frame, reply);
+	}
+}
+
+static std::vector<uint8_t> writeHEX(const char *path)
+{
+	std::vector<uint8_t> image;
+	FILE *f = fopen(path, "w");
+	for (uint16_t r = 0; r < RECORDS; r++) {
+		uint8_t len = r == RECORDS - 1 ? 7 : 16; /* a short last record */
+		uint16_t address = r * 16;
+		uint8_t checksum = len + (address >> 8) + address;
+		fprintf(f, ":%02X%04X00", len, address);
+		for (uint8_t i = 0; i < len; i++) {
+			uint8_t b = rand();
+			image.push_back(b);
+			checksum += b;
+			fprintf(f, "%02X", b);
+		}
+		fprintf(f, "%02X\n", (uint8_t)-checksum);
+	}
+	fprintf(f, ":00000001FF\n");
+	fclose(f);
+	return image;
+}
+
+/* Programmer sketch loop: selects the target with TO:, then hands FLX? / FLX?STREAM to CheckForSerialHEX() */
+static int program(RFM69 &radio, const char *hostProgrammer, const char *device, const char *hexFile, bool legacy)
+{
+	pid_t host = fork();
+	if (host == 0) {
+		execl(hostProgrammer, hostProgrammer, "-d", device, "-t", "123", "-f", hexFile, legacy ? "-l" : (char*)NULL, (char*)NULL);
+		_exit(127);
+	}
+	char input[115];
+	uint16_t targetID = 0;
+	int status;
+	unsigned long start = millis();
+	while (waitpid(host, &status, WNOHANG) == 0) {
+		if (millis() - start > 30000) { kill(host, SIGKILL); waitpid(host, &status, 0); return -1; }
+		uint8_t inputLen = readSerialLine(input, 10, 115, 100);
+		if (inputLen == 0) continue;
+		if (strncmp(input, "TO:", 3) == 0) {
+			targetID = atoi(input + 3);
+			Serial.print("TO:"); Serial.print(targetID); Serial.println(":OK");
+		}
+		else if ((inputLen == 4 || inputLen == 10) && strncmp(input, "FLX?", 4) == 0)
+			CheckForSerialHEX((uint8_t*)input, inputLen, radio, targetID);
+		else { Serial.print("UNKNOWN_CMD: "); Serial.println(input); }
+	}
+	return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+}
+
+int main(int argc, char **argv)
+{
+	if (argc < 2) { printf("usage: %s <HostProgrammer binary>\n", argv[0]); return 2; }
+
+	int master = posix_openpt(O_RDWR | O_NOCTTY);
+	if (master < 0 || grantpt(master) < 0 || unlockpt(master) < 0) { perror("pty"); return 1; }
+	const char *device = ptsname(master);
+	/* held open (and raw) so the master never sees a hangup between two HostProgrammer runs */
+	int slave = open(device, O_RDWR | O_NOCTTY);
+	struct termios tty;
+	tcgetattr(slave, &tty);
+	cfmakeraw(&tty);
+	tcsetattr(slave, TCSANOW, &tty);
+	Serial.setFd(master);
+
+	char hexFile[] = "/tmp/OTATestXXXXXX";
+	close(mkstemp(hexFile));
+	std::vector<uint8_t> image = writeHEX(hexFile);
+
+	SPIClass spi("emulator");
+	RFM69Emulator emu;
+	if (!emu.attach(spi, IRQ_PIN)) { printf("emulator failed to start\n"); return 1; }
+	RFM69 radio(SS, IRQ_PIN, false, &spi);
+	CHECK(radio.initialize(RF69_868MHZ, PROGRAMMER, 100));
+
+	for (int legacy = 0; legacy < 2; legacy++) {
+		Target target = { &emu, std::vector<uint8_t>(), 0, (uint16_t)(legacy ? 5 : 2), false };
+		emu.onTransmit(targetNode, &target);
+		CHECK(program(radio, argv[1], device, hexFile, legacy) == 0);
+		emu.onTransmit(NULL, NULL);
+		CHECK(target.image == image);
+		CHECK(target.seq == RECORDS);
+		CHECK(target.dropSeq == 0xFFFF);
+		CHECK(target.eof);
+	}
+
+	unlink(hexFile);
+	close(slave);
+	return testResult("OTATest");
+}
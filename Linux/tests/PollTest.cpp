@@ -0,0 +1,183 @@
+/* Coordinated polling: RFM69_Queue::removeThrough() only drops the sent commands a node confirmed, across the 16 bit
+ * wrap too, and RFM69_PollGateway on the emulated radio answers a node's polls (injected) batch by batch. A reply
+ * lost on air is sent again, even when the stale confirmation's seq came around again on a newer command.
+ * Build: g++ -O2 -pthread -I../.. -o PollTest PollTest.cpp ../../RFM69.cpp ../../RFM69_Queue.cpp ../../RFM69_Poll.cpp ../Linux.cpp ../SPI.cpp ../Serial.cpp ../Emulator.cpp
+ * Run: ./PollTest, exits non-zero on failure */
+
+#include <string>
+#include <vector>
+#include <RFM69.h>
+#include <RFM69_Queue.h>
+#include <RFM69_Poll.h>
+#include "../Emulator.h"
+#include "Test.h"
+
+#define IRQ_PIN   7
+#define GATEWAY   1
+#define NODE      2
+#define OTHER     3    /* another node with commands queued */
+#define FILLER    4    /* its commands only move the shared seq on */
+#define SAMEBUCKET (NODE + RFM69_QUEUE_BUCKETS)
+
+/* the seq the next insert gets */
+static uint16_t nextSeq(RFM69_Queue &queue)
+{
+	queue.insert(FILLER, "x");
+	uint16_t seq = queue.get(queue.first(FILLER)).seq;
+	queue.remove(FILLER);
+	return seq + 1;
+}
+
+/* inserts and drops commands for FILLER until the next insert gets seq */
+static void advanceTo(RFM69_Queue &queue, uint16_t seq)
+{
+	while (nextSeq(queue) != seq) {}
+}
+
+static uint8_t count(RFM69_Queue &queue, uint16_t nodeId)
+{
+	uint8_t n = 0;
+	for (uint8_t i = queue.first(nodeId); i != RFM69_QUEUE_NONE; i = queue.next(i)) n++;
+	return n;
+}
+
+static uint16_t insert(RFM69_Queue &queue, uint16_t nodeId, const char *data, bool sent)
+{
+	queue.insert(nodeId, data);
+	uint8_t last = queue.first(nodeId);
+	while (queue.next(last) != RFM69_QUEUE_NONE) last = queue.next(last);
+	if (sent) queue.markSent(last);
+	return queue.get(last).seq;
+}
+
+static void testRemoveThrough()
+{
+	RFM69_Request slots[8];
+	RFM69_Queue queue(slots, 8);
+
+	uint16_t a = insert(queue, NODE, "a", true);
+	uint16_t b = insert(queue, NODE, "b", true);
+	insert(queue, SAMEBUCKET, "s", true);
+	uint16_t c = insert(queue, NODE, "c", false);
+	CHECK(queue.removeThrough(NODE, c) == 0);     /* c was never sent, nothing to confirm */
+	CHECK(queue.removeThrough(NODE, b) == 2);
+	CHECK(count(queue, NODE) == 1 && count(queue, SAMEBUCKET) == 1);
+	CHECK(queue.removeThrough(NODE, b) == 0);     /* a repeated confirmation */
+	CHECK(queue.removeThrough(NODE, a) == 0);     /* an older one */
+	queue.markSent(queue.first(NODE));
+	CHECK(queue.removeThrough(NODE, c) == 1);
+	CHECK(queue.size() == 1);
+	queue.clear();
+
+	/* across the wrap */
+	advanceTo(queue, 0xFFFE);
+	uint16_t w0 = insert(queue, NODE, "w0", true);
+	uint16_t w1 = insert(queue, NODE, "w1", true);
+	uint16_t w2 = insert(queue, NODE, "w2", true);
+	CHECK(w0 == 0xFFFE && w1 == 0xFFFF && w2 == 0);
+	CHECK(queue.removeThrough(NODE, 0xFFFD) == 0);
+	CHECK(queue.removeThrough(NODE, w1) == 2);
+	CHECK(queue.removeThrough(NODE, w2) == 1);
+	CHECK(queue.size() == 0);
+
+	/* a confirmation the numbers came around to again: the newer command has not been sent */
+	uint16_t stale = insert(queue, NODE, "old", true);
+	CHECK(queue.removeThrough(NODE, stale) == 1);
+	advanceTo(queue, stale);
+	CHECK(insert(queue, NODE, "new", false) == stale);
+	CHECK(queue.removeThrough(NODE, stale) == 0);
+	CHECK(count(queue, NODE) == 1);
+}
+
+struct Reply {
+	uint8_t flags;
+	uint16_t sleep;
+	uint16_t seq;
+	std::vector<std::string> commands;
+};
+
+static uint16_t getWord(const uint8_t *p) { return p[0] | (uint16_t)p[1] << 8; }
+
+/* NODE polls, confirming seq if confirm: true if the gateway answered, its reply in r */
+static bool poll(RFM69Emulator &emu, RFM69 &radio, RFM69_PollGateway &poller, bool confirm, uint16_t seq, Reply &r)
+{
+	uint8_t frame[7] = { GATEWAY, NODE, RFM69_CTL_REQACK, RFM69_POLL_MARKER, (uint8_t)(confirm ? RFM69_POLL_CONFIRM : 0), (uint8_t)seq, (uint8_t)(seq >> 8) };
+	std::vector<uint8_t> ack;
+	while (emu.transmitted(ack)) {}
+	emu.inject(frame, confirm ? 7 : 5);
+	if (!waitFor([&] { return radio.receiveDone(); }, 100)) return false;
+	CHECK(poller.reply());
+	if (!emu.transmitted(ack) || ack.size() < 3 + RFM69_POLL_HEADERLEN || ack[0] != NODE || !(ack[2] & RFM69_CTL_SENDACK)) return false;
+	const uint8_t *p = ack.data() + 3;
+	if (p[0] != RFM69_POLL_MARKER) return false;
+	r.flags = p[1];
+	r.sleep = getWord(p + 2);
+	r.seq = getWord(p + 4);
+	r.commands.clear();
+	for (size_t i = 3 + RFM69_POLL_HEADERLEN; i < ack.size(); i += r.commands.back().size() + 1)
+		r.commands.push_back(std::string((const char*)ack.data() + i));
+	return true;
+}
+
+/* commands of 24 chars, 2 fit in a reply */
+static std::string command(int n)
+{
+	char buf[32];
+	snprintf(buf, sizeof(buf), "command %02d ..............", n);
+	return buf;
+}
+
+static void testRoundTrip(RFM69Emulator &emu, RFM69 &radio)
+{
+	RFM69_Request slots[16];
+	RFM69_Queue queue(slots, 16);
+	RFM69_PollGateway poller(radio, queue, 60);
+	for (int n = 0; n < 5; n++) queue.insert(NODE, command(n).c_str());
+	insert(queue, OTHER, "other", false);
+
+	Reply r;
+	CHECK(poll(emu, radio, poller, false, 0, r));
+	CHECK(r.commands.size() == 2 && r.commands[0] == command(0) && r.commands[1] == command(1));
+	CHECK((r.flags & RFM69_POLL_MORE) && r.sleep == 0);
+	uint16_t confirmed = r.seq;
+
+	/* the reply with commands 2 and 3 is lost: the node knows nothing of it */
+	CHECK(poll(emu, radio, poller, true, confirmed, r));
+	CHECK(r.commands.size() == 2 && r.commands[0] == command(2));
+	CHECK(count(queue, NODE) == 3);
+
+	/* it sleeps long, meanwhile the shared numbers come around to its stale confirmation */
+	advanceTo(queue, confirmed);
+	CHECK(insert(queue, NODE, command(5).c_str(), false) == confirmed);
+
+	/* confirming the first batch again: nothing it did not get is dropped, the lost one is sent again */
+	CHECK(poll(emu, radio, poller, true, confirmed, r));
+	CHECK(r.commands.size() == 2 && r.commands[0] == command(2) && r.commands[1] == command(3));
+	CHECK(count(queue, NODE) == 4);
+
+	std::vector<std::string> delivered(r.commands);
+	while (r.flags & RFM69_POLL_MORE) {
+		if (!poll(emu, radio, poller, true, r.seq, r)) break;
+		delivered.insert(delivered.end(), r.commands.begin(), r.commands.end());
+	}
+	CHECK(delivered.size() == 4 && delivered[2] == command(4) && delivered[3] == command(5));
+	CHECK(r.sleep == 60);
+
+	/* the last batch confirmed */
+	CHECK(poll(emu, radio, poller, true, r.seq, r));
+	CHECK(r.commands.empty() && !(r.flags & RFM69_POLL_MORE) && r.sleep == 60);
+	CHECK(count(queue, NODE) == 0 && count(queue, OTHER) == 1);
+}
+
+int main()
+{
+	testRemoveThrough();
+
+	SPIClass spi("emulator");
+	RFM69Emulator emu;
+	if (!emu.attach(spi, IRQ_PIN)) { printf("emulator failed to start\n"); return 1; }
+	RFM69 radio(SS, IRQ_PIN, false, &spi);
+	CHECK(radio.initialize(RF69_868MHZ, GATEWAY, 100));
+	testRoundTrip(emu, radio);
+	return testResult("PollTest");
+}
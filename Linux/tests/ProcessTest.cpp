@@ -0,0 +1,70 @@
+/* Event API against the emulated radio: process() hands every packet of a steady stream to onPacket(),
+ * with and without keepReceiving().
+ * Build: g++ -O2 -pthread -I../.. -o ProcessTest ProcessTest.cpp ../../RFM69.cpp ../Linux.cpp ../SPI.cpp ../Serial.cpp ../Emulator.cpp
+ * Run: ./ProcessTest, exits non-zero on failure */
+
+#include <thread>
+#include <unistd.h>
+#include <RFM69.h>
+#include "../Emulator.h"
+#include "Test.h"
+
+#define IRQ_PIN   7
+#define NODEID    1
+#define SENDER    2
+#define PACKETS   3000
+
+struct Received {
+	uint16_t count;
+	uint16_t next;   /* the number the next packet should carry */
+	bool inOrder;
+};
+
+static void onPacket(RFM69 &radio, const RFM69_Packet &packet, void *context)
+{
+	(void)radio;
+	Received &r = *static_cast<Received*>(context);
+	uint16_t n = packet.data[0] | packet.data[1] << 8;
+	r.inOrder &= packet.senderId == SENDER && packet.dataLen == 2 && n == r.next;
+	r.next = n + 1;
+	r.count++;
+}
+
+/* one packet about every ms, as a busy network would */
+static void sendStream(RFM69Emulator *emu)
+{
+	for (uint16_t i = 0; i < PACKETS; i++) {
+		uint8_t data[2] = { (uint8_t)i, (uint8_t)(i >> 8) };
+		emu->injectPacket(SENDER, NODEID, data, sizeof(data));
+		usleep(1000);
+	}
+}
+
+static void testStream(RFM69Emulator &emu, RFM69 &radio, bool keep)
+{
+	Received r = { 0, 0, true };
+	radio.onPacket(onPacket, &r);
+	radio.keepReceiving(keep);
+	std::thread sender(sendStream, &emu);
+	unsigned long last = millis();
+	while (r.count < PACKETS && millis() - last < 500) /* 500ms without a packet: the rest is lost */
+		if (radio.process()) last = millis();
+	sender.join();
+	if (r.count != PACKETS) printf("keepReceiving(%d): %u of %u packets\n", keep, r.count, PACKETS);
+	CHECK(r.count == PACKETS);
+	CHECK(r.inOrder);
+	radio.onPacket(NULL);
+}
+
+int main()
+{
+	SPIClass spi("emulator");
+	RFM69Emulator emu;
+	if (!emu.attach(spi, IRQ_PIN)) { printf("emulator failed to start\n"); return 1; }
+	RFM69 radio(SS, IRQ_PIN, false, &spi);
+	CHECK(radio.initialize(RF69_868MHZ, NODEID, 100));
+
+	testStream(emu, radio, false);
+	testStream(emu, radio, true);
+	return testResult("ProcessTest");
+}
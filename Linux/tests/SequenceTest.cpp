@@ -0,0 +1,93 @@
+/* Duplicate suppression against the emulated radio: only packets the application got are remembered, a retry
+ * within RF69_DUP_WINDOW_MS is re-ACKed and not delivered, after that the same sequence number is a new packet.
+ * Build: g++ -O2 -pthread -I../.. -o SequenceTest SequenceTest.cpp ../../RFM69.cpp ../Linux.cpp ../SPI.cpp ../Serial.cpp ../Emulator.cpp
+ * Run: ./SequenceTest, exits non-zero on failure */
+
+#include <RFM69.h>
+#include "../Emulator.h"
+#include "Test.h"
+
+#define IRQ_PIN   7
+#define GATEWAY   1
+#define SENDER    2 /* reports with sequence numbers */
+#define NODE      3 /* the gateway sends it a command */
+
+struct Air {
+	RFM69Emulator *emu;
+	uint8_t acksToSender;
+	bool reportSent;
+};
+
+/* a report from SENDER as enableSequenceNumbers() sends it: target, sender, CTL, seq, data */
+static void injectReport(RFM69Emulator &emu, uint8_t seq)
+{
+	uint8_t frame[] = { GATEWAY, SENDER, RFM69_CTL_SEQ | RFM69_CTL_REQACK, seq, 'r', 'e', 'p' };
+	emu.inject(frame, sizeof(frame));
+}
+
+static void peers(const uint8_t *frame, uint8_t length, void *context)
+{
+	Air &air = *static_cast<Air*>(context);
+	if (length < 3) return;
+	if (frame[0] == SENDER && (frame[2] & RFM69_CTL_SENDACK)) air.acksToSender++;
+	if (frame[0] == NODE && (frame[2] & RFM69_CTL_REQACK)) {
+		if (!air.reportSent) { injectReport(*air.emu, 7); air.reportSent = true; } /* dropped by the gateway's ACK wait */
+		uint8_t ack[3] = { GATEWAY, NODE, RFM69_CTL_SENDACK };
+		air.emu->inject(ack, sizeof(ack));
+	}
+}
+
+/* packets delivered to the application within ms */
+static int receive(RFM69 &radio, unsigned long ms)
+{
+	int delivered = 0;
+	unsigned long start = millis();
+	while (millis() - start < ms) {
+		if (radio.receiveDone()) {
+			CHECK(radio.SENDERID == SENDER && radio.DATALEN == 3 && memcmp(radio.DATA, "rep", 3) == 0);
+			if (radio.ACKRequested()) radio.sendACK();
+			delivered++;
+		}
+		pollInterrupts(2);
+	}
+	return delivered;
+}
+
+int main()
+{
+	SPIClass spi("emulator");
+	RFM69Emulator emu;
+	if (!emu.attach(spi, IRQ_PIN)) { printf("emulator failed to start\n"); return 1; }
+	RFM69 radio(SS, IRQ_PIN, false, &spi);
+	CHECK(radio.initialize(RF69_868MHZ, GATEWAY, 100));
+
+	Air air = { &emu, 0, false };
+	emu.onTransmit(peers, &air);
+	CHECK(radio.sendWithRetry(NODE, "cmd", 3, 2, 50));
+	CHECK(air.reportSent && air.acksToSender == 0);
+
+	/* its retry is the first copy the application gets */
+	injectReport(emu, 7);
+	CHECK(receive(radio, 50) == 1);
+	CHECK(air.acksToSender == 1);
+	CHECK(radio.getDuplicateCount() == 0);
+
+	/* the ACK got lost, the sender retries: ACKed again, not delivered */
+	injectReport(emu, 7);
+	CHECK(receive(radio, 50) == 0);
+	CHECK(air.acksToSender == 2);
+	CHECK(radio.getDuplicateCount() == 1);
+
+	/* the next packet */
+	injectReport(emu, 8);
+	CHECK(receive(radio, 50) == 1);
+
+	/* the sender rebooted and starts over at the same number, long after its last retry */
+	delay(RF69_DUP_WINDOW_MS);
+	injectReport(emu, 8);
+	CHECK(receive(radio, 50) == 1);
+	CHECK(radio.getDuplicateCount() == 1);
+
+	emu.onTransmit(NULL, NULL);
+	return testResult("SequenceTest");
+}
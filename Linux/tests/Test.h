@@ -0,0 +1,30 @@
+#pragma once
+
+/* Minimal checks for the tests running the driver against the emulated radio (Linux/Emulator.h).
+ * Each test is a program that prints the failed checks and exits non-zero:
+ *
+ *   int main() { CHECK(1 + 1 == 2); return testResult("example"); } */
+
+#include <stdio.h>
+#include "../Linux.h"
+
+static int testFailures = 0;
+
+#define CHECK(cond) do { if (!(cond)) { testFailures++; printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); } } while (0)
+
+/* polls the DIO0 interrupts until done() is true or ms elapse */
+template <typename Done> static bool waitFor(Done done, unsigned long ms)
+{
+	unsigned long start = millis();
+	while (!done()) {
+		if (millis() - start > ms) return false;
+		pollInterrupts(2);
+	}
+	return true;
+}
+
+static int testResult(const char *name)
+{
+	printf("%s: %s\n", name, testFailures ? "FAILED" : "OK");
+	return testFailures ? 1 : 0;
+}
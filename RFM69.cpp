@@ -25,7 +25,6 @@
 // **********************************************************************************
 #include "RFM69.h"
 #include "RFM69registers.h"
-#include "STM32/SPI.h"
 
 uint8_t RFM69::DATA[RF69_MAX_DATA_LEN+1];
 uint8_t RFM69::_mode;        // current transceiver state
@@ -36,7 +35,18 @@ uint8_t RFM69::PAYLOADLEN;
 uint8_t RFM69::ACK_REQUESTED;
 uint8_t RFM69::ACK_RECEIVED; // should be polled immediately after sending a packet with ACK request
 int16_t RFM69::RSSI;          // most accurate RSSI during reception (closest to the reception)
+uint32_t RFM69::TIMESTAMP;     // micros() at sync detection (sync capture mode)
 volatile bool RFM69::_haveData;
+bool RFM69::_syncCapture;
+volatile bool RFM69::_syncSeen;
+volatile uint32_t RFM69::_syncTime;
+bool RFM69::_ackSent;         // last packet was auto-ACKed
+volatile uint8_t RFM69::_listenTimerEdges;
+#if defined(RF69_FEC_ENABLE)
+uint8_t RFM69::_fecBuf[64];
+uint8_t RFM69::_fecLen;
+uint8_t RFM69::_fecPos;
+#endif
 
 #ifdef STM32IDE
 RFM69::RFM69(struct gpio_pin &slaveSelectPin, struct gpio_pin &interruptPin, bool isRFM69HW, SPIClass *spi)
@@ -51,9 +61,59 @@ RFM69::RFM69(uint8_t slaveSelectPin, uint8_t interruptPin, bool isRFM69HW, SPICl
   _powerLevel = 31;
   _isRFM69HW = isRFM69HW;
   _spi = spi;
+  _onPacket = _onAck = 0;
+  _onTxDone = 0;
+  _onPacketContext = _onAckContext = _onTxDoneContext = 0;
+  _keepReceiving = false;
+  _dispatching = false;
+  _txDonePending = false;
+  _txDoneAddress = 0;
+  _autoACK = false;
+  _dropData = false;
+  for (uint8_t i = 0; i < RF69_AUTOACK_PAYLOADS; i++) _ackPayloads[i].size = 0;
+  for (uint8_t i = 0; i < RF69_RTT_PEERS; i++) _rtt[i].nodeId = 0;
+  _rttNext = 0;
+  _ackTimeoutMin = RFM69_ACK_TIMEOUT_MIN;
+  _ackTimeoutMax = RFM69_ACK_TIMEOUT_MAX;
+  for (uint8_t i = 0; i < RF69_DUP_SENDERS; i++) _rxSeq[i].nodeId = 0;
+  _rxSeqNext = 0;
+  _txSeq = 0;
+  _sequenceNumbers = false;
+  _resend = false;
+  _duplicates = 0;
+  _scanFRF = 0;
+  _syncLatched = false;
+  _syncRSSI = 0;
+  _parkMode = RF69_MODE_STANDBY;
+  _preloading = _preloaded = false;
+  _txStart = 0;
+  _turnaround = _txTime = 0;
+  memset(_transition, 0, sizeof(_transition));
+  _modeFrom = RF69_MODE_STANDBY;
+  _modeSwitchAt = 0;
+  _modePending = false;
+  _planned = false;
+  _planAt = 0;
+  _planTo = 0;
+  _planBuffer = 0;
+  _planSize = 0;
+  _planACK = false;
+  _scanMode = RF69_MODE_STANDBY;
+#if defined(RF69_ENERGY_ENABLE)
+  _currents = 0;
+  _packetCharge = 0;
+  resetEnergy();
+#endif
+#if defined(RF69_FEC_ENABLE)
+  _fec = false;
+  _fecCorrected = _fecFailed = 0;
+#endif
+  _listenState = RF69_LISTEN_OFF;
+  memset(_listenSaved, 0, sizeof(_listenSaved));
 #if defined(RF69_LISTENMODE_ENABLE)
   _isHighSpeed = true;
-  _haveEncryptKey = false;
+  _listenAckGap = 0;
+  _listenRxTime = 0;
   uint32_t rxDuration = DEFAULT_LISTEN_RX_US;
   uint32_t idleDuration = DEFAULT_LISTEN_IDLE_US;
   listenModeSetDurations(rxDuration, idleDuration);
@@ -151,42 +211,67 @@ bool RFM69::initialize(uint8_t freqBand, uint16_t nodeID, uint8_t networkID)
   attachInterrupt(_interruptNum, RFM69::isr0, RISING);
 
   _address = nodeID;
-#if defined(RF69_LISTENMODE_ENABLE)
-  selfPointer = this;
-  _freqBand = freqBand;
-  _networkID = networkID;
+#if defined(RF69_ENERGY_ENABLE)
+  resetEnergy();
 #endif
+  _listenState = RF69_LISTEN_OFF; // the registers were just configured
   return true;
 }
 
 // return the frequency (in Hz)
 uint32_t RFM69::getFrequency()
 {
-  return RF69_FSTEP * (((uint32_t) readReg(REG_FRFMSB) << 16) + ((uint16_t) readReg(REG_FRFMID) << 8) + readReg(REG_FRFLSB));
+  return RF69_frfToHz(getFRF());
 }
 
 // set the frequency (in Hz)
 void RFM69::setFrequency(uint32_t freqHz)
+{
+  setFRF(RF69_hzToFRF(freqHz));
+}
+
+// return the FRF registers, read in one burst
+uint32_t RFM69::getFRF()
+{
+  select();
+  _spi->transfer(REG_FRFMSB & 0x7F);
+  uint32_t frf = (uint32_t)_spi->transfer(0) << 16;
+  frf |= (uint16_t)_spi->transfer(0) << 8;
+  frf |= _spi->transfer(0);
+  unselect();
+  return frf;
+}
+
+// set the FRF registers in one burst (the address auto increments), the radio applies them when FRFLSB is written
+void RFM69::setFRF(uint32_t frf)
 {
   uint8_t oldMode = _mode;
   if (oldMode == RF69_MODE_TX) {
     setMode(RF69_MODE_RX);
   }
-  freqHz /= RF69_FSTEP; // divide down by FSTEP to get FRF
-  writeReg(REG_FRFMSB, freqHz >> 16);
-  writeReg(REG_FRFMID, freqHz >> 8);
-  writeReg(REG_FRFLSB, freqHz);
-  if (oldMode == RF69_MODE_RX) {
-    setMode(RF69_MODE_SYNTH);
+  select();
+  _spi->transfer(REG_FRFMSB | 0x80);
+  _spi->transfer(frf >> 16);
+  _spi->transfer(frf >> 8);
+  _spi->transfer(frf);
+  unselect();
+  if (oldMode == RF69_MODE_RX) { // relock the PLL and restart the receiver, much faster than a round trip through SYNTH
+    writeReg(REG_PACKETCONFIG2, (readReg(REG_PACKETCONFIG2) & 0xFB) | RF_PACKET2_RXRESTART);
   }
   setMode(oldMode);
 }
 
 void RFM69::setMode(uint8_t newMode)
 {
-  if (newMode == _mode)
+  if (newMode == _mode) {
+    _modePending = false; // a later waitModeReady() must not profile an older switch nobody waited on
     return;
+  }
 
+  accountMode();
+  _modeFrom = _mode;
+  _modeSwitchAt = micros();
+  _modePending = true;
   switch (newMode) {
     case RF69_MODE_TX:
       writeReg(REG_OPMODE, (readReg(REG_OPMODE) & 0xE3) | RF_OPMODE_TRANSMITTER);
@@ -195,6 +280,7 @@ void RFM69::setMode(uint8_t newMode)
     case RF69_MODE_RX:
       writeReg(REG_OPMODE, (readReg(REG_OPMODE) & 0xE3) | RF_OPMODE_RECEIVER);
       if (_isRFM69HW) setHighPowerRegs(false);
+      _preloaded = false; // received bytes go to the FIFO
       break;
     case RF69_MODE_SYNTH:
       writeReg(REG_OPMODE, (readReg(REG_OPMODE) & 0xE3) | RF_OPMODE_SYNTHESIZER);
@@ -204,18 +290,208 @@ void RFM69::setMode(uint8_t newMode)
       break;
     case RF69_MODE_SLEEP:
       writeReg(REG_OPMODE, (readReg(REG_OPMODE) & 0xE3) | RF_OPMODE_SLEEP);
+      _preloaded = false; // the FIFO is not kept in sleep
       break;
     default:
+      _modePending = false;
       return;
   }
 
+  _mode = newMode;
   // we are using packet mode, so this check is not really needed
   // but waiting for mode ready is necessary when going from sleep because the FIFO may not be immediately available from previous mode
-  while (_mode == RF69_MODE_SLEEP && (readReg(REG_IRQFLAGS1) & RF_IRQFLAGS1_MODEREADY) == 0x00); // wait for ModeReady
+  if (_modeFrom == RF69_MODE_SLEEP) waitModeReady();
+}
 
-  _mode = newMode;
+// internal function - waits for ModeReady and adds the time since the last setMode() to the profile
+void RFM69::waitModeReady()
+{
+  while ((readReg(REG_IRQFLAGS1) & RF_IRQFLAGS1_MODEREADY) == 0x00); // wait for ModeReady
+  if (!_modePending) return;
+  _modePending = false;
+  uint32_t us = micros() - _modeSwitchAt;
+  uint16_t& avg = _transition[_modeFrom][_mode];
+  if (us > 0xFFFF) us = 0xFFFF;
+  avg = avg ? avg + ((int32_t)us - avg) / 4 : (us ? us : 1);
+}
+
+// typical figures (datasheet 2.4.5): crystal start TS_OSC, PLL lock TS_FS, PA ramp + TS_TR, receiver start TS_RE
+static uint16_t typicalTransition(uint8_t fromMode, uint8_t toMode)
+{
+  if (toMode <= fromMode && toMode <= RF69_MODE_SYNTH) return 1; // powering down, or RX/TX back to SYNTH
+  uint16_t us = 0;
+  if (fromMode == RF69_MODE_SLEEP) us += 250;
+  if (fromMode <= RF69_MODE_STANDBY && toMode >= RF69_MODE_SYNTH) us += 60;
+  if (toMode == RF69_MODE_TX) us += 45;
+  if (toMode == RF69_MODE_RX) us += 100;
+  return us;
+}
+
+uint16_t RFM69::getTransitionTime(uint8_t fromMode, uint8_t toMode)
+{
+  if (fromMode > RF69_MODE_TX || toMode > RF69_MODE_TX) return 0;
+  uint16_t us = _transition[fromMode][toMode];
+  return us ? us : typicalTransition(fromMode, toMode);
+}
+
+// measures the transitions the driver and the scheduler rely on (not TX: it would key the transmitter)
+void RFM69::profileTransitions()
+{
+  static const uint8_t steps[] = { RF69_MODE_SLEEP, RF69_MODE_STANDBY, RF69_MODE_SYNTH, RF69_MODE_RX, RF69_MODE_STANDBY,
+                                   RF69_MODE_RX, RF69_MODE_SYNTH, RF69_MODE_STANDBY, RF69_MODE_SLEEP, RF69_MODE_SYNTH };
+  uint8_t oldMode = _mode;
+  for (uint8_t i = 0; i < sizeof(steps); i++) {
+    setMode(steps[i]);
+    if (steps[i] != RF69_MODE_SLEEP) waitModeReady();
+  }
+  _haveData = false; // nothing was received in the RX steps
+  if (oldMode == RF69_MODE_RX) receiveBegin();
+  else {
+    setMode(oldMode);
+    waitModeReady();
+  }
+}
+
+uint32_t RFM69::getWarmupTime(uint8_t fromMode)
+{
+  uint32_t us = RF69_WARMUP_MARGIN_US + getTransitionTime(RF69_MODE_SYNTH, RF69_MODE_TX);
+  if (fromMode == RF69_MODE_SYNTH) return us;
+  us += getTransitionTime(RF69_MODE_STANDBY, RF69_MODE_SYNTH);
+  if (fromMode == RF69_MODE_SLEEP) us += getTransitionTime(RF69_MODE_SLEEP, RF69_MODE_STANDBY);
+  return us;
+}
+
+void RFM69::scheduleSend(uint32_t atMicros, uint16_t toAddress, const void* buffer, uint8_t bufferSize, bool requestACK)
+{
+  _planAt = atMicros;
+  _planTo = toAddress;
+  _planBuffer = buffer;
+  _planSize = bufferSize;
+  _planACK = requestACK;
+  _planned = true;
+}
+
+bool RFM69::updateSchedule()
+{
+  if (!_planned) return false;
+  int32_t left = _planAt - micros();
+  if (_mode == RF69_MODE_SLEEP && left > (int32_t)getWarmupTime(RF69_MODE_SLEEP)) return false;
+  if (_mode != RF69_MODE_SLEEP && left > (int32_t)getWarmupTime(RF69_MODE_STANDBY)) return false;
+
+  if (_mode == RF69_MODE_SLEEP) setMode(RF69_MODE_STANDBY); // oscillator first, waits for it
+  if (_mode != RF69_MODE_SYNTH) { // then the PLL, the frame goes to the FIFO while it locks
+    setMode(RF69_MODE_SYNTH);
+    waitModeReady();
+  }
+  if (!_preloaded) preloadFrame(_planTo, _planBuffer, _planSize, _planACK);
+  uint16_t ramp = getTransitionTime(RF69_MODE_SYNTH, RF69_MODE_TX);
+  while ((int32_t)(_planAt - micros()) > (int32_t)ramp); // the last stretch is too short to leave
+  _planned = false;
+  return sendPreloaded();
 }
 
+#if defined(RF69_ENERGY_ENABLE)
+//=============================================================================
+// energy accounting
+//=============================================================================
+// typical SX1231H figures (datasheet 2.5.1), PA1+PA2 below +17dBm estimated: measure your board and use setCurrentTable() for better numbers
+const RFM69_CurrentTable RFM69W_CURRENTS  = { 100, 1250000, 9000000, 16000000, { -18, 0, 10, 13 }, { 14000000, 20000000, 33000000, 45000000 } };
+const RFM69_CurrentTable RFM69HW_CURRENTS = { 100, 1250000, 9000000, 16000000, { 5, 13, 17, 20 }, { 40000000, 60000000, 95000000, 130000000 } };
+
+void RFM69::resetEnergy()
+{
+  memset(_residencyMs, 0, sizeof(_residencyMs));
+  memset(_residencyUs, 0, sizeof(_residencyUs));
+  _charge = _packetStart = 0;
+  _modeSinceMs = millis();
+  _modeSinceUs = micros();
+}
+
+// internal function - adds the time since the last call to the current mode
+void RFM69::accountMode()
+{
+  uint32_t nowMs = millis();
+  uint32_t nowUs = micros();
+  uint32_t ms = nowMs - _modeSinceMs;
+  uint32_t us = nowUs - _modeSinceUs;
+  _modeSinceMs = nowMs;
+  _modeSinceUs = nowUs;
+  if (ms < 60000) addModeTime(us / 1000, us % 1000);
+  else addModeTime(ms, 0); // micros() wraps every ~71 minutes
+}
+
+void RFM69::addModeTime(uint32_t ms, uint16_t us)
+{
+  uint32_t nA = modeCurrent(_mode);
+  _charge += (uint64_t)nA * ms + (uint64_t)nA * us / 1000;
+  _residencyUs[_mode] += us;
+  if (_residencyUs[_mode] >= 1000) { _residencyUs[_mode] -= 1000; ms++; }
+  _residencyMs[_mode] += ms;
+}
+
+void RFM69::addSleepTime(uint32_t ms)
+{
+  accountMode();
+  addModeTime(ms, 0);
+}
+
+uint32_t RFM69::modeCurrent(uint8_t mode)
+{
+  const RFM69_CurrentTable* t = _currents ? _currents : (_isRFM69HW ? &RFM69HW_CURRENTS : &RFM69W_CURRENTS);
+  switch (mode) {
+    case RF69_MODE_SLEEP: return t->sleep;
+    case RF69_MODE_STANDBY: return t->standby;
+    case RF69_MODE_SYNTH: return t->synth;
+    case RF69_MODE_RX: return t->rx;
+  }
+  int8_t dBm = getOutputDBm();
+  if (dBm <= t->txDBm[0]) return t->tx[0];
+  for (uint8_t i = 1; i < 4; i++)
+    if (dBm <= t->txDBm[i])
+      return t->tx[i-1] + (uint64_t)(t->tx[i] - t->tx[i-1]) * (dBm - t->txDBm[i-1]) / (t->txDBm[i] - t->txDBm[i-1]);
+  return t->tx[3];
+}
+
+// the power level ranges documented at setPowerLevel(), RFM69HW levels include the high power settings used in TX
+int8_t RFM69::getOutputDBm()
+{
+  return _isRFM69HW ? 5 + _powerLevel : -18 + _powerLevel;
+}
+
+uint32_t RFM69::getResidency(uint8_t mode)
+{
+  accountMode();
+  return mode <= RF69_MODE_TX ? _residencyMs[mode] : 0;
+}
+
+uint32_t RFM69::getCharge()
+{
+  accountMode();
+  return _charge / 1000000;
+}
+
+// internal function - average current in nA
+static uint32_t averageCurrent(uint64_t charge, const uint32_t* residencyMs)
+{
+  uint32_t ms = 0;
+  for (uint8_t i = 0; i <= RF69_MODE_TX; i++) ms += residencyMs[i];
+  return ms ? charge / ms : 0;
+}
+
+uint32_t RFM69::getAverageCurrent()
+{
+  accountMode();
+  return averageCurrent(_charge, _residencyMs) / 1000;
+}
+
+uint32_t RFM69::getBatteryLife(uint32_t mAh, uint32_t otherUA)
+{
+  accountMode();
+  uint32_t nA = averageCurrent(_charge, _residencyMs) + otherUA * 1000;
+  return nA ? (uint64_t)mAh * 1000000 / nA : 0xFFFFFFFF;
+}
+#endif
+
 //put transceiver in sleep mode to save battery - to wake or resume receiving just call receiveDone()
 void RFM69::sleep() {
   setMode(RF69_MODE_SLEEP);
@@ -257,18 +533,35 @@ bool RFM69::canSend()
 {
   if (_mode == RF69_MODE_RX && PAYLOADLEN == 0 && readRSSI() < CSMA_LIMIT) // if signal stronger than -100dBm is detected assume channel activity
   {
-    setMode(RF69_MODE_STANDBY);
+    setMode(_parkMode);
     return true;
   }
   return false;
 }
 
+// listens until the channel is free (true) or limitMs passed. Packets heard meanwhile are dropped,
+// so they are not auto-ACKed either: their senders retry
+bool RFM69::waitCanSend(uint32_t limitMs)
+{
+  uint32_t now = millis();
+  bool free;
+  _dropData = true;
+  while (!(free = canSend()) && millis() - now < limitMs) receiveDone();
+  _dropData = false;
+  return free;
+}
+
 void RFM69::send(uint16_t toAddress, const void* buffer, uint8_t bufferSize, bool requestACK)
 {
   writeReg(REG_PACKETCONFIG2, (readReg(REG_PACKETCONFIG2) & 0xFB) | RF_PACKET2_RXRESTART); // avoid RX deadlocks
-  uint32_t now = millis();
-  while (!canSend() && millis() - now < RF69_CSMA_LIMIT_MS) receiveDone();
+  waitCanSend();
+  if (!_resend) _txSeq++;
   sendFrame(toAddress, buffer, bufferSize, requestACK, false);
+  if (_onTxDone) {
+    _txDonePending = true;   // reported from process()
+    _txDoneAddress = toAddress;
+  }
+  if (_keepReceiving) receiveBegin();
 }
 
 // to increase the chance of getting a packet across, call this function instead of send
@@ -277,23 +570,106 @@ void RFM69::send(uint16_t toAddress, const void* buffer, uint8_t bufferSize, boo
 // The reason for the semi-automaton is that the lib is interrupt driven and
 // requires user action to read the received data and decide what to do with it
 // replies usually take only 5..8ms at 50kbps@915MHz
+// retryWaitTime=RFM69_ACK_TIMEOUT_ADAPTIVE waits for as long as the measured round trip to this peer requires
 bool RFM69::sendWithRetry(uint16_t toAddress, const void* buffer, uint8_t bufferSize, uint8_t retries, uint8_t retryWaitTime) {
-  uint32_t sentTime;
   for (uint8_t i = 0; i <= retries; i++)
   {
+    _resend = i > 0;
     send(toAddress, buffer, bufferSize, true);
-    sentTime = millis();
-    while (millis() - sentTime < retryWaitTime)
-    {
-      if (ACKReceived(toAddress)) return true;
+    _resend = false;
+    if (waitForACK(toAddress, retryWaitTime, i)) return true;
+  }
+  return false;
+}
+
+// waits for the ACK of attempt # (0 = first transmission) that send() or sendPreloaded() just finished
+bool RFM69::waitForACK(uint16_t fromNodeID, uint8_t retryWaitTime, uint8_t attempt) {
+  uint32_t sentTime = micros();
+  uint32_t timeout = retryWaitTime ? retryWaitTime * 1000UL : getACKTimeout(fromNodeID, attempt);
+  while (micros() - sentTime < timeout)
+  {
+    if (ACKReceived(fromNodeID)) {
+      if (attempt == 0) updateRTT(fromNodeID, micros() - sentTime); // a retransmission's ACK may be for an earlier attempt (Karn)
+      return true;
     }
   }
   return false;
 }
 
+//=============================================================================
+// adaptive ACK timeout - per-peer smoothed round trip time and variance, RFC 6298 style
+//=============================================================================
+void RFM69::updateRTT(uint16_t nodeId, uint32_t rtt) {
+  if (nodeId == RF69_BROADCAST_ADDR) return;
+  uint32_t ackAirtime = getAirtime(0);
+  rtt = rtt > ackAirtime ? rtt - ackAirtime : 0; // keep the turnaround only, the airtime is added back for the bitrate in use
+  RTTEstimate* e = 0;
+  for (uint8_t i = 0; i < RF69_RTT_PEERS; i++) {
+    if (_rtt[i].nodeId == nodeId) { e = &_rtt[i]; break; }
+    if (!e && !_rtt[i].nodeId) e = &_rtt[i];
+  }
+  if (!e || e->nodeId != nodeId) {
+    if (!e) { // table full, replace round robin
+      e = &_rtt[_rttNext];
+      _rttNext = (_rttNext + 1) % RF69_RTT_PEERS;
+    }
+    e->nodeId = nodeId;
+    e->srtt = rtt;        // first sample: SRTT = R, RTTVAR = R/2
+    e->rttvar = rtt / 2;
+    return;
+  }
+  uint32_t delta = rtt > e->srtt ? rtt - e->srtt : e->srtt - rtt;
+  e->rttvar = e->rttvar - e->rttvar / 4 + delta / 4;  // RTTVAR = 3/4 RTTVAR + 1/4 |SRTT - R|
+  e->srtt = e->srtt - e->srtt / 8 + rtt / 8;          // SRTT = 7/8 SRTT + 1/8 R
+}
+
+void RFM69::setACKTimeoutLimits(uint16_t minMs, uint16_t maxMs) {
+  _ackTimeoutMin = minMs;
+  _ackTimeoutMax = maxMs < minMs ? minMs : maxMs;
+}
+
+uint32_t RFM69::getRTT(uint16_t toAddress) {
+  for (uint8_t i = 0; i < RF69_RTT_PEERS; i++)
+    if (_rtt[i].nodeId == toAddress && toAddress != RF69_BROADCAST_ADDR) return _rtt[i].srtt + getAirtime(0);
+  return 0;
+}
+
+// ACK airtime + SRTT + 4*RTTVAR, RFM69_ACK_TIMEOUT for peers not measured yet, doubled for each retry
+uint32_t RFM69::getACKTimeout(uint16_t toAddress, uint8_t attempt) {
+  uint32_t timeout = RFM69_ACK_TIMEOUT * 1000UL;
+  for (uint8_t i = 0; i < RF69_RTT_PEERS; i++)
+    if (_rtt[i].nodeId == toAddress && toAddress != RF69_BROADCAST_ADDR) {
+      timeout = getAirtime(0) + _rtt[i].srtt + 4 * _rtt[i].rttvar;
+      break;
+    }
+  uint32_t floor = _ackTimeoutMin * 1000UL, ceiling = _ackTimeoutMax * 1000UL;
+  if (timeout < floor) timeout = floor;
+  while (attempt-- && timeout < ceiling) timeout *= 2;
+  return timeout > ceiling ? ceiling : timeout;
+}
+
+// time on air: preamble + sync + length + 3 header bytes + payload (AES pads to 16 bytes) + CRC
+uint32_t RFM69::getAirtime(uint8_t dataLen) {
+  uint16_t bitrate = ((uint16_t)readReg(REG_BITRATEMSB) << 8) | readReg(REG_BITRATELSB); // = FXOSC / bps
+  uint8_t syncConfig = readReg(REG_SYNCCONFIG);
+  uint16_t bytes = ((uint16_t)readReg(REG_PREAMBLEMSB) << 8) | readReg(REG_PREAMBLELSB);
+  if (syncConfig & RF_SYNC_ON) bytes += ((syncConfig >> 3) & 0x07) + 1;
+  uint8_t message = dataLen + 3;
+#if defined(RF69_FEC_ENABLE)
+  if (_fec) message *= 2;
+#endif
+  if (readReg(REG_PACKETCONFIG2) & RF_PACKET2_AES_ON) message = (message + 15) & 0xF0;
+  bytes += 1 + message;
+  if (readReg(REG_PACKETCONFIG1) & RF_PACKET1_CRC_ON) bytes += 2;
+  return (uint32_t)bytes * bitrate / 4; // 8 bits/byte * bitrate / 32MHz, in us
+}
+
 // should be polled immediately after sending a packet with ACK request
 bool RFM69::ACKReceived(uint16_t fromNodeID) {
-  if (receiveDone())
+  _dropData = true; // anything but the ACK is dropped here
+  bool received = receiveDone();
+  _dropData = false;
+  if (received)
     return (SENDERID == fromNodeID || fromNodeID == RF69_BROADCAST_ADDR) && ACK_RECEIVED;
   return false;
 }
@@ -309,8 +685,8 @@ void RFM69::sendACK(const void* buffer, uint8_t bufferSize) {
   uint16_t sender = SENDERID;
   int16_t _RSSI = RSSI; // save payload received RSSI value
   writeReg(REG_PACKETCONFIG2, (readReg(REG_PACKETCONFIG2) & 0xFB) | RF_PACKET2_RXRESTART); // avoid RX deadlocks
-  uint32_t now = millis();
-  while (!canSend() && millis() - now < RF69_CSMA_LIMIT_MS) receiveDone();
+  if (_parkMode != RF69_MODE_SYNTH) // low latency: the requester is listening for us, don't leave the warm synthesizer
+    waitCanSend();
   SENDERID = sender;    // TWS: Restore SenderID after it gets wiped out by receiveDone()
   sendFrame(sender, buffer, bufferSize, false, true);
   RSSI = _RSSI; // restore payload RSSI
@@ -320,17 +696,17 @@ void RFM69::sendACK(const void* buffer, uint8_t bufferSize) {
 void RFM69::sendFrame(uint16_t toAddress, const void* buffer, uint8_t bufferSize, bool requestACK, bool sendACK)
 {
   //NOTE: overridden in RFM69_ATC!
-  setMode(RF69_MODE_STANDBY); // turn off receiver to prevent reception while filling fifo
-  while ((readReg(REG_IRQFLAGS1) & RF_IRQFLAGS1_MODEREADY) == 0x00); // wait for ModeReady
+  prepareFIFO();
   //writeReg(REG_DIOMAPPING1, RF_DIOMAPPING1_DIO0_00); // DIO0 is "Packet Sent"
-  if (bufferSize > RF69_MAX_DATA_LEN) bufferSize = RF69_MAX_DATA_LEN;
+  uint8_t seqLen = (_sequenceNumbers && !sendACK) ? 1 : 0;
+  if (bufferSize > frameCapacity() - seqLen) bufferSize = frameCapacity() - seqLen;
 
   // control byte
-  uint8_t CTLbyte = 0x00;
+  uint8_t CTLbyte = seqLen ? RFM69_CTL_SEQ : 0x00;
   if (sendACK)
     CTLbyte = RFM69_CTL_SENDACK;
   else if (requestACK)
-    CTLbyte = RFM69_CTL_REQACK;
+    CTLbyte |= RFM69_CTL_REQACK;
 
   if (toAddress > 0xFF) CTLbyte |= (toAddress & 0x300) >> 6; //assign last 2 bits of address if > 255
   if (_address > 0xFF) CTLbyte |= (_address & 0x300) >> 8;   //assign last 2 bits of address if > 255
@@ -338,35 +714,104 @@ void RFM69::sendFrame(uint16_t toAddress, const void* buffer, uint8_t bufferSize
   // write to FIFO
   select();
   _spi->transfer(REG_FIFO | 0x80);
-  _spi->transfer(bufferSize + 3);
-  _spi->transfer((uint8_t)toAddress);
-  _spi->transfer((uint8_t)_address);
-  _spi->transfer(CTLbyte);
+  fifoBegin(bufferSize + 3 + seqLen);
+  fifoWrite((uint8_t)toAddress);
+  fifoWrite((uint8_t)_address);
+  fifoWrite(CTLbyte);
+  if (seqLen) fifoWrite(_txSeq);
 
   for (uint8_t i = 0; i < bufferSize; i++)
-    _spi->transfer(((uint8_t*) buffer)[i]);
+    fifoWrite(((uint8_t*) buffer)[i]);
+  fifoEnd();
   unselect();
+  transmitFIFO();
+}
 
+// internal function - turns off the receiver (to prevent reception while filling the FIFO), unless already parked
+void RFM69::prepareFIFO()
+{
+  _txStart = micros();
+  _preloaded = false;
+#if defined(RF69_ENERGY_ENABLE)
+  accountMode();
+  _packetStart = _charge;
+#endif
+  if (_mode == RF69_MODE_STANDBY || _mode == RF69_MODE_SYNTH) return;
+  setMode(_parkMode);
+  waitModeReady();
+}
+
+// internal function - sends the frame in the FIFO and parks again
+void RFM69::transmitFIFO()
+{
+  if (_preloading) return; // preloadFrame(): sent later by sendPreloaded()
   // no need to wait for transmit mode to be ready since its handled by the radio
+  uint32_t txStart = micros();
+  _turnaround = txStart - _txStart;
   setMode(RF69_MODE_TX);
+  waitModeReady(); // PA ramped up, for the profile
   //uint32_t txStart = millis();
   //while (digitalRead(_interruptPin) == 0 && millis() - txStart < RF69_TX_LIMIT_MS); // wait for DIO0 to turn HIGH signalling transmission finish
   while ((readReg(REG_IRQFLAGS2) & RF_IRQFLAGS2_PACKETSENT) == 0x00); // wait for PacketSent
-  setMode(RF69_MODE_STANDBY);
+  _txTime = micros() - txStart;
+  setMode(_parkMode);
+#if defined(RF69_ENERGY_ENABLE)
+  _packetCharge = (_charge - _packetStart) / 1000;
+#endif
+}
+
+void RFM69::setParkMode(uint8_t mode)
+{
+  _parkMode = (mode == RF69_MODE_SYNTH) ? RF69_MODE_SYNTH : RF69_MODE_STANDBY;
+  if (_mode == RF69_MODE_STANDBY || _mode == RF69_MODE_SYNTH) setMode(_parkMode);
+}
+
+// loads a frame while the radio is idle so sendPreloaded() only has to switch to TX, ex: at the start of a TDMA slot
+bool RFM69::preloadFrame(uint16_t toAddress, const void* buffer, uint8_t bufferSize, bool requestACK, bool resend)
+{
+  if (_mode == RF69_MODE_SLEEP) setMode(_parkMode);
+  if (!_resend && !resend) _txSeq++;
+  _preloading = true;
+  sendFrame(toAddress, buffer, bufferSize, requestACK, false);
+  _preloading = false;
+  _preloaded = true;
+  return true;
+}
+
+bool RFM69::sendPreloaded()
+{
+  if (!_preloaded || (_mode != RF69_MODE_STANDBY && _mode != RF69_MODE_SYNTH)) return false;
+  _preloaded = false;
+  _txStart = micros();
+  transmitFIFO();
+  if (_keepReceiving) receiveBegin();
+  return true;
 }
 
 // internal function - interrupt gets called when a packet is received
 void RFM69::interruptHandler() {
-  if (_mode == RF69_MODE_RX && (readReg(REG_IRQFLAGS2) & RF_IRQFLAGS2_PAYLOADREADY))
+  // not only in RX: receiveDone() parks the radio after a packet, the next one may have arrived before that
+  uint8_t irqFlags2 = _mode != RF69_MODE_TX ? readReg(REG_IRQFLAGS2) : 0;
+  if (irqFlags2 & RF_IRQFLAGS2_PAYLOADREADY)
   {
-    setMode(RF69_MODE_STANDBY);
+    setMode(_parkMode);
     select();
     _spi->transfer(REG_FIFO & 0x7F);
     PAYLOADLEN = _spi->transfer(0);
     PAYLOADLEN = PAYLOADLEN > 66 ? 66 : PAYLOADLEN; // precaution
-    TARGETID = _spi->transfer(0);
-    SENDERID = _spi->transfer(0);
-    uint8_t CTLbyte = _spi->transfer(0);
+#if defined(RF69_FEC_ENABLE)
+    _fecLen = 0;
+    if (_fec && !fecReceive(irqFlags2 & RF_IRQFLAGS2_CRCOK)) // decodes the whole frame, fifoRead() then returns the decoded bytes
+    {
+      PAYLOADLEN = 0;
+      unselect();
+      receiveBegin();
+      return;
+    }
+#endif
+    TARGETID = fifoRead();
+    SENDERID = fifoRead();
+    uint8_t CTLbyte = fifoRead();
     TARGETID |= (uint16_t(CTLbyte) & 0x0C) << 6; //10 bit address (most significant 2 bits stored in bits(2,3) of CTL byte
     SENDERID |= (uint16_t(CTLbyte) & 0x03) << 8; //10 bit address (most sifnigicant 2 bits stored in bits(0,1) of CTL byte
 
@@ -384,17 +829,165 @@ void RFM69::interruptHandler() {
     ACK_REQUESTED = CTLbyte & RFM69_CTL_REQACK; // extract ACK-requested flag
     interruptHook(CTLbyte);     // TWS: hook to derived class interrupt function
 
-    for (uint8_t i = 0; i < DATALEN; i++) DATA[i] = _spi->transfer(0);
+    bool hasSeq = (CTLbyte & RFM69_CTL_SEQ) && !ACK_RECEIVED && DATALEN >= 1;
+    uint8_t seq = 0;
+    if (hasSeq)
+    {
+      DATALEN--;
+      seq = fifoRead();
+      if (isDuplicate(SENDERID, seq)) // retry of a packet we already delivered, its ACK got lost
+      {
+        for (uint8_t i = 0; i < DATALEN; i++) fifoRead(); // empty the FIFO before an ACK is written to it
+        unselect();
+        _duplicates++;
+        if (ACK_REQUESTED && TARGETID == _address && !_dropData) {
+          RSSI = _syncCapture ? _syncRSSI : readRSSI();
+          const ACKPayload* payload = findACKPayload(SENDERID);
+          if (payload) sendAutoACK(payload->buffer, payload->size);
+          else sendAutoACK("", 0);
+        }
+        PAYLOADLEN = 0;
+        receiveBegin();
+        return;
+      }
+    }
+
+    for (uint8_t i = 0; i < DATALEN; i++) DATA[i] = fifoRead();
 
     DATA[DATALEN] = 0; // add null at end of string // add null at end of string
     unselect();
+    if (hasSeq && !_dropData) rememberSeq(SENDERID, seq); // delivered: a retry of it is a duplicate from now on
+
+    if (_autoACK && ACK_REQUESTED && TARGETID == _address && !_dropData) // ACK now, the sender is already listening for it
+    {
+      RSSI = _syncCapture ? _syncRSSI : readRSSI();
+      const ACKPayload* payload = findACKPayload(SENDERID);
+      if (payload) sendAutoACK(payload->buffer, payload->size);
+      else sendAutoACK("", 0);
+      ACK_REQUESTED = 0;
+      _ackSent = true;
+      setMode(RF69_MODE_RX);
+      return;
+    }
     setMode(RF69_MODE_RX);
   }
-  RSSI = readRSSI();
+  RSSI = (_syncCapture && PAYLOADLEN) ? _syncRSSI : readRSSI();
+}
+
+// internal function - sends the auto-ACK from the receive path, SENDERID/RSSI are the packet's
+void RFM69::sendAutoACK(const void* buffer, uint8_t bufferSize) {
+  sendFrame(SENDERID, buffer, bufferSize, false, true);
+}
+
+// internal function - payload registered with setACKPayload() for nodeId, or the default one
+const RFM69::ACKPayload* RFM69::findACKPayload(uint16_t nodeId) {
+  const ACKPayload* payload = 0;
+  for (uint8_t i = 0; i < RF69_AUTOACK_PAYLOADS; i++) {
+    if (!_ackPayloads[i].size) continue;
+    if (_ackPayloads[i].nodeId == nodeId) return &_ackPayloads[i];
+    if (_ackPayloads[i].nodeId == RF69_BROADCAST_ADDR) payload = &_ackPayloads[i]; // default, unless the node has its own
+  }
+  return payload;
+}
+
+// internal function - true if seq is the last sequence number delivered from nodeId, within RF69_DUP_WINDOW_MS
+bool RFM69::isDuplicate(uint16_t nodeId, uint8_t seq) {
+  for (uint8_t i = 0; i < RF69_DUP_SENDERS; i++) {
+    if (_rxSeq[i].nodeId != nodeId) continue;
+    if (_rxSeq[i].seq != seq || millis() - _rxSeq[i].at >= RF69_DUP_WINDOW_MS) return false;
+    _rxSeq[i].at = millis(); // the sender is still retrying
+    return true;
+  }
+  return false;
+}
+
+// internal function - remembers seq as the last sequence number delivered from nodeId
+void RFM69::rememberSeq(uint16_t nodeId, uint8_t seq) {
+  SeqEntry* e = 0;
+  for (uint8_t i = 0; i < RF69_DUP_SENDERS; i++) {
+    if (_rxSeq[i].nodeId == nodeId) { e = &_rxSeq[i]; break; }
+    if (!e && !_rxSeq[i].nodeId) e = &_rxSeq[i];
+  }
+  if (!e) { // table full, replace round robin
+    e = &_rxSeq[_rxSeqNext];
+    _rxSeqNext = (_rxSeqNext + 1) % RF69_DUP_SENDERS;
+  }
+  e->nodeId = nodeId;
+  e->seq = seq;
+  e->at = millis();
+}
+
+void RFM69::enableSequenceNumbers(bool onOff) {
+  _sequenceNumbers = onOff;
+  if (!onOff) return;
+  // don't restart at the same number after a reset, receivers still remember it. micros() in setup() is
+  // about the same on every boot, so mix in the half dB LSBs of a few RSSI samples of the channel noise
+  uint8_t mode = _mode;
+  uint8_t seed = micros();
+  setMode(RF69_MODE_RX);
+  for (uint8_t i = 0; i < 8; i++) {
+    uint32_t start = micros();
+    while (micros() - start < 100); // a few RSSI sampling periods
+    seed = (uint8_t)(seed << 1 | seed >> 7) ^ readReg(REG_RSSIVALUE);
+  }
+  setMode(mode);
+  _txSeq = seed;
+}
+
+void RFM69::enableAutoACK(bool onOff) {
+  _autoACK = onOff;
+}
+
+bool RFM69::setACKPayload(uint16_t nodeId, const void* buffer, uint8_t bufferSize) {
+  uint8_t freeSlot = RF69_AUTOACK_PAYLOADS;
+  if (!buffer) bufferSize = 0;
+  if (bufferSize > RF69_MAX_DATA_LEN) bufferSize = RF69_MAX_DATA_LEN;
+  for (uint8_t i = 0; i < RF69_AUTOACK_PAYLOADS; i++) {
+    if (!_ackPayloads[i].size) {
+      if (freeSlot == RF69_AUTOACK_PAYLOADS) freeSlot = i;
+    }
+    else if (_ackPayloads[i].nodeId == nodeId) {
+      _ackPayloads[i].buffer = buffer;
+      _ackPayloads[i].size = bufferSize; // 0 frees the slot
+      return true;
+    }
+  }
+  if (bufferSize && freeSlot < RF69_AUTOACK_PAYLOADS) {
+    _ackPayloads[freeSlot].nodeId = nodeId;
+    _ackPayloads[freeSlot].buffer = buffer;
+    _ackPayloads[freeSlot].size = bufferSize;
+  }
+  return !bufferSize || freeSlot < RF69_AUTOACK_PAYLOADS;
 }
 
 // internal function
-ISR_PREFIX void RFM69::isr0() { _haveData = true; }
+ISR_PREFIX void RFM69::isr0() {
+  if (_syncCapture) { _syncTime = micros(); _syncSeen = true; }
+  else _haveData = true;
+}
+
+// DIO0 on SyncAddress in RX (see datasheet Table 21), PayloadReady otherwise
+void RFM69::enableSyncCapture(bool onOff) {
+  _syncCapture = onOff;
+  _syncSeen = false;
+  _syncLatched = false;
+  if (_mode == RF69_MODE_RX) writeReg(REG_DIOMAPPING1, onOff ? RF_DIOMAPPING1_DIO0_10 : RF_DIOMAPPING1_DIO0_01);
+}
+
+// internal function - a packet is on air since _syncTime: latch its RSSI, then wait for the whole payload
+void RFM69::pollSync() {
+  if (!_syncLatched) {
+    _syncRSSI = readRSSI();
+    _syncLatched = true;
+  }
+  if (readReg(REG_IRQFLAGS2) & RF_IRQFLAGS2_PAYLOADREADY) {
+    TIMESTAMP = _syncTime;
+    _haveData = true;
+  }
+  else if (readReg(REG_IRQFLAGS1) & RF_IRQFLAGS1_SYNCADDRESSMATCH) return; // still receiving
+  _syncSeen = false; // delivered, or dropped by the radio (bad CRC)
+  if (!_haveData) _syncLatched = false;
+}
 
 // internal function
 void RFM69::receiveBegin() {
@@ -404,25 +997,34 @@ void RFM69::receiveBegin() {
   PAYLOADLEN = 0;
   ACK_REQUESTED = 0;
   ACK_RECEIVED = 0;
+  _ackSent = false;
 #if defined(RF69_LISTENMODE_ENABLE)
   RF69_LISTEN_BURST_REMAINING_MS = 0;
 #endif
   RSSI = 0;
+  TIMESTAMP = 0;
+  _syncSeen = false;
+  _syncLatched = false;
   if (readReg(REG_IRQFLAGS2) & RF_IRQFLAGS2_PAYLOADREADY)
     writeReg(REG_PACKETCONFIG2, (readReg(REG_PACKETCONFIG2) & 0xFB) | RF_PACKET2_RXRESTART); // avoid RX deadlocks
-  writeReg(REG_DIOMAPPING1, RF_DIOMAPPING1_DIO0_01); // set DIO0 to "PAYLOADREADY" in receive mode
+  writeReg(REG_DIOMAPPING1, _syncCapture ? RF_DIOMAPPING1_DIO0_10 : RF_DIOMAPPING1_DIO0_01); // set DIO0 to "SYNCADDRESS" or "PAYLOADREADY" in receive mode
   setMode(RF69_MODE_RX);
 }
 
 // checks if a packet was received and/or puts transceiver in receive (ie RX or listen) mode
 bool RFM69::receiveDone() {
+#ifdef RF69_LINUX
+  pollInterrupts(0); // no hardware interrupts, dispatch any pending DIO0 edge now
+#endif
+  if (_syncSeen) pollSync();
   if (_haveData) {
   	_haveData = false;
   	interruptHandler();
+  	_syncLatched = false;
   }
   if (_mode == RF69_MODE_RX && PAYLOADLEN > 0)
   {
-    setMode(RF69_MODE_STANDBY); // enables interrupts
+    setMode(_parkMode); // enables interrupts
     return true;
   }
   else if (_mode == RF69_MODE_RX) // already in RX no payload yet
@@ -433,20 +1035,145 @@ bool RFM69::receiveDone() {
   return false;
 }
 
+//=============================================================================
+// event API - handlers are called from process(), a deferred context (never from the interrupt)
+//=============================================================================
+void RFM69::onPacket(RFM69_PacketHandler handler, void* context) {
+  _onPacket = handler;
+  _onPacketContext = context;
+}
+
+void RFM69::onAck(RFM69_PacketHandler handler, void* context) {
+  _onAck = handler;
+  _onAckContext = context;
+}
+
+void RFM69::onTxDone(RFM69_TxDoneHandler handler, void* context) {
+  _onTxDone = handler;
+  _onTxDoneContext = context;
+  _txDonePending = false;
+}
+
+void RFM69::keepReceiving(bool onOff) {
+  _keepReceiving = onOff;
+  if (onOff && _mode != RF69_MODE_RX) receiveDone();
+}
+
+// call as often as possible: loop(), and inside anything slow (display refreshes etc) to keep ACK latency low
+bool RFM69::process() {
+  if (_dispatching) return false; // called from a handler, the outer process() finishes the job
+  _dispatching = true;
+  if (_txDonePending) {
+    _txDonePending = false;
+    if (_onTxDone) _onTxDone(*this, _txDoneAddress, _onTxDoneContext);
+  }
+
+  bool dispatched = false;
+  // with keepReceiving() the receiveDone() that re-arms RX may find the next packet already, dispatch it too
+  while (receiveDone()) {
+    RFM69_Packet packet;
+    packet.senderId = SENDERID;
+    packet.targetId = TARGETID;
+    packet.data = DATA;
+    packet.dataLen = DATALEN;
+    packet.rssi = RSSI;
+    packet.ackRequested = ACKRequested();
+    packet.ackReceived = ACK_RECEIVED;
+    packet.ackSent = _ackSent;
+    packet.timestamp = TIMESTAMP;
+    if (packet.ackReceived) {
+      if (_onAck) _onAck(*this, packet, _onAckContext);
+    }
+    else if (_onPacket) _onPacket(*this, packet, _onPacketContext);
+    dispatched = true;
+    if (!_keepReceiving) break; // RX is re-armed on the next call
+  }
+  _dispatching = false;
+  return dispatched;
+}
+
+#if defined(RF69_FEC_ENABLE)
+//=============================================================================
+// FEC - every nibble is an extended Hamming(8,4) codeword (corrects 1 bit, detects 2),
+// bit interleaved over the frame: on air bit p is bit p/n of codeword p%n (n codewords),
+// so a burst of up to n flipped bits hits each codeword at most once
+//=============================================================================
+static const uint8_t HAMMING84[16] = { 0x00, 0x87, 0x99, 0x1E, 0xAA, 0x2D, 0x33, 0xB4, 0x4B, 0xCC, 0xD2, 0x55, 0xE1, 0x66, 0x78, 0xFF };
+
+bool RFM69::enableFEC(bool onOff) {
+  if (onOff && (readReg(REG_PACKETCONFIG2) & RF_PACKET2_AES_ON)) onOff = false; // see RF69_FEC_ENABLE
+  _fec = onOff;
+  // with auto-clear the radio drops any frame with a bad CRC before we get a chance to correct it
+  writeReg(REG_PACKETCONFIG1, (readReg(REG_PACKETCONFIG1) & ~RF_PACKET1_CRCAUTOCLEAR_OFF) | (onOff ? RF_PACKET1_CRCAUTOCLEAR_OFF : RF_PACKET1_CRCAUTOCLEAR_ON));
+  return onOff;
+}
+
+// internal function - writes the frame buffered by fifoWrite() as codewords, FIFO is selected
+void RFM69::fifoEnd() {
+  if (!_fec) return;
+  uint8_t n = _fecLen * 2;
+  _spi->transfer(n);
+  for (uint8_t k = 0; k < _fecLen * 2; k++) {
+    uint8_t out = 0;
+    for (uint8_t b = 0; b < 8; b++) {
+      uint16_t p = k * 8 + b;
+      uint8_t j = p % n;
+      uint8_t codeword = HAMMING84[(_fecBuf[j >> 1] >> ((j & 1) * 4)) & 0x0F];
+      if (codeword & (1 << (p / n))) out |= 0x80 >> b; // MSB goes on air first
+    }
+    _spi->transfer(out);
+  }
+  _fecLen = 0;
+}
+
+// internal function - reads the PAYLOADLEN coded bytes from the FIFO and decodes them into _fecBuf
+// a frame with a good CRC is only unpacked, otherwise it must have a correctable error or it is dropped
+bool RFM69::fecReceive(bool crcOk) {
+  uint8_t n = PAYLOADLEN;
+  if (n < 6 || n > sizeof(_fecBuf) || (n & 1)) { _fecFailed++; return false; }
+  for (uint8_t k = 0; k < n; k++) _fecBuf[k] = _spi->transfer(0);
+
+  uint8_t codewords[sizeof(_fecBuf)];
+  for (uint8_t j = 0; j < n; j++) codewords[j] = 0;
+  for (uint16_t p = 0; p < n * 8; p++)
+    if (_fecBuf[p >> 3] & (0x80 >> (p & 7))) codewords[p % n] |= 1 << (p / n);
+
+  uint8_t corrected = 0;
+  for (uint8_t j = 0; j < n; j++) {
+    uint8_t c = codewords[j];
+    if (!crcOk) {
+      uint8_t syndrome = 0, parity = 0;
+      for (uint8_t pos = 1; pos <= 7; pos++)
+        if (c & (1 << (pos - 1))) syndrome ^= pos;
+      for (uint8_t x = c; x; x >>= 1) parity ^= x & 1;
+      if (syndrome && !parity) { _fecFailed++; return false; } // 2 bit errors, can't correct
+      if (syndrome) c ^= 1 << (syndrome - 1);
+      if (syndrome || parity) corrected++;
+    }
+    uint8_t nibble = ((c >> 2) & 0x01) | ((c >> 3) & 0x0E); // data bits are positions 3, 5, 6, 7
+    if (j & 1) _fecBuf[j >> 1] |= nibble << 4;
+    else _fecBuf[j >> 1] = nibble;
+  }
+  // bad CRC but every codeword valid: too many errors to even see them
+  if (!crcOk && !corrected) { _fecFailed++; return false; }
+  _fecCorrected += corrected;
+  PAYLOADLEN = _fecLen = n / 2;
+  _fecPos = 0;
+  return true;
+}
+#endif
+
 // To enable encryption: radio.encrypt("ABCDEFGHIJKLMNOP");
 // To disable encryption: radio.encrypt(null) or radio.encrypt(0)
 // KEY HAS TO BE 16 bytes !!!
-void RFM69::encrypt(const char* key) {
-#if defined(RF69_LISTENMODE_ENABLE)
-  _haveEncryptKey = key;
+bool RFM69::encrypt(const char* key) {
+  uint8_t validKey = key != 0 && strlen(key)!=0;
+#if defined(RF69_FEC_ENABLE)
+  if (validKey && _fec) return false; // see RF69_FEC_ENABLE
 #endif
   setMode(RF69_MODE_STANDBY);
-  uint8_t validKey = key != 0 && strlen(key)!=0;
   if (validKey)
   {
-#if defined(RF69_LISTENMODE_ENABLE)
-    memcpy(_encryptKey, key, 16);
-#endif
     select();
     _spi->transfer(REG_AESKEY1 | 0x80);
     for (uint8_t i = 0; i < 16; i++)
@@ -454,6 +1181,7 @@ void RFM69::encrypt(const char* key) {
     unselect();
   }
   writeReg(REG_PACKETCONFIG2, (readReg(REG_PACKETCONFIG2) & 0xFE) | (validKey ? 1 : 0));
+  return true;
 }
 
 // get the received signal strength indicator (RSSI)
@@ -470,6 +1198,58 @@ int16_t RFM69::readRSSI(bool forceTrigger) {
   return rssi;
 }
 
+//=============================================================================
+// scanRSSI() - min/avg/max RSSI per channel, ex: to pick a quiet channel at boot
+//=============================================================================
+void RFM69::scanRSSI(const uint32_t* frf, uint8_t count, uint16_t dwellUs, RFM69_RSSIStats* results)
+{
+  scanBegin();
+  for (uint8_t i = 0; i < count; i++) scanChannel(frf[i], dwellUs, results[i]);
+  scanEnd();
+}
+
+void RFM69::scanRSSI(uint32_t firstHz, uint32_t spacingHz, uint8_t count, uint16_t dwellUs, RFM69_RSSIStats* results)
+{
+  scanBegin();
+  for (uint8_t i = 0; i < count; i++) scanChannel(RF69_hzToFRF(firstHz + spacingHz * i), dwellUs, results[i]);
+  scanEnd();
+}
+
+void RFM69::scanBegin()
+{
+  _scanFRF = getFRF();
+  _scanMode = _mode;
+  setMode(RF69_MODE_RX); // the receiver stays on for the whole scan, setFRF() only restarts it
+}
+
+void RFM69::scanChannel(uint32_t frf, uint16_t dwellUs, RFM69_RSSIStats& result)
+{
+  setFRF(frf);
+  readRSSI(true); // first measurement after the restart may predate the PLL lock, drop it
+  int32_t sum = 0;
+  uint16_t samples = 0;
+  result.min = 0;
+  result.max = -127;
+  uint32_t start = micros();
+  do {
+    int16_t rssi = readRSSI(true);
+    if (rssi < result.min) result.min = rssi;
+    if (rssi > result.max) result.max = rssi;
+    sum += rssi;
+    samples++;
+  } while (micros() - start < dwellUs && samples < 0xFFFF);
+  result.avg = sum / samples;
+}
+
+void RFM69::scanEnd()
+{
+  _haveData = false; // a PayloadReady seen while scanning belongs to another channel
+  _syncSeen = false;
+  setFRF(_scanFRF);
+  if (_scanMode == RF69_MODE_RX) receiveBegin();
+  else setMode(_scanMode);
+}
+
 uint8_t RFM69::readReg(uint8_t addr)
 {
   select();
@@ -751,7 +1531,7 @@ void RFM69::readAllRegs()
         case 0x6 : {
             freqDev |= regVal;
             SerialPrint( "Frequency deviation\nFdev : " );
-            unsigned long val = RF69_FSTEP * freqDev;
+            unsigned long val = RF69_frfToHz(freqDev); // same step as FRF
             Serial.println( val );
             SerialPrint ( "\n" );
             break;
@@ -772,7 +1552,7 @@ void RFM69::readAllRegs()
         case 0x9 : {        
             freqCenter = freqCenter | regVal;
             SerialPrint ( "RF Carrier frequency\nFRF : " );
-            unsigned long val = RF69_FSTEP * freqCenter;
+            unsigned long val = RF69_frfToHz(freqCenter);
             Serial.println( val );
             SerialPrint( "\n" );
             break;
@@ -907,8 +1687,11 @@ void RFM69::rcCalibration()
 // ListenMode sleep/timer - see ListenModeSleep example for proper usage!
 void RFM69::listenModeSleep(uint16_t millisInterval) 
 {
+  if (_listenState != RF69_LISTEN_OFF) return;
   setMode( RF69_MODE_STANDBY );
-  while ((readReg(REG_IRQFLAGS1) & RF_IRQFLAGS1_MODEREADY) == 0x00); // wait for ModeReady
+  waitModeReady();
+  listenModeSave();
+  _listenState = RF69_LISTEN_TIMER;
 
   detachInterrupt( _interruptNum );
   //attachInterrupt( _interruptNum, delayIrq, RISING);
@@ -942,11 +1725,11 @@ void RFM69::listenModeSleep(uint16_t millisInterval)
   writeReg( REG_RSSITHRESH, 255 );
   writeReg( REG_RXTIMEOUT2, 1 );
   writeReg( REG_OPMODE, RF_OPMODE_SEQUENCER_ON | RF_OPMODE_STANDBY  );
-  writeReg( REG_OPMODE, RF_OPMODE_SEQUENCER_ON | RF_OPMODE_STANDBY | RF_OPMODE_LISTEN_ON  );
-
+  _listenTimerEdges = 0;
   attachInterrupt( _interruptNum, delayIrq, RISING);
+  writeReg( REG_OPMODE, RF_OPMODE_SEQUENCER_ON | RF_OPMODE_STANDBY | RF_OPMODE_LISTEN_ON  );
 
-  //must call sleep + interrupt handler 3 times here, then endListenModeSleep() - see ListenModeSleep example!
+  //sleep the MCU until listenModeSleepDone(), then endListenModeSleep() - see ListenModeSleep example!
 }
 
 //=============================================================================
@@ -954,36 +1737,57 @@ void RFM69::listenModeSleep(uint16_t millisInterval)
 //=============================================================================
 void RFM69::endListenModeSleep()
 {
+  if (_listenState != RF69_LISTEN_TIMER) return;
   detachInterrupt( _interruptNum );
+  listenModeAbort();
+  listenModeRestore();
+  attachInterrupt(_interruptNum, RFM69::isr0, RISING);
+}
+
+// registers changed by listenModeSleep(), listenModeStart() and listenModeSendBurst(), FRF first (listenModeConfigure())
+static const uint8_t LISTEN_REGS[RF69_LISTEN_SAVED_REGS] = {
+  REG_FRFMSB, REG_FRFMID, REG_FRFLSB, REG_BITRATEMSB, REG_BITRATELSB, REG_FDEVMSB, REG_FDEVLSB, REG_RXBW,
+  REG_DIOMAPPING1, REG_PACKETCONFIG1, REG_PACKETCONFIG2, REG_SYNCVALUE1, REG_SYNCVALUE2, REG_RSSITHRESH, REG_RXTIMEOUT2 };
+
+// internal function - saves the registers listen mode changes
+void RFM69::listenModeSave()
+{
+  for (uint8_t i = 0; i < RF69_LISTEN_SAVED_REGS; i++)
+    _listenSaved[i] = readReg(LISTEN_REGS[i]);
+}
+
+// internal function - writes back the saved registers (FRF takes effect with the LSB write), the radio is in standby
+void RFM69::listenModeRestore()
+{
+  for (uint8_t i = 0; i < RF69_LISTEN_SAVED_REGS; i++)
+    writeReg(LISTEN_REGS[i], _listenSaved[i]);
+  _listenState = RF69_LISTEN_OFF;
+}
+
+// internal function - stops the listen cycle, the radio goes to standby
+void RFM69::listenModeAbort()
+{
+  uint32_t abortAt = micros();
   writeReg( REG_OPMODE, RF_OPMODE_SEQUENCER_ON | RF_OPMODE_LISTENABORT | RF_OPMODE_STANDBY );
   writeReg( REG_OPMODE, RF_OPMODE_SEQUENCER_ON | RF_OPMODE_STANDBY );
-  writeReg( REG_RXTIMEOUT2, 0 );
   setMode( RF69_MODE_STANDBY );
-  while ((readReg(REG_IRQFLAGS1) & RF_IRQFLAGS1_MODEREADY) == 0x00); // wait for ModeReady
+  _modeFrom = RF69_MODE_SLEEP; // listen idle runs on the RC oscillator, leaving it costs a crystal start like sleep
+  _modeSwitchAt = abortAt;
+  _modePending = true;
+  waitModeReady();
 }
 
 //=============================================================================
-// delayIRQ() - called by listenModeSleep()
+// delayIRQ() - DIO0 while listenModeSleep() runs, counts the timer edges
 //=============================================================================
-void RFM69::delayIrq() { return; }
+ISR_PREFIX void RFM69::delayIrq() { if (_listenTimerEdges < 255) _listenTimerEdges++; }
 
 //=============================================================================
 //                     ListenMode specific functions  
 //=============================================================================
 #if defined(RF69_LISTENMODE_ENABLE)
-RFM69* RFM69::selfPointer=0;
 volatile uint16_t RFM69::RF69_LISTEN_BURST_REMAINING_MS = 0;
-
-//=============================================================================
-// reinitRadio() - use base class initialization with saved values
-//=============================================================================
-bool RFM69::reinitRadio()
-{
-  if (!initialize(_freqBand, _address, _networkID)) return false;
-  if (_haveEncryptKey) RFM69::encrypt(_encryptKey); // Restore the encryption key if necessary
-  if (_isHighSpeed) writeReg(REG_LNA, (readReg(REG_LNA) & ~0x3) | RF_LNA_GAINSELECT_AUTO);
-  return true;
-}
+volatile bool RFM69::_listenWake = false;
 
 static uint32_t getUsForResolution(uint8_t resolution)
 {
@@ -1009,7 +1813,7 @@ static uint32_t getCoefForResolution(uint8_t resolution, uint32_t duration)
   uint32_t result = duration / resolDuration;
 
   // If the next-higher coefficient is closer, use that
-  if (abs(duration - ((result + 1) * resolDuration)) < abs(duration - (result * resolDuration)))
+  if ((result + 1) * resolDuration - duration < duration - result * resolDuration)
     return result + 1;
 
   return result;
@@ -1066,102 +1870,124 @@ void RFM69::listenModeReset(void)
 }
 
 //=============================================================================
-// irq handler, simply calls listenModeInterruptHandler method so internal methods can be accessed easily
+// listenModeIrq() - DIO0 (PayloadReady) while listening, the packet is read by listenModeReceiveDone()
 //=============================================================================
-ISR_PREFIX void RFM69::listenModeIrq() { selfPointer->listenModeInterruptHandler(); }
+ISR_PREFIX void RFM69::listenModeIrq() { _listenWake = true; }
 
 //=============================================================================
-// listenModeInterruptHandler() - only called by listen irq handler
+// listenModeReadPacket() - reads the burst packet from the FIFO, false if it is not for this node
+// the listen cycle is in idle after PayloadReady (RF_LISTEN1_END_10), the FIFO is kept until the next RX period
 //=============================================================================
-void RFM69::listenModeInterruptHandler(void)
+bool RFM69::listenModeReadPacket()
 {
-  if (DATALEN != 0) return;
-
   listenModeReset();
-  noInterrupts();
+  _listenRxTime = micros();
   select();
-
-  union                        // union to simplify addressing of long and short parts of time offset
-  {
-    uint32_t l;
-    uint8_t  b[4];
-  } burstRemaining;
-
-  burstRemaining.l = 0;
-
   _spi->transfer(REG_FIFO & 0x7F);
   PAYLOADLEN = _spi->transfer(0);
-  PAYLOADLEN = PAYLOADLEN > 64 ? 64 : PAYLOADLEN; // precaution
-  TARGETID = _spi->transfer(0);
-  if(!(_spyMode || TARGETID == _address || TARGETID == RF69_BROADCAST_ADDR) // match this node's address, or broadcast address or anything in spy mode
-     || PAYLOADLEN < 3) // address situation could receive packets that are malformed and don't fit this library's extra fields
+  PAYLOADLEN = PAYLOADLEN > 66 ? 66 : PAYLOADLEN; // precaution
+  uint8_t headerLen = 5; // target, sender, CTL and the two time remaining bytes
+  if (PAYLOADLEN >= headerLen)
+  {
+    TARGETID = _spi->transfer(0);
+    SENDERID = _spi->transfer(0);
+    uint8_t CTLbyte = _spi->transfer(0);
+    TARGETID |= (uint16_t(CTLbyte) & 0x0C) << 6; //10 bit address, same as regular frames
+    SENDERID |= (uint16_t(CTLbyte) & 0x03) << 8;
+    if (CTLbyte & RFM69_CTL_REQACK) headerLen++; // plus the ms until the sender's next RX gap
+  }
+  if (PAYLOADLEN < headerLen || !(_spyMode || TARGETID == _address || TARGETID == RF69_BROADCAST_ADDR))
   {
+    unselect();
     listenModeReset();
-    goto out;
+    writeReg(REG_IRQFLAGS2, RF_IRQFLAGS2_FIFOOVERRUN); // clears the FIFO, PayloadReady and DIO0 for the next packet
+    return false;
   }
 
-  // We've read the target, and will read the sender id and two time offset bytes for a total of 4 bytes
-  DATALEN = PAYLOADLEN - 4;
-  SENDERID = _spi->transfer(0);
-  burstRemaining.b[0] =  _spi->transfer(0);  // and get the time remaining
-  burstRemaining.b[1] =  _spi->transfer(0);
-  RF69_LISTEN_BURST_REMAINING_MS = burstRemaining.l;
-
+  // We send the burst time remaining with the packet so the receiver knows how long to wait before trying to reply
+  RF69_LISTEN_BURST_REMAINING_MS = _spi->transfer(0);
+  RF69_LISTEN_BURST_REMAINING_MS |= (uint16_t)_spi->transfer(0) << 8;
+  _listenAckGap = headerLen > 5 ? _spi->transfer(0) : 0;
+  DATALEN = PAYLOADLEN - headerLen;
   for (uint8_t i = 0; i < DATALEN; i++)
     DATA[i] = _spi->transfer(0);
-
   if (DATALEN < RF69_MAX_DATA_LEN)
     DATA[DATALEN] = 0; // add null at end of string
-
-out:
   unselect();
-  interrupts();
+  return true;
 }
 
 //=============================================================================
-// listenModeStart() - switch radio to Listen Mode in prep for sleep until burst
+// listenModeConfigure() - burst channel and packet settings, shared by the listener and the sender
 //=============================================================================
-void RFM69::listenModeStart(void)
+void RFM69::listenModeConfigure()
 {
-  //pRadio = this;
-  while (readReg(REG_IRQFLAGS2) & RF_IRQFLAGS2_PACKETSENT == 0x00); // wait for ModeReady
-  listenModeReset();
-
-  detachInterrupt(_interruptNum);
-  attachInterrupt(_interruptNum, listenModeIrq, RISING);
-  setMode(RF69_MODE_STANDBY);
-  writeReg(REG_DIOMAPPING1, RF_DIOMAPPING1_DIO0_01);
-  writeReg(REG_FRFMSB, readReg(REG_FRFMSB) + 1);
-  writeReg(REG_FRFLSB, readReg(REG_FRFLSB));      // MUST write to LSB to affect change!
-
+  writeReg(REG_FRFMSB, _listenSaved[0] + 1); // from the saved FRF, the registers may hold the listen channel already
+  writeReg(REG_FRFMID, _listenSaved[1]);
+  writeReg(REG_FRFLSB, _listenSaved[2]);     // MUST write to LSB to affect change!
   listenModeApplyHighSpeedSettings();
-
   writeReg(REG_PACKETCONFIG1, RF_PACKET1_FORMAT_VARIABLE | RF_PACKET1_DCFREE_WHITENING | RF_PACKET1_CRC_ON | RF_PACKET1_CRCAUTOCLEAR_ON);
   writeReg(REG_PACKETCONFIG2, RF_PACKET2_RXRESTARTDELAY_NONE | RF_PACKET2_AUTORXRESTART_ON | RF_PACKET2_AES_OFF);
   writeReg(REG_SYNCVALUE1, 0x5A);
   writeReg(REG_SYNCVALUE2, 0x5A);
+}
+
+//=============================================================================
+// listenModeStart() - switch radio to Listen Mode in prep for sleep until burst
+// OFF: saves the registers listen mode changes, WOKEN: listens again with the settings in place
+//=============================================================================
+void RFM69::listenModeStart(void)
+{
+  if (_listenState == RF69_LISTEN_ARMED) return;
+  if (_listenState == RF69_LISTEN_TIMER) endListenModeSleep();
+  detachInterrupt(_interruptNum);
+  setMode(RF69_MODE_STANDBY);
+  waitModeReady();
+  if (_listenState == RF69_LISTEN_OFF) listenModeSave();
+  listenModeReset();
+  _listenWake = false;
+
+  listenModeConfigure();
+  writeReg(REG_DIOMAPPING1, RF_DIOMAPPING1_DIO0_01);
   writeReg(REG_LISTEN1, _rxListenResolution | _idleListenResolution | RF_LISTEN1_CRITERIA_RSSI | RF_LISTEN1_END_10);
   writeReg(REG_LISTEN2, _idleListenCoef);
   writeReg(REG_LISTEN3, _rxListenCoef);
   writeReg(REG_RSSITHRESH, 180);
   writeReg(REG_RXTIMEOUT2, 75);
+  writeReg(REG_IRQFLAGS2, RF_IRQFLAGS2_FIFOOVERRUN); // nothing left in the FIFO from before
+  _listenState = RF69_LISTEN_ARMED;
+  attachInterrupt(_interruptNum, listenModeIrq, RISING);
   writeReg(REG_OPMODE, RF_OPMODE_SEQUENCER_ON | RF_OPMODE_STANDBY);
   writeReg(REG_OPMODE, RF_OPMODE_SEQUENCER_ON | RF_OPMODE_LISTEN_ON  | RF_OPMODE_STANDBY);
 }
 
 //=============================================================================
-// listenModeEnd() - exit listen mode and reinit the radio
+// listenModeReceiveDone() - true when a burst packet for this node woke the radio, which then stops listening
+//=============================================================================
+bool RFM69::listenModeReceiveDone()
+{
+#ifdef RF69_LINUX
+  pollInterrupts(0); // no hardware interrupts, dispatch any pending DIO0 edge now
+#endif
+  if (_listenState != RF69_LISTEN_ARMED || !_listenWake) return false;
+  _listenWake = false;
+  if (!listenModeReadPacket()) return false; // for another node, the radio keeps listening
+  listenModeAbort();
+  _listenState = RF69_LISTEN_WOKEN;
+  return true;
+}
+
+//=============================================================================
+// listenModeEnd() - exit listen mode, the changed registers are written back (the received packet is kept)
 //=============================================================================
 void RFM69::listenModeEnd(void)
 {
+  if (_listenState == RF69_LISTEN_TIMER) endListenModeSleep();
+  if (_listenState == RF69_LISTEN_OFF) return;
   detachInterrupt(_interruptNum);
-  writeReg(REG_OPMODE, RF_OPMODE_SEQUENCER_ON | RF_OPMODE_LISTENABORT | RF_OPMODE_STANDBY);
-  writeReg(REG_OPMODE, RF_OPMODE_SEQUENCER_ON | RF_OPMODE_STANDBY);
-  writeReg(REG_RXTIMEOUT2, 0);
-  setMode(RF69_MODE_STANDBY);
-  while ((readReg(REG_IRQFLAGS1) & RF_IRQFLAGS1_MODEREADY) == 0x00); // wait for ModeReady
-  listenModeReset();
-  reinitRadio();
+  if (_listenState == RF69_LISTEN_ARMED) listenModeAbort();
+  listenModeRestore();
+  attachInterrupt(_interruptNum, RFM69::isr0, RISING);
 }
 
 void RFM69::listenModeApplyHighSpeedSettings()
@@ -1180,26 +2006,30 @@ void RFM69::listenModeApplyHighSpeedSettings()
 //=============================================================================
 // sendBurst() - send a burst of packets to a sleeping listening node (or all)
 //=============================================================================
-void RFM69::listenModeSendBurst( uint8_t targetNode, const void* buffer, uint8_t size )
+bool RFM69::listenModeSendBurst( uint16_t targetNode, const void* buffer, uint8_t size, bool wakeAck )
 {
+  listenModeEnd();
+  if (targetNode == RF69_BROADCAST_ADDR) wakeAck = false; // the first node to answer would cut the others' burst short
+  uint8_t headerLen = wakeAck ? 6 : 5; // target, sender, CTL, time remaining, ms to the next RX gap
+  if (size > RF69_MAX_DATA_LEN + 3 - headerLen) size = RF69_MAX_DATA_LEN + 3 - headerLen;
   detachInterrupt(_interruptNum);
   setMode(RF69_MODE_STANDBY);
-  writeReg(REG_PACKETCONFIG1, RF_PACKET1_FORMAT_VARIABLE | RF_PACKET1_DCFREE_WHITENING | RF_PACKET1_CRC_ON | RF_PACKET1_CRCAUTOCLEAR_ON );
-  writeReg(REG_PACKETCONFIG2, RF_PACKET2_RXRESTARTDELAY_NONE | RF_PACKET2_AUTORXRESTART_ON | RF_PACKET2_AES_OFF);
-  writeReg(REG_SYNCVALUE1, 0x5A);
-  writeReg(REG_SYNCVALUE2, 0x5A);
-  listenModeApplyHighSpeedSettings();
-  writeReg(REG_FRFMSB, readReg(REG_FRFMSB) + 1);
-  writeReg(REG_FRFLSB, readReg(REG_FRFLSB));      // MUST write to LSB to affect change!
-
-  union // union to simplify addressing of long and short parts of time offset
-  {
-    int32_t l;
-    uint8_t b[4];
-  } timeRemaining;
+  waitModeReady();
+  listenModeSave();
+  listenModeConfigure();
+
+  // only the time bytes change from frame to frame, the rest is built once
+  uint8_t header[6];
+  header[0] = size + headerLen;
+  header[1] = (uint8_t)targetNode;
+  header[2] = (uint8_t)_address;
+  header[3] = wakeAck ? RFM69_CTL_REQACK : 0;
+  if (targetNode > 0xFF) header[3] |= (targetNode & 0x300) >> 6; //assign last 2 bits of address if > 255
+  if (_address > 0xFF) header[3] |= (_address & 0x300) >> 8;     //assign last 2 bits of address if > 255
 
   uint16_t cycleDurationMs = _listenCycleDurationUs / 1000;
-  timeRemaining.l = cycleDurationMs;
+  uint16_t nextGap = wakeAck ? RF69_LISTEN_ACK_INTERVAL_MS : cycleDurationMs;
+  bool acked = false;
 
 #ifdef RF69_WL_DEBUG
   Serial.print("Sending burst for ");
@@ -1208,34 +2038,112 @@ void RFM69::listenModeSendBurst( uint8_t targetNode, const void* buffer, uint8_t
 #endif
 
   setMode(RF69_MODE_TX);
-  uint32_t numSent = 0;
   uint32_t startTime = millis();
+  uint16_t elapsed = 0;
+
+  while (elapsed < cycleDurationMs) {
+    if (elapsed >= nextGap) {
+      listenModeFlushTx();
+      setMode(RF69_MODE_RX);
+      acked = listenModeWaitWakeAck(targetNode);
+      if (acked) break;
+      setMode(RF69_MODE_TX);
+      nextGap += RF69_LISTEN_ACK_INTERVAL_MS;
+      elapsed = millis() - startTime;
+    }
 
-  while(timeRemaining.l > 0) {
+    // We send the burst time remaining with the packet so the receiver knows how long to wait before trying to reply
+    uint16_t remaining = cycleDurationMs - elapsed;
+    header[4] = remaining;
+    header[5] = remaining >> 8;
+    uint16_t toGap = nextGap < cycleDurationMs ? nextGap - elapsed : 0; // 0 = no more gaps, wait for the end
     noInterrupts();
-    // write to FIFO
     select();
     _spi->transfer(REG_FIFO | 0x80);
-    _spi->transfer(size + 4);      // two bytes for target and sender node, two bytes for the burst time remaining
-    _spi->transfer(targetNode);
-    _spi->transfer(_address);
-
-    // We send the burst time remaining with the packet so the receiver knows how long to wait before trying to reply
-    _spi->transfer(timeRemaining.b[0]);
-    _spi->transfer(timeRemaining.b[1]);
-
-    for (uint8_t i = 0; i < size; i++) {
+    for (uint8_t i = 0; i < 6; i++)
+      _spi->transfer(header[i]);
+    if (wakeAck) _spi->transfer(toGap > 255 ? 255 : toGap);
+    for (uint8_t i = 0; i < size; i++)
       _spi->transfer(((uint8_t*) buffer)[i]);
-    }
-
     unselect();
     interrupts();
 
     while ((readReg(REG_IRQFLAGS2) & RF_IRQFLAGS2_FIFONOTEMPTY) != 0x00);  // make sure packet is sent before putting more into the FIFO
-    timeRemaining.l = cycleDurationMs - (millis() - startTime);
+    elapsed = millis() - startTime;
   }
+  if (!acked) listenModeFlushTx();
 
   setMode(RF69_MODE_STANDBY);
-  reinitRadio();
+  listenModeRestore();
+  attachInterrupt(_interruptNum, RFM69::isr0, RISING);
+  return acked;
+}
+
+//=============================================================================
+// listenModeWaitWakeAck() - RX gap of a burst, true if the target (or anyone for a broadcast burst) sent its wake-ACK
+//=============================================================================
+bool RFM69::listenModeWaitWakeAck(uint16_t targetNode)
+{
+  uint32_t start = micros();
+  while (micros() - start < RF69_LISTEN_ACK_GAP_US) {
+    if (!(readReg(REG_IRQFLAGS2) & RF_IRQFLAGS2_PAYLOADREADY)) continue;
+    select();
+    _spi->transfer(REG_FIFO & 0x7F);
+    uint8_t length = _spi->transfer(0);
+    uint16_t to = _spi->transfer(0);
+    uint16_t from = _spi->transfer(0);
+    uint8_t CTLbyte = _spi->transfer(0);
+    unselect();
+    to |= (uint16_t(CTLbyte) & 0x0C) << 6;
+    from |= (uint16_t(CTLbyte) & 0x03) << 8;
+    writeReg(REG_IRQFLAGS2, RF_IRQFLAGS2_FIFOOVERRUN); // drop the rest, ready for the next frame
+    if (length >= 3 && (CTLbyte & RFM69_CTL_SENDACK) && to == _address && from == targetNode)
+      return true;
+  }
+  return false;
+}
+
+//=============================================================================
+// listenModeSendWakeAck() - after listenModeReceiveDone(), tells the sender to stop its burst
+// ACK copies are sent around the sender's next RX gap, computed from the ms the woken frame carried
+//=============================================================================
+bool RFM69::listenModeSendWakeAck()
+{
+  if (_listenState != RF69_LISTEN_WOKEN || !_listenAckGap) return false;
+  // the frame was written when the gap was _listenAckGap ms away, and read a bit after it ended
+  uint32_t gap = (uint32_t)_listenAckGap * 1000;
+  while (micros() - _listenRxTime > gap + RF69_LISTEN_ACK_GAP_US / 2) gap += RF69_LISTEN_ACK_INTERVAL_MS * 1000UL; // too late for that one
+  uint32_t from = gap > 1500 ? gap - 1500 : 0;
+  uint32_t until = gap + RF69_LISTEN_ACK_GAP_US;
+  while (micros() - _listenRxTime < from);
+
+  uint8_t CTLbyte = RFM69_CTL_SENDACK;
+  if (SENDERID > 0xFF) CTLbyte |= (SENDERID & 0x300) >> 6;
+  if (_address > 0xFF) CTLbyte |= (_address & 0x300) >> 8;
+  setMode(RF69_MODE_TX);
+  while (micros() - _listenRxTime < until) {
+    select();
+    _spi->transfer(REG_FIFO | 0x80);
+    _spi->transfer(3);
+    _spi->transfer((uint8_t)SENDERID);
+    _spi->transfer((uint8_t)_address);
+    _spi->transfer(CTLbyte);
+    unselect();
+    while ((readReg(REG_IRQFLAGS2) & RF_IRQFLAGS2_FIFONOTEMPTY) != 0x00);
+  }
+  listenModeFlushTx();
+  setMode(RF69_MODE_STANDBY);
+  _listenAckGap = 0;
+  return true;
+}
+
+//=============================================================================
+// listenModeFlushTx() - waits until the frame being sent is out, PacketSent stays set after the first frame in TX
+//=============================================================================
+void RFM69::listenModeFlushTx()
+{
+  while ((readReg(REG_IRQFLAGS2) & RF_IRQFLAGS2_FIFONOTEMPTY) != 0x00);
+  uint16_t bitrate = ((uint16_t)readReg(REG_BITRATEMSB) << 8) | readReg(REG_BITRATELSB); // = FXOSC / bps
+  delayMicroseconds((uint32_t)24 * bitrate / 32); // last byte and the CRC still shifting out
 }
 #endif
@@ -26,10 +26,15 @@
 #ifndef RFM69_h
 #define RFM69_h
 
+#if defined(__linux__) && !defined(ARDUINO)
+#include "Linux/Linux.h"         // native Linux process: spidev + GPIO chardev, or an emulated device
+#include "Linux/SPI.h"
+#else
 #define MCU_STM32F103RE
 #include "STM32/STM32.h"
 //#include <Arduino.h>            // assumes Arduino IDE v1.0 or greater
 #include "STM32/SPI.h"
+#endif
 
 extern SerialDebug Serial;
 
@@ -157,6 +162,16 @@ extern SerialDebug Serial;
 #define RF69_MODE_RX            3 // RX MODE
 #define RF69_MODE_TX            4 // TX MODE
 
+// listen mode states, see listenModeState()
+#define RF69_LISTEN_OFF         0
+#define RF69_LISTEN_ARMED       1 // wake-on-radio, waiting for a burst
+#define RF69_LISTEN_WOKEN       2 // a burst packet was received, radio in standby with the listen settings
+#define RF69_LISTEN_TIMER       3 // listenModeSleep()
+#define RF69_LISTEN_SAVED_REGS 15 // registers listen mode changes, written back when it ends
+#ifndef RF69_LISTEN_TIMER_EDGES
+  #define RF69_LISTEN_TIMER_EDGES 3 // DIO0 edges until listenModeSleep() is over: 2 when the timer starts, 1 after the interval
+#endif
+
 // available frequency bands
 #define RF69_315MHZ            31 // non trivial values to avoid misconfiguration
 #define RF69_433MHZ            43
@@ -170,24 +185,120 @@ extern SerialDebug Serial;
 #define RF69_TX_LIMIT_MS   1000
 #define RF69_FSTEP  61.03515625 // == FXOSC / 2^19 = 32MHz / 2^19 (p13 in datasheet)
 
+// Exact Hz <-> FRF register conversions: FSTEP = 31250 / 2^9 Hz, so splitting the value on 31250 (or 2^9)
+// keeps every product under 2^24, no float nor 64 bit math. Both round to nearest:
+// RF69_frfToHz(RF69_hzToFRF(hz)) is within FSTEP/2 (31Hz) of hz and RF69_hzToFRF(RF69_frfToHz(frf)) == frf.
+// constexpr: constant arguments are folded at compile time (tables, SHIFTCHANNEL)
+constexpr uint32_t RF69_hzToFRF(uint32_t hz) { return (hz / 31250) * 512 + ((hz % 31250) * 512 + 15625) / 31250; }
+constexpr uint32_t RF69_frfToHz(uint32_t frf) { return (frf >> 9) * 31250 + (((frf & 0x1FF) * 31250 + 256) >> 9); }
+
 // TWS: define CTLbyte bits
 #define RFM69_CTL_SENDACK   0x80
 #define RFM69_CTL_REQACK    0x40
+#define RFM69_CTL_SEQ       0x10  // a sequence number byte follows the CTL byte (data frames only)
 
 #define RFM69_ACK_TIMEOUT   30  // 30ms roundtrip req for 61byte packets
+#ifndef RF69_WARMUP_MARGIN_US
+  #define RF69_WARMUP_MARGIN_US 50 // scheduleSend(): slack added to the measured wake-up chain
+#endif
+#define RFM69_ACK_TIMEOUT_ADAPTIVE 0 // retryWaitTime for sendWithRetry(): derive it from the peer's measured round trip
 
-//Native hardware ListenMode is experimental
-//It was determined to be buggy and unreliable, see https://lowpowerlab.com/forum/low-power-techniques/ultra-low-power-listening-mode-for-battery-nodes/msg20261/#msg20261
+// adaptive ACK timeout: per-peer smoothed RTT/variance (TCP style), clamped to [MIN..MAX] ms
+#ifndef RFM69_ACK_TIMEOUT_MIN
+  #define RFM69_ACK_TIMEOUT_MIN 3
+#endif
+#ifndef RFM69_ACK_TIMEOUT_MAX
+  #define RFM69_ACK_TIMEOUT_MAX 200
+#endif
+#ifndef RF69_DUP_SENDERS
+  #define RF69_DUP_SENDERS      8 // # of senders whose last sequence number is remembered for duplicate suppression
+#endif
+#ifndef RF69_DUP_WINDOW_MS
+  #define RF69_DUP_WINDOW_MS 1000 // a retry comes within this long, after that the same sequence number is a new packet (ex: the sender rebooted)
+#endif
+#ifndef RF69_RTT_PEERS
+  #define RF69_RTT_PEERS        4 // # of peers whose round trip time is tracked
+#endif
+
+#ifndef RF69_AUTOACK_PAYLOADS
+  #define RF69_AUTOACK_PAYLOADS 4 // # of per-node ACK payloads that can be registered for auto-ACK
+#endif
+
+//Native hardware ListenMode (wake-on-radio): the radio cycles short RX periods and idle periods on its own RC timer
+//so the node can sleep and still be woken by a burst, ~5uA average with the default durations
+//The earlier implementation was unreliable, see https://lowpowerlab.com/forum/low-power-techniques/ultra-low-power-listening-mode-for-battery-nodes/msg20261/#msg20261
+//Burst frames carry the CTL byte for 10bit addresses: all listen mode nodes must run this version
 //uncomment to try ListenMode, adds ~1K to compiled size
-//FYI - 10bit addressing is not supported in ListenMode
 //#define RF69_LISTENMODE_ENABLE
 
+//Forward error correction: frames are sent as interleaved extended Hamming(8,4) codewords and received
+//with CRC auto-clear off, so a few flipped bits are corrected instead of dropping the packet and waiting for a retry.
+//Every node on the network must enable it, it halves the payload (RF69_FEC_MAX_DATA_LEN) and doubles the airtime
+//It can't be combined with encrypt(): AES is undone before decoding, one flipped bit on air garbles a whole 16 byte block
+//uncomment to try FEC, see enableFEC()
+//#define RF69_FEC_ENABLE
+
+//Energy accounting: setMode() keeps the time spent in each mode and the charge drawn according to a current table,
+//for charge per packet and battery life estimates, see getCharge(). Costs ~100 bytes of RAM and some 64bit math
+//uncomment to try it
+//#define RF69_ENERGY_ENABLE
+
+#if defined(RF69_FEC_ENABLE)
+  #define RF69_FEC_MAX_DATA_LEN 29 // 64 coded FIFO bytes = 32 bytes, minus the 3 header bytes
+#endif
+
 #if defined(RF69_LISTENMODE_ENABLE)
   // By default, receive for 256uS in listen mode and idle for ~1s
   #define  DEFAULT_LISTEN_RX_US 256
   #define  DEFAULT_LISTEN_IDLE_US 1000000
+  #define RF69_LISTEN_MAX_DATA_LEN (RF69_MAX_DATA_LEN - 2) // burst frames add the 2 time remaining bytes, wake-ACK bursts 1 more
+  #ifndef RF69_LISTEN_ACK_INTERVAL_MS
+    #define RF69_LISTEN_ACK_INTERVAL_MS 50  // wake-ACK bursts: TX time between two RX gaps
+  #endif
+  #ifndef RF69_LISTEN_ACK_GAP_US
+    #define RF69_LISTEN_ACK_GAP_US    3000  // length of an RX gap, a listener whose RX period falls in it misses the burst
+  #endif
 #endif
 
+class RFM69;
+
+// packet view handed to the onPacket()/onAck() handlers, only valid until the handler returns
+struct RFM69_Packet {
+  uint16_t senderId;
+  uint16_t targetId;
+  const uint8_t* data;  // null terminated, points into RFM69::DATA
+  uint8_t dataLen;
+  int16_t rssi;
+  bool ackRequested;    // the handler should call radio.sendACK()
+  bool ackReceived;
+  bool ackSent;         // already ACKed by the driver (auto-ACK), ackRequested is false
+  uint32_t timestamp;   // micros() at sync word detection, 0 without enableSyncCapture()
+};
+
+// RSSI seen on one channel during scanRSSI(), dBm
+struct RFM69_RSSIStats {
+  int16_t min;
+  int16_t avg;
+  int16_t max;
+};
+
+#if defined(RF69_ENERGY_ENABLE)
+// supply current of the module per mode in nA, TX at up to 4 output powers (ascending dBm, interpolated in between)
+struct RFM69_CurrentTable {
+  uint32_t sleep;
+  uint32_t standby;
+  uint32_t synth;
+  uint32_t rx;
+  int8_t txDBm[4];
+  uint32_t tx[4];
+};
+extern const RFM69_CurrentTable RFM69W_CURRENTS;  // PA0, -18..+13dBm
+extern const RFM69_CurrentTable RFM69HW_CURRENTS; // PA1+PA2 with the high power settings in TX, up to +20dBm
+#endif
+
+typedef void (*RFM69_PacketHandler)(RFM69& radio, const RFM69_Packet& packet, void* context);
+typedef void (*RFM69_TxDoneHandler)(RFM69& radio, uint16_t toAddress, void* context);
+
 class RFM69 {
   public:
     static uint8_t DATA[RF69_MAX_DATA_LEN+1]; // RX/TX payload buffer, including end of string NULL char
@@ -198,6 +309,7 @@ class RFM69 {
     static uint8_t ACK_REQUESTED;
     static uint8_t ACK_RECEIVED; // should be polled immediately after sending a packet with ACK request
     static int16_t RSSI; // most accurate RSSI during reception (closest to the reception). RSSI of last packet.
+    static uint32_t TIMESTAMP; // micros() when the sync word of the last packet was detected, 0 = unknown (see enableSyncCapture())
     static uint8_t _mode; // should be protected?
 
 #ifdef STM32IDE
@@ -215,15 +327,19 @@ class RFM69 {
     void setAddress(uint16_t addr);
     void setNetwork(uint8_t networkID);
     virtual bool canSend();
+    bool waitCanSend(uint32_t limitMs=RF69_CSMA_LIMIT_MS); // CSMA: false if the channel stayed busy, packets heard meanwhile are dropped
     virtual void send(uint16_t toAddress, const void* buffer, uint8_t bufferSize, bool requestACK=false);
     virtual bool sendWithRetry(uint16_t toAddress, const void* buffer, uint8_t bufferSize, uint8_t retries=2, uint8_t retryWaitTime=RFM69_ACK_TIMEOUT);
     virtual bool receiveDone();
     bool ACKReceived(uint16_t fromNodeID);
+    bool waitForACK(uint16_t fromNodeID, uint8_t retryWaitTime, uint8_t attempt); // after send(..., true) or sendPreloaded(), attempt 0 = first transmission
     bool ACKRequested();
     virtual void sendACK(const void* buffer = "", uint8_t bufferSize=0);
     uint32_t getFrequency();
     void setFrequency(uint32_t freqHz);
-    void encrypt(const char* key);
+    uint32_t getFRF();         // raw FRF register value (frequency in FSTEP units)
+    void setFRF(uint32_t frf); // one SPI burst, RX restarts on the new frequency without leaving RX
+    bool encrypt(const char* key); // false if refused: not while FEC is on
 #ifdef STM32IDE
     void setCS(struct gpio_pin newSPISlaveSelect);
 #else
@@ -236,6 +352,55 @@ class RFM69 {
     bool setIrq(uint8_t newIRQPin);
 #endif
     int16_t readRSSI(bool forceTrigger=false); // *current* signal strength indicator; e.g. < -90dBm says the frequency channel is free + ready to transmit
+    // DIO0 signals the sync word instead of PayloadReady: the packet gets a micros() TIMESTAMP from the interrupt and
+    // its RSSI is read while it is still on air, call receiveDone() often so the RSSI is latched early in the packet
+    void enableSyncCapture(bool onOff=true);
+
+    // low latency turnaround: where the radio waits between operations, RF69_MODE_STANDBY (default) or RF69_MODE_SYNTH.
+    // SYNTH keeps the PLL locked so TX or RX start within microseconds instead of a PLL lock, at ~9mA instead of 1.25mA.
+    // It also sends sendACK() replies without CSMA, like the auto-ACKs. For RX between operations use keepReceiving()
+    void setParkMode(uint8_t mode);
+    uint8_t getParkMode() { return _parkMode; }
+    bool preloadFrame(uint16_t toAddress, const void* buffer, uint8_t bufferSize, bool requestACK=false, bool resend=false); // fills the FIFO now, stays parked. resend keeps the sequence number
+    bool sendPreloaded();             // transmits the preloaded frame right away (no CSMA), false if it was lost by entering RX or sleep
+    uint16_t getTurnaround() { return _turnaround; } // us from sendFrame() (or sendPreloaded()) to the TX switch, last frame
+    uint16_t getTxTime() { return _txTime; }         // us from the TX switch to PacketSent, last frame
+
+    // mode transition profile: every ModeReady wait of the driver is timed (average per from/to pair, in us).
+    // Pairs not measured yet report typical datasheet figures. profileTransitions() measures the common ones now.
+    uint16_t getTransitionTime(uint8_t fromMode, uint8_t toMode);
+    void profileTransitions();
+    uint32_t getWarmupTime(uint8_t fromMode); // us from fromMode until a transmission can start, with the margin
+    // planned transmission: updateSchedule() starts the oscillator, then the PLL, preloads the frame and switches
+    // to TX so the frame goes out at atMicros, each step only as early as its measured latency requires.
+    // buffer must stay valid until sent, updateSchedule() has to be called more often than the warmup time
+    void scheduleSend(uint32_t atMicros, uint16_t toAddress, const void* buffer, uint8_t bufferSize, bool requestACK=false);
+    bool updateSchedule(); // true once the planned frame was sent
+    void cancelSchedule() { _planned = false; }
+    bool scheduled() { return _planned; }
+
+#if defined(RF69_ENERGY_ENABLE)
+    // energy accounting, since initialize() or resetEnergy(). Only the radio module is counted.
+    // Time the MCU spends powered down does not show in millis(): add it with addSleepTime(), ex: after LowPower.powerDown()
+    void setCurrentTable(const RFM69_CurrentTable* table) { accountMode(); _currents = table; } // 0 = RFM69W/HW figures
+    void resetEnergy();
+    void addSleepTime(uint32_t ms);        // ms that passed in the current mode without millis() advancing
+    uint32_t getResidency(uint8_t mode);   // ms spent in mode
+    uint32_t getCharge();                  // uC (mA*ms) drawn in total
+    uint32_t getPacketCharge() { return _packetCharge; } // nC drawn by the last frame sent, from the FIFO load until parked
+    uint32_t getAverageCurrent();          // uA
+    uint32_t getBatteryLife(uint32_t mAh, uint32_t otherUA=0); // hours at the average current plus otherUA (MCU, sensors)
+    int8_t getOutputDBm();                 // TX output power at the current power level
+#endif
+
+    // spectrum scan: samples the RSSI for dwellUs on each channel, stays in RX and retunes with FRF bursts,
+    // then restores the frequency and mode. Packets arriving during the scan are dropped.
+    void scanRSSI(const uint32_t* frf, uint8_t count, uint16_t dwellUs, RFM69_RSSIStats* results); // FRF values, see RF69_hzToFRF()
+    void scanRSSI(uint32_t firstHz, uint32_t spacingHz, uint8_t count, uint16_t dwellUs, RFM69_RSSIStats* results);
+    // building blocks for scans over other channel lists (ex: RFM69_Hopper::scan())
+    void scanBegin();
+    void scanChannel(uint32_t frf, uint16_t dwellUs, RFM69_RSSIStats& result);
+    void scanEnd();
     void spyMode(bool onOff=true);
     //void promiscuous(bool onOff=true); //replaced with spyMode()
     virtual void setHighPower(bool onOFF=true); // has to be called after initialize() for RFM69HW
@@ -251,19 +416,96 @@ class RFM69 {
     void readAllRegs();
     void readAllRegsCompact();
 
-    // ListenMode sleep/timer
+    // ListenMode sleep/timer: DIO0 wakes the MCU after millisInterval, see the ListenModeSleep example
+    //   radio.listenModeSleep(ms);
+    //   while (!radio.listenModeSleepDone()) LowPower.powerDown(SLEEP_FOREVER, ADC_OFF, BOD_OFF);
+    //   radio.endListenModeSleep();
+    // the timer also pulses DIO0 as it starts, listenModeSleepDone() is only true once the interval is over
+    // endListenModeSleep() writes back the registers listenModeSleep() changed, no need to initialize() again
     void listenModeSleep(uint16_t millisInterval);
+    bool listenModeSleepDone() { return _listenState != RF69_LISTEN_TIMER || _listenTimerEdges >= RF69_LISTEN_TIMER_EDGES; }
     void endListenModeSleep();
 
+    // event API: instead of polling receiveDone(), register handlers and call process() from loop()
+    // (and from anything that runs long, ex: a display refresh). Handlers run from process(), never
+    // from the interrupt, so they can use SPI, sendACK() and send().
+    void onPacket(RFM69_PacketHandler handler, void* context=0);
+    void onAck(RFM69_PacketHandler handler, void* context=0);  // ACKs not consumed by sendWithRetry(), ex: send(..., true)
+    void onTxDone(RFM69_TxDoneHandler handler, void* context=0);  // after each send()
+    void keepReceiving(bool onOff=true);  // go straight back to RX after each dispatch and after send()
+    bool process();  // dispatches pending events, returns true if a packet was dispatched
+
+    // auto-ACK: the ACK goes out from the receive path right after the packet is read, without CSMA,
+    // before the application sees the packet (ACKRequested() is then false). Peers can use a much
+    // shorter retryWaitTime with a gateway doing this. The packet is read by the next receiveDone()/process()
+    // call, so poll often. Packets ACKReceived() or the CSMA wait drop are not ACKed, their senders retry.
+    void enableAutoACK(bool onOff=true);
+    // payload piggybacked on auto-ACKs to nodeId (RF69_BROADCAST_ADDR: any node without its own entry)
+    // buffer is not copied and must stay valid, pass bufferSize=0 to remove. False if the table is full
+    bool setACKPayload(uint16_t nodeId, const void* buffer, uint8_t bufferSize);
+    bool ACKSent() { return _ackSent; }
+
+    // adaptive ACK timeout, used when sendWithRetry() is given retryWaitTime=RFM69_ACK_TIMEOUT_ADAPTIVE
+    void setACKTimeoutLimits(uint16_t minMs=RFM69_ACK_TIMEOUT_MIN, uint16_t maxMs=RFM69_ACK_TIMEOUT_MAX);
+    uint32_t getACKTimeout(uint16_t toAddress, uint8_t attempt=0); // microseconds, doubles with each retry
+    uint32_t getRTT(uint16_t toAddress);  // smoothed round trip time in microseconds, 0 if unknown
+    uint32_t getAirtime(uint8_t dataLen); // microseconds on air for a packet with dataLen payload bytes, at the current settings
+
+    // sequence numbers: each new send() carries an 8bit sequence number (retries reuse it) so receivers
+    // can drop duplicates caused by lost ACKs. Receiving is always supported: a duplicate of a packet the application
+    // got (within RF69_DUP_WINDOW_MS) is re-ACKed (with the setACKPayload() payload, if any) and never delivered.
+    // Packets dropped before they reach the application (ACKReceived(), CSMA) don't count. Only enable it if all receivers run this version.
+    void enableSequenceNumbers(bool onOff=true);
+    uint16_t getDuplicateCount() { return _duplicates; }
+    uint8_t getMaxDataLen() { return frameCapacity() - (_sequenceNumbers ? 1 : 0); } // largest payload send() takes with the current options
+
+#if defined(RF69_FEC_ENABLE)
+    bool enableFEC(bool onOff=true); // all nodes of the network must agree, false (and off) while encryption is on
+    uint16_t getFECCorrected() { return _fecCorrected; } // bit errors corrected so far
+    uint16_t getFECFailed() { return _fecFailed; }       // frames dropped as uncorrectable
+#endif
+
   protected:
     static void isr0();
     void interruptHandler();
     virtual void interruptHook(uint8_t CTLbyte __attribute__((unused))) {};
     static volatile bool _haveData;
+    static bool _syncCapture;             // DIO0 is mapped to SyncAddress in RX
+    static volatile bool _syncSeen;       // sync word detected, packet in progress
+    static volatile uint32_t _syncTime;
+    bool _syncLatched;                    // _syncRSSI was read for the packet in progress
+    int16_t _syncRSSI;
+    void pollSync();
     virtual void sendFrame(uint16_t toAddress, const void* buffer, uint8_t size, bool requestACK=false, bool sendACK=false);
+    virtual void sendAutoACK(const void* buffer, uint8_t size);
+    void updateRTT(uint16_t nodeId, uint32_t rtt);
+    bool isDuplicate(uint16_t nodeId, uint8_t seq);
+    void rememberSeq(uint16_t nodeId, uint8_t seq);
+
+    // FIFO access for frames: plain SPI transfers, or through the FEC coder when it is on
+#if defined(RF69_FEC_ENABLE)
+    uint8_t frameCapacity() { return _fec ? RF69_FEC_MAX_DATA_LEN : RF69_MAX_DATA_LEN; }
+    void fifoBegin(uint8_t length) { if (_fec) _fecLen = 0; else _spi->transfer(length); }
+    void fifoWrite(uint8_t data) { if (_fec) _fecBuf[_fecLen++] = data; else _spi->transfer(data); }
+    void fifoEnd();
+    uint8_t fifoRead() { return _fecLen ? (_fecPos < _fecLen ? _fecBuf[_fecPos++] : 0) : _spi->transfer(0); }
+    bool fecReceive(bool crcOk);
+#else
+    uint8_t frameCapacity() { return RF69_MAX_DATA_LEN; }
+    void fifoBegin(uint8_t length) { _spi->transfer(length); }
+    void fifoWrite(uint8_t data) { _spi->transfer(data); }
+    void fifoEnd() {}
+    uint8_t fifoRead() { return _spi->transfer(0); }
+#endif
 
     // for ListenMode sleep/timer
     static void delayIrq();
+    static volatile uint8_t _listenTimerEdges; // DIO0 edges since listenModeSleep()
+    uint8_t _listenState;
+    uint8_t _listenSaved[RF69_LISTEN_SAVED_REGS];
+    void listenModeSave();
+    void listenModeRestore();
+    void listenModeAbort();
    
 #ifdef STM32IDE
     struct gpio_pin _slaveSelectPin;
@@ -279,6 +521,94 @@ class RFM69 {
     uint8_t _powerLevel;
     bool _isRFM69HW;
     SPIClass *_spi;
+
+    RFM69_PacketHandler _onPacket;
+    RFM69_PacketHandler _onAck;
+    RFM69_TxDoneHandler _onTxDone;
+    void* _onPacketContext;
+    void* _onAckContext;
+    void* _onTxDoneContext;
+    bool _keepReceiving;
+    bool _dispatching;     // process() is running, nested calls return right away
+    bool _txDonePending;
+    uint16_t _txDoneAddress;
+
+    struct ACKPayload {
+      uint16_t nodeId;
+      uint8_t size;  // 0 = free slot
+      const void* buffer;
+    };
+    ACKPayload _ackPayloads[RF69_AUTOACK_PAYLOADS];
+    const ACKPayload* findACKPayload(uint16_t nodeId);
+    bool _autoACK;
+    bool _dropData;     // ACKReceived() or CSMA: a data packet read now is dropped, so it is not auto-ACKed
+    static bool _ackSent;
+
+    struct RTTEstimate {
+      uint16_t nodeId;  // 0 = free slot
+      uint32_t srtt;    // microseconds, excluding the ACK's own airtime
+      uint32_t rttvar;
+    };
+    RTTEstimate _rtt[RF69_RTT_PEERS];
+    uint8_t _rttNext;   // slot replaced next when all are in use
+    uint16_t _ackTimeoutMin;
+    uint16_t _ackTimeoutMax;
+
+    struct SeqEntry {
+      uint16_t nodeId;  // 0 = free slot
+      uint8_t seq;      // last sequence number delivered from nodeId
+      uint32_t at;      // millis() of that delivery or its last retry
+    };
+    SeqEntry _rxSeq[RF69_DUP_SENDERS];
+    uint8_t _rxSeqNext; // slot replaced next when all are in use
+    uint8_t _txSeq;
+    bool _sequenceNumbers;
+    bool _resend;       // send() is a retry, keep the sequence number
+    uint8_t _parkMode;  // STANDBY or SYNTH, see setParkMode()
+    bool _preloading;   // sendFrame() only fills the FIFO
+    bool _preloaded;    // the FIFO holds a frame for sendPreloaded()
+    uint32_t _txStart;
+    uint16_t _turnaround;
+    uint16_t _txTime;
+    void prepareFIFO();
+    void transmitFIFO();
+    uint16_t _transition[5][5];  // [from][to] average us, 0 = not measured
+    uint8_t _modeFrom;           // mode before the last switch, for the pending ModeReady wait
+    uint32_t _modeSwitchAt;
+    bool _modePending;
+    void waitModeReady();
+    bool _planned;               // scheduleSend()
+    uint32_t _planAt;
+    uint16_t _planTo;
+    const void* _planBuffer;
+    uint8_t _planSize;
+    bool _planACK;
+#if defined(RF69_ENERGY_ENABLE)
+    const RFM69_CurrentTable* _currents;
+    uint32_t _residencyMs[5];
+    uint16_t _residencyUs[5];    // < 1000, carried into _residencyMs
+    uint64_t _charge;            // pC
+    uint64_t _packetStart;
+    uint32_t _packetCharge;
+    uint32_t _modeSinceMs;
+    uint32_t _modeSinceUs;
+    void accountMode();
+    void addModeTime(uint32_t ms, uint16_t us);
+    uint32_t modeCurrent(uint8_t mode);
+#else
+    void accountMode() {}
+#endif
+    uint16_t _duplicates;
+    uint32_t _scanFRF;  // frequency and mode to restore after a scan
+    uint8_t _scanMode;
+#if defined(RF69_FEC_ENABLE)
+    bool _fec;
+    static uint8_t _fecBuf[64]; // coded frame being received, or plain frame being sent
+    static uint8_t _fecLen;     // 0 = fifoRead() reads the FIFO
+    static uint8_t _fecPos;
+    uint16_t _fecCorrected;
+    uint16_t _fecFailed;
+#endif
 #if defined (SPCR) && defined (SPSR)
     uint8_t _SPCR;
     uint8_t _SPSR;
@@ -294,7 +624,6 @@ class RFM69 {
     virtual void unselect();
 
 #if defined(RF69_LISTENMODE_ENABLE)
-  static RFM69* selfPointer;
   //=============================================================================
   //                     ListenMode specific declarations  
   //=============================================================================
@@ -302,9 +631,16 @@ class RFM69 {
     // When we receive a packet in listen mode, this is the time left in the sender's burst.
     // You need to wait at least this long before trying to reply.
     static volatile uint16_t RF69_LISTEN_BURST_REMAINING_MS;
-    
+
+    // listenModeStart() arms wake-on-radio, the MCU can then sleep until DIO0 wakes it.
+    // listenModeReceiveDone() (call it after every wake, like receiveDone()) reads the packet: DATA, DATALEN, SENDERID,
+    // TARGETID and RF69_LISTEN_BURST_REMAINING_MS. Packets for other nodes are dropped and the radio keeps listening.
+    // After a wake the radio waits in standby: listenModeStart() listens again, listenModeEnd() writes back
+    // the registers listen mode changed for normal operation.
     void listenModeStart(void);
+    bool listenModeReceiveDone();
     void listenModeEnd(void);
+    uint8_t listenModeState() { return _listenState; }
     void listenModeHighSpeed(bool highSpeed) { _isHighSpeed = highSpeed; }
     
     // rx and idle duration in microseconds
@@ -319,23 +655,26 @@ class RFM69 {
     // is transmitted to the receiver, and it is expected that the receiver
     // wait for the burst to end before attempting a reply.
     // See RF69_LISTEN_BURST_REMAINING_MS above.
-    void listenModeSendBurst(uint8_t targetNode, const void* buffer, uint8_t size);
+    // With wakeAck the burst pauses for an RX gap every RF69_LISTEN_ACK_INTERVAL_MS and stops as soon as the
+    // target answers with listenModeSendWakeAck(), returns true then. Ignored for broadcasts: every node must hear the burst.
+    bool listenModeSendBurst(uint16_t targetNode, const void* buffer, uint8_t size, bool wakeAck=false);
+    // woken by a wakeAck burst: stops the sender's burst (waits for its next RX gap, up to RF69_LISTEN_ACK_INTERVAL_MS)
+    // reply once the radio is back to normal (listenModeEnd()), no need to wait for RF69_LISTEN_BURST_REMAINING_MS
+    bool listenModeSendWakeAck();
 
   protected:
-    void listenModeInterruptHandler(void);
+    bool listenModeReadPacket();
+    void listenModeConfigure();
+    bool listenModeWaitWakeAck(uint16_t targetNode);
+    void listenModeFlushTx();
+    uint8_t _listenAckGap;   // ms from the woken frame to the sender's RX gap, 0 = not a wakeAck burst
+    uint32_t _listenRxTime;  // micros() when the woken frame was read
     void listenModeApplyHighSpeedSettings();
     void listenModeReset(); //resets variables used on the receiving end
-    bool reinitRadio(void);
     static void listenModeIrq();
+    static volatile bool _listenWake;
 
     bool _isHighSpeed;
-    bool _haveEncryptKey;
-    char _encryptKey[16];
-
-    // Save these so we can reinitialize the radio after sending a burst
-    // or exiting listen mode.
-    uint8_t _freqBand;
-    uint8_t _networkID;
     uint8_t _rxListenCoef;
     uint8_t _rxListenResolution;
     uint8_t _idleListenCoef;
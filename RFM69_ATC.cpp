@@ -29,7 +29,6 @@
 #include "RFM69_ATC.h"
 #include "RFM69.h"   // include the RFM69 library files as well
 #include "RFM69registers.h"
-#include "STM32/SPI.h"
 
 volatile uint8_t RFM69_ATC::ACK_RSSI_REQUESTED;  // new type of flag on ACK_REQUEST
 
@@ -71,13 +70,19 @@ void RFM69_ATC::sendACK(const void* buffer, uint8_t bufferSize) {
   int16_t _RSSI = RSSI; // save payload received RSSI value
   bool sendRSSI = ACK_RSSI_REQUESTED;  
   writeReg(REG_PACKETCONFIG2, (readReg(REG_PACKETCONFIG2) & 0xFB) | RF_PACKET2_RXRESTART); // avoid RX deadlocks
-  uint32_t now = millis();
-  while (!canSend() && millis() - now < RF69_CSMA_LIMIT_MS) receiveDone();
+  waitCanSend();
   SENDERID = sender;    // TomWS1: Restore SenderID after it gets wiped out by receiveDone()
   sendFrame(sender, buffer, bufferSize, false, true, sendRSSI, _RSSI);   // TomWS1: Special override on sendFrame with extra params
   RSSI = _RSSI; // restore payload RSSI
 }
 
+//=============================================================================
+// sendAutoACK() - auto-ACK from the receive path, with the ACK RSSI if requested
+//=============================================================================
+void RFM69_ATC::sendAutoACK(const void* buffer, uint8_t bufferSize) {
+  sendFrame(SENDERID, buffer, bufferSize, false, true, ACK_RSSI_REQUESTED, RSSI);
+}
+
 //=============================================================================
 // sendFrame() - the basic version is used to match the RFM69 prototype so we can extend it
 //=============================================================================
@@ -90,46 +95,43 @@ void RFM69_ATC::sendFrame(uint16_t toAddress, const void* buffer, uint8_t buffer
 // sendFrame() - the new one with additional parameters.  This packages recv'd RSSI with the packet, if required.
 //=============================================================================
 void RFM69_ATC::sendFrame(uint16_t toAddress, const void* buffer, uint8_t bufferSize, bool requestACK, bool sendACK, bool sendRSSI, int16_t lastRSSI) {
-  setMode(RF69_MODE_STANDBY); // turn off receiver to prevent reception while filling fifo
-  while ((readReg(REG_IRQFLAGS1) & RF_IRQFLAGS1_MODEREADY) == 0x00); // wait for ModeReady
+  prepareFIFO();
   //writeReg(REG_DIOMAPPING1, RF_DIOMAPPING1_DIO0_00); // DIO0 is "Packet Sent"
 
   bufferSize += (sendACK && sendRSSI)?1:0;  // if sending ACK_RSSI then increase data size by 1
-  if (bufferSize > RF69_MAX_DATA_LEN) bufferSize = RF69_MAX_DATA_LEN;
+  uint8_t seqLen = (_sequenceNumbers && !sendACK) ? 1 : 0;
+  if (bufferSize > frameCapacity() - seqLen) bufferSize = frameCapacity() - seqLen;
 
   // write to FIFO
   select();
   _spi->transfer(REG_FIFO | 0x80);
-  _spi->transfer(bufferSize + 3);
-  _spi->transfer((uint8_t)toAddress); //lower 8bits
-  _spi->transfer((uint8_t)_address);  //lower 8bits
+  fifoBegin(bufferSize + 3 + seqLen);
+  fifoWrite((uint8_t)toAddress); //lower 8bits
+  fifoWrite((uint8_t)_address);  //lower 8bits
 
   // CTL (control byte)
   uint8_t CTLbyte=0x0;
   if (toAddress > 0xFF) CTLbyte |= (toAddress & 0x300) >> 6; //assign last 2 bits of address if > 255
   if (_address > 0xFF) CTLbyte |= (_address & 0x300) >> 8;   //assign last 2 bits of address if > 255
+  if (seqLen) CTLbyte |= RFM69_CTL_SEQ;
   if (sendACK) {                   // TomWS1: adding logic to return ACK_RSSI if requested
-    _spi->transfer(CTLbyte | RFM69_CTL_SENDACK | (sendRSSI?RFM69_CTL_RESERVE1:0));  // TomWS1  TODO: Replace with EXT1
+    fifoWrite(CTLbyte | RFM69_CTL_SENDACK | (sendRSSI?RFM69_CTL_RESERVE1:0));  // TomWS1  TODO: Replace with EXT1
     if (sendRSSI) {
-      _spi->transfer(abs(lastRSSI)); //RSSI dBm is negative expected between [-100 .. -20], convert to positive and pass along as single extra header byte
+      fifoWrite(abs(lastRSSI)); //RSSI dBm is negative expected between [-100 .. -20], convert to positive and pass along as single extra header byte
       bufferSize -=1;              // account for the extra ACK-RSSI 'data' byte
     }
   }
   else if (requestACK) {  // TODO: add logic to request ackRSSI with ACK - this is when both ends of a transmission would dial power down. May not work well for gateways in multi node networks
-    _spi->transfer(CTLbyte | (_targetRSSI ? RFM69_CTL_REQACK | RFM69_CTL_RESERVE1 : RFM69_CTL_REQACK));
+    fifoWrite(CTLbyte | (_targetRSSI ? RFM69_CTL_REQACK | RFM69_CTL_RESERVE1 : RFM69_CTL_REQACK));
   }
-  else _spi->transfer(CTLbyte);
+  else fifoWrite(CTLbyte);
+  if (seqLen) fifoWrite(_txSeq);
 
   for (uint8_t i = 0; i < bufferSize; i++)
-    _spi->transfer(((uint8_t*) buffer)[i]);
+    fifoWrite(((uint8_t*) buffer)[i]);
+  fifoEnd();
   unselect();
-
-  // no need to wait for transmit mode to be ready since its handled by the radio
-  setMode(RF69_MODE_TX);
-  //uint32_t txStart = millis();
-  //while (digitalRead(_interruptPin) == 0 && millis() - txStart < RF69_TX_LIMIT_MS); // wait for DIO0 to turn HIGH signalling transmission finish
-  while ((readReg(REG_IRQFLAGS2) & RF_IRQFLAGS2_PACKETSENT) == 0x00); // wait for PacketSent
-  setMode(RF69_MODE_STANDBY);
+  transmitFIFO();
 }
 
 //=============================================================================
@@ -141,7 +143,7 @@ void RFM69_ATC::interruptHook(uint8_t CTLbyte) {
   if (ACK_RECEIVED && ACK_RSSI_REQUESTED) {
     // the next two bytes contain the ACK_RSSI (assuming the datalength is valid)
     if (DATALEN >= 1) {
-      _ackRSSI = -1 * _spi->transfer(0); //rssi was sent as single byte positive value, get the real value by * -1
+      _ackRSSI = -1 * fifoRead(); //rssi was sent as single byte positive value, get the real value by * -1
       DATALEN -= 1;   // and compensate data length accordingly
       // TomWS1: Now dither transmitLevel value (register update occurs later when transmitting);
       if (_targetRSSI != 0) {
@@ -166,13 +168,12 @@ void RFM69_ATC::interruptHook(uint8_t CTLbyte) {
 //  sendWithRetry() - overrides the base to allow increasing power when repeated ACK requests fail
 //=============================================================================
 bool RFM69_ATC::sendWithRetry(uint16_t toAddress, const void* buffer, uint8_t bufferSize, uint8_t retries, uint8_t retryWaitTime) {
-  uint32_t sentTime;
   for (uint8_t i = 0; i <= retries; i++)
   {
+    _resend = i > 0;
     send(toAddress, buffer, bufferSize, true);
-    sentTime = millis();
-    while (millis() - sentTime < retryWaitTime)
-      if (ACKReceived(toAddress)) return true;
+    _resend = false;
+    if (waitForACK(toAddress, retryWaitTime, i)) return true;
     if (_transmitLevel < 31) {
       _transmitLevel += _transmitLevelStep;
       if (_transmitLevel > 31) _transmitLevel = 31;
@@ -64,6 +64,7 @@ class RFM69_ATC: public RFM69 {
     void interruptHook(uint8_t CTLbyte);
     void sendFrame(uint16_t toAddress, const void* buffer, uint8_t size, bool requestACK=false, bool sendACK=false);  // Need this one to match the RFM69 prototype.
     void sendFrame(uint16_t toAddress, const void* buffer, uint8_t size, bool requestACK, bool sendACK, bool sendRSSI, int16_t lastRSSI);
+    void sendAutoACK(const void* buffer, uint8_t size);
     void receiveBegin();
     //void setHighPowerRegs(bool onOff);
 
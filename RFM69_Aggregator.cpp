@@ -0,0 +1,121 @@
+// **********************************************************************************
+// Message aggregation: several small messages per frame, as type/length/value records
+// **********************************************************************************
+// Copyright LowPowerLab LLC 2018, https://www.LowPowerLab.com/contact
+// **********************************************************************************
+// License
+// **********************************************************************************
+// This program is free software; you can redistribute it 
+// and/or modify it under the terms of the GNU General    
+// Public License as published by the Free Software       
+// Foundation; either version 3 of the License, or        
+// (at your option) any later version.                    
+//                                                        
+// This program is distributed in the hope that it will   
+// be useful, but WITHOUT ANY WARRANTY; without even the  
+// implied warranty of MERCHANTABILITY or FITNESS FOR A   
+// PARTICULAR PURPOSE. See the GNU General Public        
+// License for more details.                              
+//                                                        
+// Licence can be viewed at                               
+// http://www.gnu.org/licenses/gpl-3.0.txt
+//
+// Please maintain this license information along with authorship
+// and copyright notices in any redistribution of this code
+// **********************************************************************************
+#include "RFM69_Aggregator.h"
+
+RFM69_Aggregator::RFM69_Aggregator(RFM69& radio, uint16_t toAddress, uint16_t maxDelay) : _radio(radio)
+{
+  _toAddress = toAddress;
+  _maxDelay = maxDelay;
+  _retries = 2;
+  _retryWaitTime = RFM69_ACK_TIMEOUT;
+  clear();
+}
+
+void RFM69_Aggregator::setRetries(uint8_t retries, uint8_t retryWaitTime)
+{
+  _retries = retries;
+  _retryWaitTime = retryWaitTime;
+}
+
+void RFM69_Aggregator::clear()
+{
+  _len = 0;
+  _count = 0;
+}
+
+uint8_t RFM69_Aggregator::room()
+{
+  uint8_t used = (_len ? _len : 1) + RFM69_AGG_OVERHEAD; // an empty frame still needs the marker
+  uint8_t max = _radio.getMaxDataLen();
+  return used <= max ? max - used : 0;
+}
+
+// queues one record, sending the current frame first if the record doesn't fit in it
+bool RFM69_Aggregator::add(uint8_t type, const void* data, uint8_t len)
+{
+  uint8_t max = _radio.getMaxDataLen();
+  if (1 + RFM69_AGG_OVERHEAD + len > max) return false;
+  if (_len && _len + RFM69_AGG_OVERHEAD + len > max && !flush()) return false;
+  if (!_len) {
+    _buf[_len++] = RFM69_AGG_MARKER;
+    _oldest = millis();
+  }
+  _buf[_len++] = type;
+  _buf[_len++] = len;
+  memcpy(_buf + _len, data, len);
+  _len += len;
+  _count++;
+  if (!_maxDelay) return flush();
+  return true;
+}
+
+bool RFM69_Aggregator::update()
+{
+  if (_count && millis() - _oldest >= _maxDelay) return flush();
+  return true;
+}
+
+bool RFM69_Aggregator::flush()
+{
+  if (!_count) return true;
+  bool ok = true;
+  if (_retries == 0xFF) _radio.send(_toAddress, _buf, _len);
+  else ok = _radio.sendWithRetry(_toAddress, _buf, _len, _retries, _retryWaitTime);
+  if (ok) clear();
+  else _oldest = millis(); // try again after another maxDelay
+  return ok;
+}
+
+//=============================================================================
+// RFM69_RecordReader
+//=============================================================================
+RFM69_RecordReader::RFM69_RecordReader(const void* frame, uint8_t len)
+{
+  _frame = (const uint8_t*)frame;
+  _len = isAggregate(frame, len) ? len : 0;
+  _pos = _next = 0;
+  _error = !_len;
+}
+
+bool RFM69_RecordReader::isAggregate(const void* frame, uint8_t len)
+{
+  return len > 0 && ((const uint8_t*)frame)[0] == RFM69_AGG_MARKER;
+}
+
+// moves to the next record, false at the end of the frame or on a truncated record
+bool RFM69_RecordReader::next()
+{
+  if (!_len) return false;
+  _pos = _next ? _next : 1;
+  if (_pos >= _len) return false;
+  if (_pos + RFM69_AGG_OVERHEAD > _len || _pos + RFM69_AGG_OVERHEAD + _frame[_pos+1] > _len) {
+    _error = true;
+    _len = 0;
+    return false;
+  }
+  _next = _pos + RFM69_AGG_OVERHEAD + _frame[_pos+1];
+  return true;
+}
@@ -0,0 +1,85 @@
+// **********************************************************************************
+// Message aggregation: packs several small messages for the same destination into one
+// frame as type/length/value records, so they share one preamble, header, CRC and ACK.
+// The frame is sent when the next record would not fit or when the oldest record has
+// waited maxDelay ms. RFM69_RecordReader splits a received frame back into records.
+// **********************************************************************************
+// Copyright LowPowerLab LLC 2018, https://www.LowPowerLab.com/contact
+// **********************************************************************************
+// License
+// **********************************************************************************
+// This program is free software; you can redistribute it 
+// and/or modify it under the terms of the GNU General    
+// Public License as published by the Free Software       
+// Foundation; either version 3 of the License, or        
+// (at your option) any later version.                    
+//                                                        
+// This program is distributed in the hope that it will   
+// be useful, but WITHOUT ANY WARRANTY; without even the  
+// implied warranty of MERCHANTABILITY or FITNESS FOR A   
+// PARTICULAR PURPOSE. See the GNU General Public        
+// License for more details.                              
+//                                                        
+// Licence can be viewed at                               
+// http://www.gnu.org/licenses/gpl-3.0.txt
+//
+// Please maintain this license information along with authorship
+// and copyright notices in any redistribution of this code
+// **********************************************************************************
+#ifndef RFM69_AGGREGATOR_h
+#define RFM69_AGGREGATOR_h
+#include "RFM69.h"
+
+#define RFM69_AGG_MARKER     0xA6 // first payload byte of an aggregated frame
+#define RFM69_AGG_OVERHEAD   2    // per record: type + length
+
+class RFM69_Aggregator {
+  public:
+    // one aggregator per destination, maxDelay=0 sends every record on its own
+    RFM69_Aggregator(RFM69& radio, uint16_t toAddress, uint16_t maxDelay=1000);
+
+    void setRetries(uint8_t retries, uint8_t retryWaitTime=RFM69_ACK_TIMEOUT); // retries=0xFF: send() without ACK
+    bool add(uint8_t type, const void* data, uint8_t len); // false if len can never fit, or the frame it displaced was not ACKed
+    bool update();  // call from loop(): sends the frame once the oldest record is maxDelay old
+    bool flush();   // sends the pending records now, true if ACKed (or nothing to send); they are kept if not
+    void clear();   // drops the pending records
+
+    uint8_t pending() { return _count; }   // # of records waiting
+    uint8_t room();                        // largest record value that still fits in the current frame
+
+  protected:
+    RFM69& _radio;
+    uint16_t _toAddress;
+    uint16_t _maxDelay;
+    uint8_t _retries;
+    uint8_t _retryWaitTime;
+    uint8_t _buf[RF69_MAX_DATA_LEN];
+    uint8_t _len;      // 0 = empty, otherwise includes the marker
+    uint8_t _count;
+    uint32_t _oldest;  // millis() when the first pending record was added
+};
+
+// splits an aggregated frame:
+//   RFM69_RecordReader records(radio.DATA, radio.DATALEN);
+//   while (records.next()) use(records.type(), records.data(), records.length());
+//   if (records.error()) ... the frame was truncated
+class RFM69_RecordReader {
+  public:
+    RFM69_RecordReader(const void* frame, uint8_t len);
+    static bool isAggregate(const void* frame, uint8_t len);
+
+    bool next();
+    uint8_t type() { return _frame[_pos]; }
+    uint8_t length() { return _frame[_pos+1]; }
+    const uint8_t* data() { return _frame + _pos + RFM69_AGG_OVERHEAD; }
+    bool error() { return _error; }
+
+  protected:
+    const uint8_t* _frame;
+    uint8_t _len;
+    uint8_t _pos;   // current record
+    uint8_t _next;  // next record, 0 before the first next()
+    bool _error;
+};
+
+#endif
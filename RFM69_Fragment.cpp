@@ -0,0 +1,138 @@
+// **********************************************************************************
+// Fragmentation and reassembly of messages larger than one frame
+// **********************************************************************************
+// Copyright LowPowerLab LLC 2018, https://www.LowPowerLab.com/contact
+// **********************************************************************************
+// License
+// **********************************************************************************
+// This program is free software; you can redistribute it 
+// and/or modify it under the terms of the GNU General    
+// Public License as published by the Free Software       
+// Foundation; either version 3 of the License, or        
+// (at your option) any later version.                    
+//                                                        
+// This program is distributed in the hope that it will   
+// be useful, but WITHOUT ANY WARRANTY; without even the  
+// implied warranty of MERCHANTABILITY or FITNESS FOR A   
+// PARTICULAR PURPOSE. See the GNU General Public        
+// License for more details.                              
+//                                                        
+// Licence can be viewed at                               
+// http://www.gnu.org/licenses/gpl-3.0.txt
+//
+// Please maintain this license information along with authorship
+// and copyright notices in any redistribution of this code
+// **********************************************************************************
+#include "RFM69_Fragment.h"
+
+static uint32_t fragMask(uint8_t count) { return count >= 32 ? 0xFFFFFFFF : ((uint32_t)1 << count) - 1; }
+
+bool RFM69_sendFragmented(RFM69& radio, uint16_t toAddress, const void* data, uint16_t len, uint8_t rounds, uint8_t retryWaitTime)
+{
+  static uint8_t msgId;
+  uint8_t frame[RF69_MAX_DATA_LEN];
+  uint8_t count = len ? (len + RFM69_FRAG_CHUNK - 1) / RFM69_FRAG_CHUNK : 1;
+  if (len > RFM69_FRAG_MAXLEN || toAddress == RF69_BROADCAST_ADDR) return false;
+  if (RFM69_FRAG_HEADERLEN + RFM69_FRAG_CHUNK > radio.getMaxDataLen()) return false; // ex: FEC mode frames are too small
+  msgId++;
+  uint32_t missing = fragMask(count);
+
+  for (uint8_t round = 0; round < rounds; round++)
+  {
+    uint8_t last = count - 1;
+    while (!(missing & ((uint32_t)1 << last))) last--; // last fragment of this round asks for the block ACK
+    bool acked = false;
+    for (uint8_t i = 0; i <= last; i++)
+    {
+      if (!(missing & ((uint32_t)1 << i))) continue;
+      uint16_t offset = i * RFM69_FRAG_CHUNK;
+      uint8_t size = (i == count - 1) ? len - offset : RFM69_FRAG_CHUNK;
+      frame[0] = RFM69_FRAG_MARKER;
+      frame[1] = msgId;
+      frame[2] = i;
+      frame[3] = count;
+      memcpy(frame + RFM69_FRAG_HEADERLEN, (const uint8_t*)data + offset, size);
+      if (i < last) radio.send(toAddress, frame, size + RFM69_FRAG_HEADERLEN);
+      else acked = radio.sendWithRetry(toAddress, frame, size + RFM69_FRAG_HEADERLEN, 2, retryWaitTime);
+    }
+    if (!acked) continue; // everything goes again
+    // a plain ACK is the driver re-ACKing a retry it took for a duplicate (sequence numbers): the block ACK
+    // was lost, so the bitmap is unknown and the round goes again
+    if (radio.DATALEN < RFM69_FRAG_ACKLEN || radio.DATA[0] != RFM69_FRAG_MARKER || radio.DATA[1] != msgId)
+      continue;
+    uint32_t have = radio.DATA[2] | ((uint32_t)radio.DATA[3] << 8) | ((uint32_t)radio.DATA[4] << 16) | ((uint32_t)radio.DATA[5] << 24);
+    missing &= ~have;
+    if (!missing) return true;
+  }
+  return false;
+}
+
+//=============================================================================
+// RFM69_Reassembler
+//=============================================================================
+RFM69_Reassembler::RFM69_Reassembler(uint8_t* buffer, uint16_t size, uint16_t timeout)
+{
+  _buffer = buffer;
+  _size = size;
+  _timeout = timeout;
+  reset();
+}
+
+void RFM69_Reassembler::reset()
+{
+  _count = 0;
+  _bitmap = 0;
+  _length = 0;
+  _complete = false;
+}
+
+bool RFM69_Reassembler::isFragment(const void* data, uint8_t len)
+{
+  return len >= RFM69_FRAG_HEADERLEN && ((const uint8_t*)data)[0] == RFM69_FRAG_MARKER;
+}
+
+void RFM69_Reassembler::sendBlockACK(RFM69& radio, uint8_t msgId, uint32_t bitmap)
+{
+  uint8_t ack[RFM69_FRAG_ACKLEN] = { RFM69_FRAG_MARKER, msgId, (uint8_t)bitmap, (uint8_t)(bitmap >> 8), (uint8_t)(bitmap >> 16), (uint8_t)(bitmap >> 24) };
+  radio.sendACK(ack, sizeof(ack));
+}
+
+bool RFM69_Reassembler::receive(RFM69& radio)
+{
+  if (!isFragment(radio.DATA, radio.DATALEN)) return false;
+  uint16_t sender = radio.SENDERID;
+  uint8_t msgId = radio.DATA[1], index = radio.DATA[2], count = radio.DATA[3];
+  uint8_t size = radio.DATALEN - RFM69_FRAG_HEADERLEN;
+  uint16_t offset = index * RFM69_FRAG_CHUNK;
+  bool ackRequested = radio.ACKRequested();
+
+  if (count == 0 || count > RFM69_FRAG_MAX || index >= count || (index < count - 1 && size != RFM69_FRAG_CHUNK)
+      || offset + size > _size) { // malformed or too big for the buffer: refuse
+    if (ackRequested) sendBlockACK(radio, msgId, 0);
+    return false;
+  }
+
+  if (_count && millis() - _last > _timeout) reset(); // evict a stalled message
+  if (_count && (sender != _sender || msgId != _msgId)) {
+    if (!_complete) { // busy with another message, the sender retries in a later round
+      if (ackRequested) sendBlockACK(radio, msgId, 0);
+      return false;
+    }
+    reset(); // the previous message was delivered, start the new one
+  }
+  if (!_count) {
+    _sender = sender;
+    _msgId = msgId;
+    _count = count;
+  }
+
+  _last = millis();
+  memcpy(_buffer + offset, radio.DATA + RFM69_FRAG_HEADERLEN, size);
+  _bitmap |= (uint32_t)1 << index;
+  if (index == count - 1) _length = offset + size;
+  if (ackRequested) sendBlockACK(radio, msgId, _bitmap);
+
+  if (_complete || _bitmap != fragMask(_count)) return false; // retransmissions of a delivered message are only re-ACKed
+  _complete = true;
+  return true;
+}
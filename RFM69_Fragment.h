@@ -0,0 +1,86 @@
+// **********************************************************************************
+// Fragmentation and reassembly of messages larger than one frame (up to 32 fragments).
+// The sender sends every fragment without ACK except the last one of each round, whose
+// ACK carries a bitmap of the fragments the receiver holds (block ACK); only the missing
+// ones are sent again in the next round.
+// Fragment: marker, message id, index, count, data (RFM69_FRAG_CHUNK bytes except the last)
+// Block ACK payload: marker, message id, bitmap (32 bits, little endian)
+// **********************************************************************************
+// Copyright LowPowerLab LLC 2018, https://www.LowPowerLab.com/contact
+// **********************************************************************************
+// License
+// **********************************************************************************
+// This program is free software; you can redistribute it 
+// and/or modify it under the terms of the GNU General    
+// Public License as published by the Free Software       
+// Foundation; either version 3 of the License, or        
+// (at your option) any later version.                    
+//                                                        
+// This program is distributed in the hope that it will   
+// be useful, but WITHOUT ANY WARRANTY; without even the  
+// implied warranty of MERCHANTABILITY or FITNESS FOR A   
+// PARTICULAR PURPOSE. See the GNU General Public        
+// License for more details.                              
+//                                                        
+// Licence can be viewed at                               
+// http://www.gnu.org/licenses/gpl-3.0.txt
+//
+// Please maintain this license information along with authorship
+// and copyright notices in any redistribution of this code
+// **********************************************************************************
+#ifndef RFM69_FRAGMENT_h
+#define RFM69_FRAGMENT_h
+#include "RFM69.h"
+
+#define RFM69_FRAG_MARKER    0xA7 // first payload byte of a fragment and of its block ACK
+#define RFM69_FRAG_HEADERLEN 4
+#define RFM69_FRAG_CHUNK     (RF69_MAX_DATA_LEN - RFM69_FRAG_HEADERLEN - 1) // fits with sequence numbers on too
+#define RFM69_FRAG_MAX       32   // fragments per message (bitmap width)
+#define RFM69_FRAG_MAXLEN    (RFM69_FRAG_MAX * RFM69_FRAG_CHUNK)
+#define RFM69_FRAG_ACKLEN    6
+
+#ifndef RFM69_FRAG_ROUNDS
+  #define RFM69_FRAG_ROUNDS  4    // send rounds before giving up
+#endif
+
+// sends len bytes (up to RFM69_FRAG_MAXLEN), returns true once the receiver ACKed every fragment
+// the receiver must not use enableAutoACK(): the driver would ACK fragments before the reassembler sends its bitmap
+bool RFM69_sendFragmented(RFM69& radio, uint16_t toAddress, const void* data, uint16_t len,
+                          uint8_t rounds=RFM69_FRAG_ROUNDS, uint8_t retryWaitTime=RFM69_ACK_TIMEOUT);
+
+// reassembles one message at a time into a caller provided buffer:
+//   uint8_t buf[512]; RFM69_Reassembler reassembler(buf, sizeof(buf));
+//   if (radio.receiveDone()) {
+//     if (reassembler.receive(radio)) use(reassembler.sender(), reassembler.data(), reassembler.length());
+//     else if (!RFM69_Reassembler::isFragment(radio.DATA, radio.DATALEN)) ... regular packet
+//   }
+// Fragments of other messages are refused (empty bitmap) until the current one completes or
+// nothing was received for timeout ms. The completed message stays valid until the next one starts.
+class RFM69_Reassembler {
+  public:
+    RFM69_Reassembler(uint8_t* buffer, uint16_t size, uint16_t timeout=2000);
+    static bool isFragment(const void* data, uint8_t len);
+
+    bool receive(RFM69& radio); // call after receiveDone(), ACKs fragments, true when a message is complete
+    void reset();
+
+    const uint8_t* data() { return _buffer; }
+    uint16_t length() { return _length; }
+    uint16_t sender() { return _sender; }
+
+  protected:
+    void sendBlockACK(RFM69& radio, uint8_t msgId, uint32_t bitmap);
+
+    uint8_t* _buffer;
+    uint16_t _size;
+    uint16_t _timeout;
+    uint16_t _sender;
+    uint16_t _length;
+    uint8_t _msgId;
+    uint8_t _count;    // 0 = idle
+    uint32_t _bitmap;  // fragments received
+    uint32_t _last;    // millis() of the last fragment
+    bool _complete;
+};
+
+#endif
@@ -0,0 +1,204 @@
+// **********************************************************************************
+// Binary framing of received radio packets for the gateway to host serial link
+// **********************************************************************************
+// Copyright LowPowerLab LLC 2018, https://www.LowPowerLab.com/contact
+// **********************************************************************************
+// License
+// **********************************************************************************
+// This program is free software; you can redistribute it
+// and/or modify it under the terms of the GNU General
+// Public License as published by the Free Software
+// Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will
+// be useful, but WITHOUT ANY WARRANTY; without even the
+// implied warranty of MERCHANTABILITY or FITNESS FOR A
+// PARTICULAR PURPOSE. See the GNU General Public
+// License for more details.
+//
+// Licence can be viewed at
+// http://www.gnu.org/licenses/gpl-3.0.txt
+//
+// Please maintain this license information along with authorship
+// and copyright notices in any redistribution of this code
+// **********************************************************************************
+#include "RFM69_Frame.h"
+
+//===================================================================================================================
+// RFM69_frameCRC() - CRC-16/CCITT-FALSE, byte at a time without a table (cheap on AVR)
+//===================================================================================================================
+uint16_t RFM69_frameCRC(const uint8_t* data, uint8_t length, uint16_t crc)
+{
+  while (length--)
+  {
+    uint8_t x = (crc >> 8) ^ *data++;
+    x ^= x >> 4;
+    crc = (crc << 8) ^ ((uint16_t)x << 12) ^ ((uint16_t)x << 5) ^ x;
+  }
+  return crc;
+}
+
+//===================================================================================================================
+// RFM69_encodeFrame() - build the raw frame and COBS encode it into out
+//===================================================================================================================
+uint8_t RFM69_encodeFrame(const RFM69_FrameHeader& header, const void* payload, uint8_t* out)
+{
+  uint8_t raw[RFM69_FRAME_MAXRAW];
+  uint8_t length = header.length > RFM69_FRAME_MAXPAYLOAD ? RFM69_FRAME_MAXPAYLOAD : header.length;
+  raw[0] = header.type;
+  raw[1] = header.flags;
+  raw[2] = header.sender;
+  raw[3] = header.sender >> 8;
+  raw[4] = header.target;
+  raw[5] = header.target >> 8;
+  raw[6] = (uint8_t)header.rssi;
+  raw[7] = length;
+  const uint8_t* p = (const uint8_t*)payload;
+  for (uint8_t i = 0; i < length; i++)
+    raw[RFM69_FRAME_HEADERLEN + i] = p[i];
+  uint8_t rawLength = RFM69_FRAME_HEADERLEN + length;
+  uint16_t crc = RFM69_frameCRC(raw, rawLength);
+  raw[rawLength++] = crc;
+  raw[rawLength++] = crc >> 8;
+
+  // COBS: every 0x00 is replaced by the distance to the next one, raw frames never need 0xFF long blocks
+  uint8_t codeIndex = 0, outLength = 1, code = 1;
+  for (uint8_t i = 0; i < rawLength; i++)
+  {
+    if (raw[i])
+    {
+      out[outLength++] = raw[i];
+      code++;
+    }
+    else
+    {
+      out[codeIndex] = code;
+      codeIndex = outLength++;
+      code = 1;
+    }
+  }
+  out[codeIndex] = code;
+  out[outLength++] = 0;
+  return outLength;
+}
+
+//===================================================================================================================
+// RFM69_FrameDecoder::feed() - COBS decode one byte, validate the frame on the delimiter
+//===================================================================================================================
+bool RFM69_FrameDecoder::feed(uint8_t c)
+{
+  if (c == 0)
+  {
+    bool valid = false;
+    if (_overrun) overruns++;
+    else if (_length || _remaining) valid = complete(); // empty frames (back to back delimiters) are ignored
+    reset();
+    return valid;
+  }
+
+  if (_overrun) return false; // skip to the next delimiter
+
+  if (_remaining == 0) // c is a COBS code byte
+  {
+    if (_code && _code != 0xFF) // the previous block ended on an encoded 0x00
+    {
+      if (_length >= RFM69_FRAME_MAXRAW) { _overrun = true; return false; }
+      _raw[_length++] = 0;
+    }
+    _code = c;
+    _remaining = c - 1;
+    return false;
+  }
+
+  if (_length >= RFM69_FRAME_MAXRAW) { _overrun = true; return false; }
+  _raw[_length++] = c;
+  _remaining--;
+  return false;
+}
+
+bool RFM69_FrameDecoder::complete()
+{
+  // a partial block means bytes were lost, and the header length must account for every byte
+  if (_remaining || _length < RFM69_FRAME_HEADERLEN + RFM69_FRAME_CRCLEN
+      || _raw[7] != _length - RFM69_FRAME_HEADERLEN - RFM69_FRAME_CRCLEN)
+  {
+    crcErrors++;
+    return false;
+  }
+
+  uint8_t rawLength = _length - RFM69_FRAME_CRCLEN;
+  uint16_t crc = _raw[rawLength] | (uint16_t)_raw[rawLength+1] << 8;
+  if (crc != RFM69_frameCRC(_raw, rawLength))
+  {
+    crcErrors++;
+    return false;
+  }
+
+  _header.type = _raw[0];
+  _header.flags = _raw[1];
+  _header.sender = _raw[2] | (uint16_t)_raw[3] << 8;
+  _header.target = _raw[4] | (uint16_t)_raw[5] << 8;
+  _header.rssi = (int8_t)_raw[6];
+  _header.length = _raw[7];
+  _raw[rawLength] = 0; // null terminate the payload over the CRC
+  frames++;
+  return true;
+}
+
+#ifdef ARDUINO
+//===================================================================================================================
+// RFM69_FrameWriter - frames go out in a single write() so they are not interleaved with anything else
+//===================================================================================================================
+void RFM69_FrameWriter::writeFrame(const RFM69_FrameHeader& header, const void* payload)
+{
+  uint8_t frame[RFM69_FRAME_MAXLEN + 1];
+  uint8_t length = 0;
+  if (!_synced) // terminate whatever the host received before this (boot messages, noise)
+  {
+    frame[length++] = 0;
+    _synced = true;
+  }
+  length += RFM69_encodeFrame(header, payload, frame + length);
+  _out.write(frame, length);
+}
+
+void RFM69_FrameWriter::writePacket(uint16_t sender, uint16_t target, int16_t rssi, uint8_t flags, const void* payload, uint8_t length)
+{
+  RFM69_FrameHeader header;
+  header.type = RFM69_FRAME_PACKET;
+  header.flags = flags;
+  header.sender = sender;
+  header.target = target;
+  header.rssi = rssi < -128 ? -128 : (rssi > 127 ? 127 : rssi);
+  header.length = length;
+  writeFrame(header, payload);
+}
+
+size_t RFM69_FrameWriter::write(uint8_t c)
+{
+  if (c == '\r') return 1;
+  if (c == '\n')
+  {
+    if (_textLength) flush();
+    return 1;
+  }
+  if (_textLength == sizeof(_text)) flush(); // long lines are split over several frames
+  _text[_textLength++] = c;
+  return 1;
+}
+
+void RFM69_FrameWriter::flush()
+{
+  if (!_textLength) return;
+  RFM69_FrameHeader header;
+  header.type = RFM69_FRAME_TEXT;
+  header.flags = 0;
+  header.sender = 0;
+  header.target = 0;
+  header.rssi = 0;
+  header.length = _textLength;
+  _textLength = 0;
+  writeFrame(header, _text);
+}
+#endif
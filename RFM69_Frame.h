@@ -0,0 +1,116 @@
+// **********************************************************************************
+// Binary framing of received radio packets for the gateway to host serial link
+// Each frame is a header (type, flags, sender, target, RSSI, length), the raw payload
+// and a CRC16, COBS encoded and terminated by a 0x00 delimiter. Payloads can contain
+// any byte (newlines, zeros) and a frame is at most 12 bytes larger than its payload.
+// This file and RFM69_Frame.cpp have no Arduino dependencies except RFM69_FrameWriter,
+// so the same codec compiles into Linux host programs (see Examples/PiGateway/HostDecoder)
+// **********************************************************************************
+// Copyright LowPowerLab LLC 2018, https://www.LowPowerLab.com/contact
+// **********************************************************************************
+// License
+// **********************************************************************************
+// This program is free software; you can redistribute it
+// and/or modify it under the terms of the GNU General
+// Public License as published by the Free Software
+// Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will
+// be useful, but WITHOUT ANY WARRANTY; without even the
+// implied warranty of MERCHANTABILITY or FITNESS FOR A
+// PARTICULAR PURPOSE. See the GNU General Public
+// License for more details.
+//
+// Licence can be viewed at
+// http://www.gnu.org/licenses/gpl-3.0.txt
+//
+// Please maintain this license information along with authorship
+// and copyright notices in any redistribution of this code
+// **********************************************************************************
+#ifndef RFM69_FRAME_h
+#define RFM69_FRAME_h
+#include <stdint.h>
+#ifdef ARDUINO
+  #include <Print.h>
+#endif
+
+// frame types
+#define RFM69_FRAME_PACKET       0x01 // a received radio packet
+#define RFM69_FRAME_TEXT         0x02 // a text line from the gateway (status, replies to host commands, debug)
+
+// frame flags
+#define RFM69_FRAME_ACKREQ       0x01 // the sender requested an ACK
+#define RFM69_FRAME_ACK          0x02 // the packet is an ACK
+
+#define RFM69_FRAME_MAXPAYLOAD   61   // RF69_MAX_DATA_LEN
+#define RFM69_FRAME_HEADERLEN    8    // type, flags, sender(2), target(2), rssi, length
+#define RFM69_FRAME_CRCLEN       2
+#define RFM69_FRAME_MAXRAW       (RFM69_FRAME_HEADERLEN + RFM69_FRAME_MAXPAYLOAD + RFM69_FRAME_CRCLEN)
+#define RFM69_FRAME_MAXLEN       (RFM69_FRAME_MAXRAW + 2) // + COBS code byte + 0x00 delimiter (raw frames are < 254 bytes)
+
+struct RFM69_FrameHeader {
+  uint8_t type;
+  uint8_t flags;
+  uint16_t sender;
+  uint16_t target;
+  int8_t rssi;
+  uint8_t length; // payload length
+};
+
+// CRC-16/CCITT-FALSE (poly 0x1021, init 0xFFFF) over the raw header and payload
+uint16_t RFM69_frameCRC(const uint8_t* data, uint8_t length, uint16_t crc=0xFFFF);
+
+// encodes a frame into out (at least RFM69_FRAME_MAXLEN bytes), returns the # of bytes including the delimiter
+// payloads longer than RFM69_FRAME_MAXPAYLOAD are truncated
+uint8_t RFM69_encodeFrame(const RFM69_FrameHeader& header, const void* payload, uint8_t* out);
+
+// incremental decoder, feed it every byte read from the serial port:
+//   if (decoder.feed(c)) handle(decoder.header(), decoder.payload());
+// resynchronizes on the next 0x00 after noise, a partial frame or text output
+class RFM69_FrameDecoder {
+  public:
+    RFM69_FrameDecoder() { reset(); frames = crcErrors = overruns = 0; }
+    void reset() { _length = 0; _remaining = 0; _code = 0; _overrun = false; }
+    bool feed(uint8_t c); // true when c completed a valid frame
+
+    const RFM69_FrameHeader& header() { return _header; }
+    const uint8_t* payload() { return _raw + RFM69_FRAME_HEADERLEN; } // null terminated for convenience
+
+    uint32_t frames;    // valid frames
+    uint32_t crcErrors; // frames dropped because of a bad CRC or inconsistent length
+    uint32_t overruns;  // frames dropped because they were too long
+
+  protected:
+    bool complete();
+
+    RFM69_FrameHeader _header;
+    uint8_t _raw[RFM69_FRAME_MAXRAW + 1];
+    uint8_t _length;
+    uint8_t _remaining; // bytes left in the current COBS block
+    uint8_t _code;      // code byte of the current COBS block, 0 before the first one
+    bool _overrun;
+};
+
+#ifdef ARDUINO
+// Print that sends the gateway's text output as RFM69_FRAME_TEXT frames (one per line)
+// and received packets as RFM69_FRAME_PACKET frames, so both can share the serial port:
+//   RFM69_FrameWriter host(Serial); host.println("GATEWAYSTART"); host.writePacket(radio.SENDERID, radio.TARGETID, rssi, 0, radio.DATA, radio.DATALEN);
+class RFM69_FrameWriter : public Print {
+  public:
+    RFM69_FrameWriter(Print& out) : _out(out), _textLength(0), _synced(false) {}
+    void writeFrame(const RFM69_FrameHeader& header, const void* payload);
+    void writePacket(uint16_t sender, uint16_t target, int16_t rssi, uint8_t flags, const void* payload, uint8_t length);
+    virtual size_t write(uint8_t c);
+    using Print::write;
+    void flush(); // sends any partial text line
+
+  protected:
+    Print& _out;
+    char _text[RFM69_FRAME_MAXPAYLOAD];
+    uint8_t _textLength;
+    bool _synced;
+};
+#endif
+
+#endif
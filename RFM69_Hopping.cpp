@@ -0,0 +1,132 @@
+// **********************************************************************************
+// Frequency hopping: per band channel plans whose FRF values are computed at compile
+// time, and a hop sequence derived from a seed (ex: the network ID) so every node of
+// the network visits the channels in the same order. Switching channel is one FRF
+// burst write plus an RX restart, well under a millisecond.
+// **********************************************************************************
+// Copyright LowPowerLab LLC 2018, https://www.LowPowerLab.com/contact
+// **********************************************************************************
+// License
+// **********************************************************************************
+// This program is free software; you can redistribute it 
+// and/or modify it under the terms of the GNU General    
+// Public License as published by the Free Software       
+// Foundation; either version 3 of the License, or        
+// (at your option) any later version.                    
+//                                                        
+// This program is distributed in the hope that it will   
+// be useful, but WITHOUT ANY WARRANTY; without even the  
+// implied warranty of MERCHANTABILITY or FITNESS FOR A   
+// PARTICULAR PURPOSE. See the GNU General Public        
+// License for more details.                              
+//                                                        
+// Licence can be viewed at                               
+// http://www.gnu.org/licenses/gpl-3.0.txt
+//
+// Please maintain this license information along with authorship
+// and copyright notices in any redistribution of this code
+// **********************************************************************************
+#include "RFM69_Hopping.h"
+#include "RFM69registers.h"
+
+#define HOP(first, spacing, n) RF69_hzToFRF((first) + (uint32_t)(spacing) * (n))
+#define HOP8(first, spacing, n) HOP(first, spacing, n), HOP(first, spacing, n+1), HOP(first, spacing, n+2), HOP(first, spacing, n+3), \
+                                HOP(first, spacing, n+4), HOP(first, spacing, n+5), HOP(first, spacing, n+6), HOP(first, spacing, n+7)
+
+// each FRF is rounded on its own, adding a spacing in FSTEP units at runtime would drift
+#if defined(__AVR__)
+  #define HOP_TABLE(name) static const uint32_t name[] PROGMEM =
+  #define HOP_READ(table, channel) pgm_read_dword(&table[channel])
+#else
+  #define HOP_TABLE(name) static const uint32_t name[] =
+  #define HOP_READ(table, channel) table[channel]
+#endif
+
+HOP_TABLE(HOP_315) { HOP8(314300000UL, 200000UL, 0) };
+HOP_TABLE(HOP_433) { HOP8(433300000UL, 200000UL, 0) };
+HOP_TABLE(HOP_868) { HOP8(865100000UL, 200000UL, 0), HOP8(865100000UL, 200000UL, 8) };
+HOP_TABLE(HOP_915) { HOP8(902300000UL, 500000UL, 0), HOP8(902300000UL, 500000UL, 8), HOP8(902300000UL, 500000UL, 16),
+                     HOP8(902300000UL, 500000UL, 24), HOP8(902300000UL, 500000UL, 32), HOP8(902300000UL, 500000UL, 40),
+                     HOP(902300000UL, 500000UL, 48), HOP(902300000UL, 500000UL, 49) };
+
+#define HOP_COUNT(table) (uint8_t)(sizeof(table) / sizeof(table[0]))
+
+uint8_t RFM69_Hopper::channels(uint8_t freqBand)
+{
+  switch (freqBand) {
+    case RF69_315MHZ: return HOP_COUNT(HOP_315);
+    case RF69_433MHZ: return HOP_COUNT(HOP_433);
+    case RF69_868MHZ: return HOP_COUNT(HOP_868);
+    default: return HOP_COUNT(HOP_915);
+  }
+}
+
+uint32_t RFM69_Hopper::channelFRF(uint8_t freqBand, uint8_t channel)
+{
+  if (channel >= channels(freqBand)) channel = 0;
+  switch (freqBand) {
+    case RF69_315MHZ: return HOP_READ(HOP_315, channel);
+    case RF69_433MHZ: return HOP_READ(HOP_433, channel);
+    case RF69_868MHZ: return HOP_READ(HOP_868, channel);
+    default: return HOP_READ(HOP_915, channel);
+  }
+}
+
+static uint8_t gcd(uint8_t a, uint8_t b)
+{
+  while (b) { uint8_t t = a % b; a = b; b = t; }
+  return a;
+}
+
+RFM69_Hopper::RFM69_Hopper(RFM69& radio, uint8_t freqBand, uint8_t seed) : _radio(radio)
+{
+  _freqBand = freqBand;
+  _channels = channels(freqBand);
+  _offset = seed % _channels;
+  // a large step spreads consecutive hops across the band, the seed keeps networks apart
+  _step = _channels / 3 + seed % (_channels / 2 + 1);
+  while (_channels > 1 && gcd(_step, _channels) != 1) _step++;
+  _position = 0;
+  _channel = 0xFF; // not tuned yet
+}
+
+uint8_t RFM69_Hopper::channelAt(uint32_t position)
+{
+  return ((uint16_t)(position % _channels) * _step + _offset) % _channels;
+}
+
+void RFM69_Hopper::setChannel(uint8_t channel)
+{
+  _channel = channel;
+  _radio.setFRF(channelFRF(_freqBand, channel));
+}
+
+void RFM69_Hopper::hopTo(uint32_t position)
+{
+  _position = position % _channels;
+  setChannel(channelAt(_position));
+}
+
+bool RFM69_Hopper::follow(uint32_t time, uint16_t dwell)
+{
+  uint8_t position = (time / (dwell ? dwell : 1)) % _channels;
+  if (position == _position && _channel != 0xFF) return false;
+  hopTo(position);
+  return true;
+}
+
+void RFM69_Hopper::scan(uint16_t dwellUs, RFM69_RSSIStats* results)
+{
+  _radio.scanBegin();
+  for (uint8_t i = 0; i < _channels; i++) _radio.scanChannel(channelFRF(_freqBand, i), dwellUs, results[i]);
+  _radio.scanEnd();
+}
+
+uint8_t RFM69_Hopper::quietest(const RFM69_RSSIStats* results)
+{
+  uint8_t best = 0;
+  for (uint8_t i = 1; i < _channels; i++)
+    if (results[i].avg < results[best].avg || (results[i].avg == results[best].avg && results[i].max < results[best].max))
+      best = i;
+  return best;
+}
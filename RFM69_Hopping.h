@@ -0,0 +1,70 @@
+// **********************************************************************************
+// Frequency hopping: per band channel plans whose FRF values are computed at compile
+// time, and a hop sequence derived from a seed (ex: the network ID) so every node of
+// the network visits the channels in the same order. Switching channel is one FRF
+// burst write plus an RX restart, well under a millisecond.
+// **********************************************************************************
+// Copyright LowPowerLab LLC 2018, https://www.LowPowerLab.com/contact
+// **********************************************************************************
+// License
+// **********************************************************************************
+// This program is free software; you can redistribute it 
+// and/or modify it under the terms of the GNU General    
+// Public License as published by the Free Software       
+// Foundation; either version 3 of the License, or        
+// (at your option) any later version.                    
+//                                                        
+// This program is distributed in the hope that it will   
+// be useful, but WITHOUT ANY WARRANTY; without even the  
+// implied warranty of MERCHANTABILITY or FITNESS FOR A   
+// PARTICULAR PURPOSE. See the GNU General Public        
+// License for more details.                              
+//                                                        
+// Licence can be viewed at                               
+// http://www.gnu.org/licenses/gpl-3.0.txt
+//
+// Please maintain this license information along with authorship
+// and copyright notices in any redistribution of this code
+// **********************************************************************************
+#ifndef RFM69_HOPPING_h
+#define RFM69_HOPPING_h
+#include "RFM69.h"
+
+// channel plans, check them against your local regulations:
+//   RF69_315MHZ:  8 channels, 314.3 - 315.7MHz, 200kHz apart
+//   RF69_433MHZ:  8 channels, 433.3 - 434.7MHz, 200kHz apart
+//   RF69_868MHZ: 16 channels, 865.1 - 868.1MHz, 200kHz apart
+//   RF69_915MHZ: 50 channels, 902.3 - 926.8MHz, 500kHz apart (FCC 15.247 asks for 50 when hopping)
+
+// Both ends must be on the same channel, either by hopping on a shared clock:
+//   hopper.follow(tdma.gatewayTime(), DWELL_MS); // ex: the TDMA beacon time, see RFM69_TDMA.h
+// or by stepping together after each exchange: hopper.hop();
+class RFM69_Hopper {
+  public:
+    RFM69_Hopper(RFM69& radio, uint8_t freqBand, uint8_t seed=0); // same band and seed on every node
+    static uint8_t channels(uint8_t freqBand);
+    static uint32_t channelFRF(uint8_t freqBand, uint8_t channel);
+
+    uint8_t channels() { return _channels; }
+    uint8_t channelAt(uint32_t position);       // channel at a position of the hop sequence
+    void setChannel(uint8_t channel);           // tunes the radio, ex: to a rendezvous channel outside the sequence
+    void hopTo(uint32_t position);              // tunes to the channel at position
+    void hop() { hopTo(_position + 1); }        // next channel of the sequence
+    bool follow(uint32_t time, uint16_t dwell); // hops every dwell ms of a shared clock, true when it changed channel
+    void scan(uint16_t dwellUs, RFM69_RSSIStats* results); // RSSI of every channel of the plan, results[channels()]
+    uint8_t quietest(const RFM69_RSSIStats* results);      // channel with the lowest average RSSI (then peak) in scan() results
+
+    uint8_t position() { return _position; }
+    uint8_t channel() { return _channel; }
+
+  protected:
+    RFM69& _radio;
+    uint8_t _freqBand;
+    uint8_t _channels;
+    uint8_t _step;     // hop sequence: channel = (position * _step + _offset) % _channels, _step coprime with _channels
+    uint8_t _offset;
+    uint8_t _position;
+    uint8_t _channel;
+};
+
+#endif
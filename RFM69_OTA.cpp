@@ -35,6 +35,11 @@
 
 #ifdef __AVR__
   #include <avr/wdt.h>
+  #include <avr/pgmspace.h>
+#endif
+
+#if defined(__SSE2__)
+  #include <emmintrin.h> //host builds: decode 16 bytes of HEX at a time, see decodeHEXRecord()
 #endif
 
 //===================================================================================================================
@@ -50,7 +55,7 @@ void CheckForWirelessHEX(RFM69& radio, SPIFlash& flash, uint8_t DEBUG, uint8_t L
   if (radio.DATALEN >= 4 && radio.DATA[0]=='F' && radio.DATA[1]=='L' && radio.DATA[2]=='X' && radio.DATA[3]=='?')
   {
     uint16_t remoteID = radio.SENDERID;
-    if (radio.DATALEN == 7 && radio.DATA[4]=='E' && radio.DATA[5]=='O' && radio.DATA[6]=='F')
+    if ((radio.DATALEN == 7 || (radio.DATALEN == 16 && radio.DATA[7]==':')) && radio.DATA[4]=='E' && radio.DATA[5]=='O' && radio.DATA[6]=='F')
     { //sender must have not received EOF ACK so just resend
       radio.send(remoteID, "FLX?OK",6);
     }
@@ -105,13 +110,17 @@ uint8_t HandleHandshakeACK(RFM69& radio, SPIFlash& flash, uint8_t flashCheck) {
 // that also shifts channel when SHIFTCHANNEL is defined
 //===================================================================================================================
 #ifdef SHIFTCHANNEL
+// SHIFTCHANNEL in FRF steps, computed at compile time (it can be negative)
+#define SHIFTCHANNEL_FRF ((SHIFTCHANNEL) < 0 ? -(int32_t)RF69_hzToFRF(-(SHIFTCHANNEL)) : (int32_t)RF69_hzToFRF(SHIFTCHANNEL))
+
 uint8_t HandleWirelessHEXDataWrapper(RFM69& radio, uint16_t remoteID, SPIFlash& flash, uint8_t DEBUG, uint8_t LEDpin) {
   if (!HandleHandshakeACK(radio, flash)) return false;
-  if (DEBUG) { Serial.println(F("FLX?OK (ACK sent)")); Serial.print(F("Shifting channel to ")); Serial.println(radio.getFrequency() + SHIFTCHANNEL);}
-  radio.setFrequency(radio.getFrequency() + SHIFTCHANNEL); //shift center freq by SHIFTCHANNEL amount
+  uint32_t frf = radio.getFRF();
+  if (DEBUG) { Serial.println(F("FLX?OK (ACK sent)")); Serial.print(F("Shifting channel to ")); Serial.println(RF69_frfToHz(frf + SHIFTCHANNEL_FRF));}
+  radio.setFRF(frf + SHIFTCHANNEL_FRF); //shift center freq by SHIFTCHANNEL amount
   uint8_t result = HandleWirelessHEXData(radio, remoteID, flash, DEBUG, LEDpin);
-  if (DEBUG) { Serial.print(F("UNShifting channel to ")); Serial.println(radio.getFrequency() - SHIFTCHANNEL);}
-  radio.setFrequency(radio.getFrequency() - SHIFTCHANNEL); //restore center freq
+  if (DEBUG) { Serial.print(F("UNShifting channel to ")); Serial.println(RF69_frfToHz(frf));}
+  radio.setFRF(frf); //restore center freq
   return result;
 }
 #endif
@@ -130,6 +139,7 @@ uint8_t HandleWirelessHEXData(RFM69& radio, uint16_t remoteID, SPIFlash& flash,
   uint16_t tmp,seq=0;
   char buffer[16];
   uint16_t timeout = 3000; //3s for flash data
+  uint32_t imageCRC = 0xFFFFFFFF; //running CRC32 of every byte written to flash, checked against the one sent with FLX?EOF
   
 #ifndef SHIFTCHANNEL
   HandleHandshakeACK(radio, flash);
@@ -194,6 +204,7 @@ uint8_t HandleWirelessHEXData(RFM69& radio, uint16_t remoteID, SPIFlash& flash,
               seq++;
               for(uint8_t i=index;i<dataLen;i++)
               {
+                imageCRC = updateCRC32(imageCRC, radio.DATA[i]);
                 flash.writeByte(bytesFlashed++, radio.DATA[i]);
                 if (bytesFlashed%32768==0) flash.blockErase32K(bytesFlashed);//erase subsequent 32K blocks (possible in case of atmega1284p)
               }
@@ -217,9 +228,18 @@ uint8_t HandleWirelessHEXData(RFM69& radio, uint16_t remoteID, SPIFlash& flash,
             HandleHandshakeACK(radio, flash);
             if (DEBUG) Serial.println(F("FLX?OK resend"));
           }
-          if (dataLen==7 && radio.DATA[4]=='E' && radio.DATA[5]=='O' && radio.DATA[6]=='F') //Expected EOF
+          if ((dataLen==7 || (dataLen==16 && radio.DATA[7]==':')) && radio.DATA[4]=='E' && radio.DATA[5]=='O' && radio.DATA[6]=='F') //Expected EOF
           {
-          
+            if (dataLen==16) //FLX?EOF:XXXXXXXX - sender included the CRC32 of the whole image
+            {
+              uint32_t expectedCRC;
+              if (!CRC32fromHEX((char*)radio.DATA+8, expectedCRC) || expectedCRC != ~imageCRC) {
+                if (DEBUG) { Serial.print(F("IMG CRC mismatch, got ")); Serial.println(~imageCRC, HEX); }
+                radio.sendACK("FLX?NOK:CRC",11);
+                return false; //just return, let MAIN timeout
+              }
+            }
+
 #if defined (MOTEINO_M0)
             if ((bytesFlashed-10)>253952) { //max 253952 - 10 bytes (signature)
               if (DEBUG) Serial.println(F("IMG > 253952, too big"));
@@ -285,13 +305,41 @@ uint8_t readSerialLine(char* input, char endOfLineChar, uint8_t maxLength, uint1
 }
 
 
+//===================================================================================================================
+// pollSerialLine() - non blocking version of readSerialLine(), consumes whatever serial bytes are available
+// returns the length of a complete \n terminated line (null-terminated in input) or 0 if the line is not complete yet
+// inputPos keeps the partial line length between calls, empty lines and \r are skipped
+//===================================================================================================================
+uint8_t pollSerialLine(char* input, uint8_t& inputPos, uint8_t maxLength)
+{
+  while (Serial.available() > 0)
+  {
+    char c = Serial.read();
+    if (c == '\r') continue;
+    if (c == '\n')
+    {
+      if (inputPos == 0) continue;
+      uint8_t inputLen = inputPos;
+      input[inputLen] = 0; //null-terminate it
+      inputPos = 0;
+      return inputLen;
+    }
+    if (inputPos < maxLength-1) input[inputPos++] = c;
+  }
+  return 0;
+}
+
+
 //===================================================================================================================
 // CheckForSerialHEX() - returns TRUE if a HEX file transmission was detected and it was actually transmitted successfully
+// "FLX?" starts the classic lockstep transfer, "FLX?STREAM" starts a transfer where the host may send up to
+// OTA_STREAM_WINDOW records ahead of the radio (see HandleSerialHEXStream())
 // this is called at the OTA programmer side
 //===================================================================================================================
 uint8_t CheckForSerialHEX(uint8_t* input, uint8_t inputLen, RFM69& radio, uint16_t targetID, uint16_t TIMEOUT, uint16_t ACKTIMEOUT, uint8_t DEBUG)
 {
-  if (inputLen == 4 && input[0]=='F' && input[1]=='L' && input[2]=='X' && input[3]=='?') {
+  uint8_t stream = inputLen == 10 && memcmp(input+4, "STREAM", 6)==0;
+  if ((inputLen == 4 || stream) && input[0]=='F' && input[1]=='L' && input[2]=='X' && input[3]=='?') {
     if (HandleSerialHandshake(radio, targetID, false, TIMEOUT, ACKTIMEOUT, DEBUG))
     {
       if (radio.DATALEN >= 7 && radio.DATA[4] == 'N')
@@ -300,11 +348,16 @@ uint8_t CheckForSerialHEX(uint8_t* input, uint8_t inputLen, RFM69& radio, uint16
         return false;
       }
       
-      Serial.println(F("\nFLX?OK")); //signal serial handshake back to host script
+      if (stream)
+      {
+        Serial.print(F("\nFLX?OK:STREAM:")); //signal serial handshake back to host script, along with the window it may use
+        Serial.println(OTA_STREAM_WINDOW);
+      }
+      else Serial.println(F("\nFLX?OK")); //signal serial handshake back to host script
 #ifdef SHIFTCHANNEL
-      if (HandleSerialHEXDataWrapper(radio, targetID, TIMEOUT, ACKTIMEOUT, DEBUG))
+      if (HandleSerialHEXDataWrapper(radio, targetID, TIMEOUT, ACKTIMEOUT, DEBUG, stream))
 #else
-      if (HandleSerialHEXData(radio, targetID, TIMEOUT, ACKTIMEOUT, DEBUG))
+      if (stream ? HandleSerialHEXStream(radio, targetID, TIMEOUT, ACKTIMEOUT, DEBUG) : HandleSerialHEXData(radio, targetID, TIMEOUT, ACKTIMEOUT, DEBUG))
 #endif
       {
         Serial.println(F("FLX?OK")); //signal EOF serial handshake back to host script
@@ -323,13 +376,24 @@ uint8_t CheckForSerialHEX(uint8_t* input, uint8_t inputLen, RFM69& radio, uint16
 //===================================================================================================================
 // HandleSerialHandshake() - handles the handshake with the serial port
 //===================================================================================================================
-uint8_t HandleSerialHandshake(RFM69& radio, uint16_t targetID, uint8_t isEOF, uint16_t TIMEOUT, uint16_t ACKTIMEOUT, uint8_t DEBUG)
+uint8_t HandleSerialHandshake(RFM69& radio, uint16_t targetID, uint8_t isEOF, uint16_t TIMEOUT, uint16_t ACKTIMEOUT, uint8_t DEBUG, uint32_t imageCRC)
 {
   long now = millis();
+  char handshake[17] = "FLX?";
+  uint8_t handshakeLen = 4;
+
+  if (isEOF)
+  {
+#ifdef IMAGE_CRC
+    handshakeLen = sprintf(handshake, "FLX?EOF:%08lX", (unsigned long)imageCRC);
+#else
+    handshakeLen = sprintf(handshake, "FLX?EOF");
+#endif
+  }
 
   while (millis()-now<TIMEOUT)
   {
-    if (radio.sendWithRetry(targetID, isEOF ? "FLX?EOF" : "FLX?", isEOF?7:4, 2,ACKTIMEOUT))
+    if (radio.sendWithRetry(targetID, handshake, handshakeLen, 2,ACKTIMEOUT))
       if (radio.DATALEN >= 6 && radio.DATA[0]=='F' && radio.DATA[1]=='L' && radio.DATA[2]=='X' && radio.DATA[3]=='?')
         return true;
   }
@@ -343,15 +407,84 @@ uint8_t HandleSerialHandshake(RFM69& radio, uint16_t targetID, uint8_t isEOF, ui
 // HandleSerialHEXDataWrapper() - wrapper for HandleSerialHEXData(), also shifts the channel if SHIFTCHANNEL is defined
 //===================================================================================================================
 #ifdef SHIFTCHANNEL
-uint8_t HandleSerialHEXDataWrapper(RFM69& radio, uint16_t targetID, uint16_t TIMEOUT, uint16_t ACKTIMEOUT, uint8_t DEBUG) {
-  radio.setFrequency(radio.getFrequency() + SHIFTCHANNEL); //shift center freq by SHIFTCHANNEL amount
-  uint8_t result = HandleSerialHEXData(radio, targetID, TIMEOUT, ACKTIMEOUT, DEBUG);
-  radio.setFrequency(radio.getFrequency() - SHIFTCHANNEL); //shift center freq by SHIFTCHANNEL amount
+uint8_t HandleSerialHEXDataWrapper(RFM69& radio, uint16_t targetID, uint16_t TIMEOUT, uint16_t ACKTIMEOUT, uint8_t DEBUG, uint8_t stream) {
+  uint32_t frf = radio.getFRF();
+  radio.setFRF(frf + SHIFTCHANNEL_FRF); //shift center freq by SHIFTCHANNEL amount
+  uint8_t result = stream ? HandleSerialHEXStream(radio, targetID, TIMEOUT, ACKTIMEOUT, DEBUG) : HandleSerialHEXData(radio, targetID, TIMEOUT, ACKTIMEOUT, DEBUG);
+  radio.setFRF(frf); //restore center freq
   return result;
 }
 #endif
 
 
+//===================================================================================================================
+// HandleSerialEOF() - sends FLX?EOF (with the image CRC) to the node being OTA programmed once the host signaled EOF
+// host may send FLX?EOF:XXXXXXXX with the CRC32 of the image it read, this must match what was sent over the air
+//===================================================================================================================
+static uint8_t HandleSerialEOF(RFM69& radio, uint16_t targetID, char* input, uint8_t inputLen, uint32_t imageCRC, uint16_t TIMEOUT, uint16_t ACKTIMEOUT, uint8_t DEBUG)
+{
+  uint32_t hostCRC;
+  if (inputLen==16 && (!CRC32fromHEX(input+8, hostCRC) || hostCRC != ~imageCRC))
+  {
+    Serial.println(F("FLX?NOK:CRC"));
+    return false;
+  }
+
+  //SEND RADIO EOF
+  if (!HandleSerialHandshake(radio, targetID, true, TIMEOUT, ACKTIMEOUT, DEBUG, ~imageCRC)) return false;
+  if (radio.DATALEN >= 7 && radio.DATA[4] == 'N')
+  {
+    Serial.println((char*)radio.DATA); //target rejected the image (ex: FLX?NOK:CRC)
+    return false;
+  }
+  return true;
+}
+
+
+//===================================================================================================================
+// parseSerialSEQ() - parses the "FLX:seq:" header of a host line, returns the index of the HEX record or 0 if invalid
+//===================================================================================================================
+static uint8_t parseSerialSEQ(char* input, uint16_t& seq)
+{
+  uint8_t index = 3;
+  seq = 0;
+  for (uint8_t i = 4; i<8; i++) //up to 4 characters for seq number
+  {
+    if (input[i] >=48 && input[i]<=57)
+      seq = seq*10+input[i]-48;
+    else if (input[i]==':')
+    {
+      if (i==4)
+        return 0;
+      else break;
+    }
+    index++;
+  }
+  if (input[++index] != ':') return 0;
+  return index+1;
+}
+
+
+//===================================================================================================================
+// parseHEXPacketACK() - returns true if the last received packet is a FLX:seq:OK ACK, and extracts its seq
+//===================================================================================================================
+static uint8_t parseHEXPacketACK(RFM69& radio, uint16_t& seq)
+{
+  uint8_t ackLen = radio.DATALEN;
+  if (ackLen >= 8 && radio.DATA[0]=='F' && radio.DATA[1]=='L' && radio.DATA[2]=='X' && 
+      radio.DATA[3]==':' && radio.DATA[ackLen-3]==':' &&
+      radio.DATA[ackLen-2]=='O' && radio.DATA[ackLen-1]=='K')
+  {
+    // uint16_t is unsigned int on AVR but unsigned short elsewhere, scan into an unsigned int on every platform
+    unsigned int value = 0;
+    sscanf((const char*)radio.DATA, "FLX:%u:OK", &value);
+    seq = value;
+    return true;
+  }
+  return false;
+}
+
+
 //===================================================================================================================
 // HandleSerialHEXData() - handles the transmission of the HEX image from the serial port to the node being OTA programmed
 // this is called at the OTA programmer side
@@ -362,6 +495,7 @@ uint8_t HandleSerialHEXData(RFM69& radio, uint16_t targetID, uint16_t TIMEOUT, u
   uint16_t remoteID = radio.SENDERID; //save the remoteID as soon as possible
   uint8_t sendBuf[57];
   char input[115];
+  uint32_t imageCRC = 0xFFFFFFFF; //running CRC32 of the image bytes ACKed by the target
   //a FLASH record should not be more than 64 bytes: FLX:9999:10042000FF4FA591B4912FB7F894662321F48C91D6 
 
   while(1) {
@@ -374,35 +508,26 @@ uint8_t HandleSerialHEXData(RFM69& radio, uint16_t targetID, uint16_t TIMEOUT, u
       {
         if (input[3]==':')
         {
-          uint8_t index = 3;
-          for (uint8_t i = 4; i<8; i++) //up to 4 characters for seq number
-          {
-            if (input[i] >=48 && input[i]<=57)
-              tmp = tmp*10+input[i]-48;
-            else if (input[i]==':')
-            {
-              if (i==4)
-                return false;
-              else break;
-            }
-            index++;
-          }
-          //Serial.print(F("input[index] = "));Serial.print(F("["));Serial.print(index);Serial.print(F("]="));Serial.println(input[index]);
-          if (input[++index] != ':') return false;
+          uint8_t index = parseSerialSEQ(input, tmp);
+          if (index == 0) return false;
           now = millis(); //got good packet
-          index++;
-          uint8_t hexDataLen = validateHEXData(input+index, inputLen-index);
+          //validate the HEX record and extract its data to BYTEs in sendBuf right after the FLX:seq: prefix in a single pass
+          HEXRecord record;
+          uint8_t seqLen = sprintf((char*)sendBuf, "FLX:%u:", tmp);
+          uint8_t hexDataLen = decodeHEXRecord(input+index, inputLen-index, sendBuf+seqLen, sizeof(sendBuf)-seqLen, record);
 
           if (hexDataLen>0 && hexDataLen<253)
           {
             if (tmp==seq) //only read data when packet number is the next expected SEQ number
             {
-              uint8_t sendBufLen = prepareSendBuffer(input+index+8, sendBuf, hexDataLen, seq); //extract HEX data from input to BYTE data into sendBuf (go from 2 HEX bytes to 1 byte), +8 jumps over the header to the HEX raw data
+              uint8_t sendBufLen = seqLen+hexDataLen;
               //Serial.print(F("PREP "));Serial.print(sendBufLen); Serial.print(F(" > ")); PrintHex83(sendBuf, sendBufLen);
               
               //SEND RADIO DATA
               if (sendHEXPacket(radio, remoteID, sendBuf, sendBufLen, seq, TIMEOUT, ACKTIMEOUT, DEBUG))
               {
+                for (uint8_t i=sendBufLen-hexDataLen; i<sendBufLen; i++)
+                  imageCRC = updateCRC32(imageCRC, sendBuf[i]);
                 sprintf((char*)sendBuf, "FLX:%u:OK",seq);
                 Serial.println((char*)sendBuf); //response to host
                 seq++;
@@ -413,11 +538,8 @@ uint8_t HandleSerialHEXData(RFM69& radio, uint16_t targetID, uint16_t TIMEOUT, u
           //else Serial.print(F("FLX:INV"));
           else { Serial.print(F("FLX:INV:"));Serial.println(hexDataLen); }
         }
-        if (inputLen==7 && input[3]=='?' && input[4]=='E' && input[5]=='O' && input[6]=='F')
-        {
-          //SEND RADIO EOF
-          return HandleSerialHandshake(radio, targetID, true, TIMEOUT, ACKTIMEOUT, DEBUG);
-        }
+        if ((inputLen==7 || (inputLen==16 && input[7]==':')) && input[3]=='?' && input[4]=='E' && input[5]=='O' && input[6]=='F')
+          return HandleSerialEOF(radio, targetID, input, inputLen, imageCRC, TIMEOUT, ACKTIMEOUT, DEBUG);
       }
     }
     
@@ -434,6 +556,114 @@ timeoutcheck:
 }
 
 
+//===================================================================================================================
+// HandleSerialHEXStream() - streaming version of HandleSerialHEXData()
+// The host does not wait for FLX:seq:OK before sending the next record. Instead:
+//   - every valid record is decoded into a ring of OTA_STREAM_WINDOW send buffers and confirmed with FLX:seq:BUF
+//   - the host may send the next record as soon as the previous one is confirmed with BUF (this keeps at most one
+//     line in flight so the UART RX buffer never overflows), as long as it has no more than OTA_STREAM_WINDOW
+//     records outstanding without an FLX:seq:OK
+//   - FLX:seq:OK is still reported once the target ACKed the record, same as in HandleSerialHEXData()
+// Serial input is consumed while waiting for radio ACKs, so the next record is always decoded and ready to transmit
+// this is called at the OTA programmer side
+//===================================================================================================================
+uint8_t HandleSerialHEXStream(RFM69& radio, uint16_t targetID, uint16_t TIMEOUT, uint16_t ACKTIMEOUT, uint8_t DEBUG) {
+  long now=millis();
+  uint16_t seq=0, txSeq=0, tmp;
+  uint16_t remoteID = radio.SENDERID; //save the remoteID as soon as possible
+  uint8_t sendBuf[OTA_STREAM_WINDOW][57];
+  uint8_t sendBufLen[OTA_STREAM_WINDOW];
+  uint8_t hexDataLen[OTA_STREAM_WINDOW];
+  uint8_t head=0, count=0;
+  char input[115];
+  uint8_t inputPos=0, inputLen;
+  char eofInput[17];
+  uint8_t eofLen=0;
+  uint32_t sentTime=0;
+  uint8_t waitingACK=false;
+  uint32_t imageCRC = 0xFFFFFFFF; //running CRC32 of the image bytes ACKed by the target
+
+  while(1) {
+    //move any complete line from the host into the ring
+    inputLen = pollSerialLine(input, inputPos);
+    if (inputLen >= 6 && input[0]=='F' && input[1]=='L' && input[2]=='X')
+    {
+      if (input[3]==':')
+      {
+        uint8_t index = parseSerialSEQ(input, tmp);
+        if (index == 0) return false;
+        //decode straight into the next free slot, when there is none the record is only validated
+        HEXRecord record;
+        uint8_t slot = (head+count)%OTA_STREAM_WINDOW;
+        uint8_t* slotBuf = count<OTA_STREAM_WINDOW ? sendBuf[slot] : NULL;
+        char seqHeader[12];
+        uint8_t seqLen = sprintf(seqHeader, "FLX:%u:", tmp); //the room left for data is the same whether it is stored or not
+        if (slotBuf) memcpy(slotBuf, seqHeader, seqLen);
+        uint8_t dataLen = decodeHEXRecord(input+index, inputLen-index, slotBuf ? slotBuf+seqLen : NULL, sizeof(sendBuf[0])-seqLen, record);
+
+        if (dataLen>0 && dataLen<253)
+        {
+          if (tmp==seq && slotBuf)
+          {
+            sendBufLen[slot] = seqLen+dataLen;
+            hexDataLen[slot] = dataLen;
+            count++;
+            Serial.print(F("FLX:"));Serial.print(seq);Serial.println(F(":BUF"));
+            seq++;
+            now = millis(); //got good packet
+          }
+          else if (tmp<seq) { Serial.print(F("FLX:"));Serial.print(tmp);Serial.println(F(":BUF")); } //host missed the BUF confirmation
+          else { Serial.print(F("FLX:"));Serial.print(tmp);Serial.println(F(":FULL")); } //host overran the window
+        }
+        else { Serial.print(F("FLX:INV:"));Serial.println(dataLen); }
+      }
+      else if ((inputLen==7 || (inputLen==16 && input[7]==':')) && input[3]=='?' && input[4]=='E' && input[5]=='O' && input[6]=='F')
+      {
+        memcpy(eofInput, input, inputLen+1); //send EOF once the ring is drained
+        eofLen = inputLen;
+      }
+    }
+
+    //keep the radio busy with the record at the head of the ring
+    if (count)
+    {
+      if (!waitingACK)
+      {
+        if (DEBUG) { Serial.print(F("RFTX > ")); PrintHex83(sendBuf[head], sendBufLen[head]); }
+        radio.send(remoteID, sendBuf[head], sendBufLen[head], true);
+        sentTime = millis();
+        waitingACK = true;
+      }
+      else if (radio.ACKReceived(remoteID))
+      {
+        if (parseHEXPacketACK(radio, tmp) && tmp==txSeq)
+        {
+          for (uint8_t i=sendBufLen[head]-hexDataLen[head]; i<sendBufLen[head]; i++)
+            imageCRC = updateCRC32(imageCRC, sendBuf[head][i]);
+          Serial.print(F("FLX:"));Serial.print(txSeq);Serial.println(F(":OK")); //response to host
+          head = (head+1)%OTA_STREAM_WINDOW;
+          count--;
+          txSeq++;
+          waitingACK = false;
+          now = millis();
+        }
+      }
+      else if (millis()-sentTime > ACKTIMEOUT)
+        waitingACK = false; //no ACK yet, resend
+    }
+    else if (eofLen)
+      return HandleSerialEOF(radio, targetID, eofInput, eofLen, imageCRC, TIMEOUT, ACKTIMEOUT, DEBUG);
+
+    //abort FLASH sequence if no valid packet received for a long time
+    if (millis()-now > TIMEOUT)
+    {
+      Serial.print(F("Timeout getting FLASH image from SERIAL, aborting.."));
+      return false;
+    }
+  }
+}
+
+
 //===================================================================================================================
 // validateHEXData() - returns length of HEX data bytes if everything is valid
 //returns 0 if any validation failed
@@ -473,6 +703,108 @@ uint8_t validateHEXData(void* data, uint8_t length)
 }
 
 
+//===================================================================================================================
+// HEX_NIBBLE - lookup table from ASCII to HEX nibble value, 0xFF for anything other than [0-9A-F]
+//===================================================================================================================
+#define __ 0xFF
+#if defined(__AVR__)
+static const uint8_t HEX_NIBBLE[256] PROGMEM =
+#else
+static const uint8_t HEX_NIBBLE[256] =
+#endif
+{
+  __,__,__,__,__,__,__,__,__,__,__,__,__,__,__,__, __,__,__,__,__,__,__,__,__,__,__,__,__,__,__,__,
+  __,__,__,__,__,__,__,__,__,__,__,__,__,__,__,__,  0, 1, 2, 3, 4, 5, 6, 7, 8, 9,__,__,__,__,__,__,
+  __,10,11,12,13,14,15,__,__,__,__,__,__,__,__,__, __,__,__,__,__,__,__,__,__,__,__,__,__,__,__,__,
+  __,__,__,__,__,__,__,__,__,__,__,__,__,__,__,__, __,__,__,__,__,__,__,__,__,__,__,__,__,__,__,__,
+  __,__,__,__,__,__,__,__,__,__,__,__,__,__,__,__, __,__,__,__,__,__,__,__,__,__,__,__,__,__,__,__,
+  __,__,__,__,__,__,__,__,__,__,__,__,__,__,__,__, __,__,__,__,__,__,__,__,__,__,__,__,__,__,__,__,
+  __,__,__,__,__,__,__,__,__,__,__,__,__,__,__,__, __,__,__,__,__,__,__,__,__,__,__,__,__,__,__,__,
+  __,__,__,__,__,__,__,__,__,__,__,__,__,__,__,__, __,__,__,__,__,__,__,__,__,__,__,__,__,__,__,__,
+};
+#undef __
+
+#if defined(__AVR__)
+  #define HEXNIBBLE(c) pgm_read_byte(&HEX_NIBBLE[(uint8_t)(c)])
+#else
+  #define HEXNIBBLE(c) HEX_NIBBLE[(uint8_t)(c)]
+#endif
+
+
+//===================================================================================================================
+// decodeHEXRecord() - validates and decodes an Intel HEX record (without the leading ':') in a single pass
+// the header goes in record, data bytes go in data (pass NULL to only validate)
+// returns the # of data bytes, or the same error codes as validateHEXData():
+//   0: record too short or odd length, 255: invalid HEX char, 254: bad checksum, 253: bad record length
+//   (253 is also returned when the data would not fit in maxDataLen)
+//===================================================================================================================
+uint8_t decodeHEXRecord(const char* hex, uint8_t length, uint8_t* data, uint8_t maxDataLen, HEXRecord& record)
+{
+  if (length <12 || length%2!=0) return 0; //shortest possible intel data HEX record is 12 bytes
+
+  uint8_t header[4];
+  uint8_t invalid = 0;
+  uint8_t checksum = 0;
+  for (uint8_t i=0; i<4; i++)
+  {
+    uint8_t hi = HEXNIBBLE(hex[i*2]), lo = HEXNIBBLE(hex[i*2+1]);
+    invalid |= hi | lo; //any 0xFF entry sets bits 4..7
+    header[i] = (hi << 4) | lo;
+    checksum += header[i];
+  }
+  record.length = header[0];
+  record.address = ((uint16_t)header[1] << 8) | header[2];
+  record.type = header[3];
+
+  uint8_t dataLength = (length-10)/2;
+  const char* p = hex+8;
+  uint8_t i = 0;
+  if (data != NULL && dataLength > maxDataLen) data = NULL; //record check below fails anyway, just don't overflow
+
+#if defined(__SSE2__)
+  //16 bytes (32 HEX chars) per iteration: validate the chars, map them to nibbles, pair nibbles and sum for the checksum
+  const __m128i zero = _mm_setzero_si128();
+  __m128i bad = zero, sum = zero;
+  for (; i+16 <= dataLength; i+=16, p+=32)
+  {
+    for (uint8_t half=0; half<2; half++)
+    {
+      __m128i c = _mm_loadu_si128((const __m128i*)(p + half*16));
+      __m128i isDigit = _mm_and_si128(_mm_cmpgt_epi8(c, _mm_set1_epi8('0'-1)), _mm_cmplt_epi8(c, _mm_set1_epi8('9'+1)));
+      __m128i isAlpha = _mm_and_si128(_mm_cmpgt_epi8(c, _mm_set1_epi8('A'-1)), _mm_cmplt_epi8(c, _mm_set1_epi8('F'+1)));
+      bad = _mm_or_si128(bad, _mm_andnot_si128(_mm_or_si128(isDigit, isAlpha), _mm_set1_epi8(-1)));
+      __m128i nibbles = _mm_sub_epi8(_mm_sub_epi8(c, _mm_set1_epi8('0')), _mm_and_si128(isAlpha, _mm_set1_epi8(7)));
+      //little endian 16bit lanes hold [hi nibble, lo nibble] -> (hi<<4)|lo in the low byte
+      __m128i pairs = _mm_or_si128(_mm_slli_epi16(_mm_and_si128(nibbles, _mm_set1_epi16(0x00FF)), 4), _mm_srli_epi16(nibbles, 8));
+      __m128i bytes = _mm_packus_epi16(pairs, zero);
+      sum = _mm_add_epi64(sum, _mm_sad_epu8(bytes, zero));
+      if (data != NULL) _mm_storel_epi64((__m128i*)(data + i + half*8), bytes);
+    }
+  }
+  if (_mm_movemask_epi8(bad)) return 255;
+  checksum += (uint8_t)(_mm_cvtsi128_si32(sum) + _mm_cvtsi128_si32(_mm_srli_si128(sum, 8)));
+#endif
+
+  for (; i < dataLength; i++, p+=2)
+  {
+    uint8_t hi = HEXNIBBLE(p[0]), lo = HEXNIBBLE(p[1]);
+    invalid |= hi | lo;
+    uint8_t b = (hi << 4) | lo;
+    checksum += b;
+    if (data != NULL) data[i] = b;
+  }
+
+  uint8_t hi = HEXNIBBLE(p[0]), lo = HEXNIBBLE(p[1]);
+  invalid |= hi | lo;
+  if (invalid & 0xF0) return 255;
+  checksum += (hi << 4) | lo; //all bytes including the checksum byte add up to 0
+
+  if (checksum != 0) return 254;
+  if (record.length != dataLength || record.length > maxDataLen) return 253;
+  return record.length; //all validation OK!
+}
+
+
 //===================================================================================================================
 // prepareSendBuffer() - returns the final size of the buf
 //===================================================================================================================
@@ -494,6 +826,35 @@ uint8_t BYTEfromHEX(char MSB, char LSB)
 }
 
 
+//===================================================================================================================
+// CRC32fromHEX() - converts 8 ASCII HEX chars [0-9A-F] to a 32bit value, returns false if any char is invalid
+//===================================================================================================================
+uint8_t CRC32fromHEX(const char* hex, uint32_t& crc)
+{
+  crc = 0;
+  for (uint8_t i=0; i<8; i++)
+  {
+    if (!((hex[i] >=48 && hex[i]<=57) || (hex[i] >=65 && hex[i]<=70))) //0-9,A-F
+      return false;
+    if (i%2) crc = (crc << 8) | BYTEfromHEX(hex[i-1], hex[i]);
+  }
+  return true;
+}
+
+
+//===================================================================================================================
+// updateCRC32() - adds one byte to a running CRC32 (IEEE 802.3, reflected, poly 0xEDB88320)
+// start with 0xFFFFFFFF and invert the result when done, computed bitwise to avoid a 1KB lookup table
+//===================================================================================================================
+uint32_t updateCRC32(uint32_t crc, uint8_t data)
+{
+  crc ^= data;
+  for (uint8_t i=0; i<8; i++)
+    crc = (crc >> 1) ^ (0xEDB88320UL & (0 - (crc & 1)));
+  return crc;
+}
+
+
 //===================================================================================================================
 // sendHEXPacket() - return the SEQ of the ACK received, or -1 if invalid
 //===================================================================================================================
@@ -509,20 +870,9 @@ uint8_t sendHEXPacket(RFM69& radio, uint16_t targetID, uint8_t* sendBuf, uint8_t
       
       if (DEBUG) { Serial.print(F("RFACK > ")); Serial.print(ackLen); Serial.print(F(" > ")); PrintHex83((uint8_t*)radio.DATA, ackLen); Serial.println(); }
       
-      if (ackLen >= 8 && radio.DATA[0]=='F' && radio.DATA[1]=='L' && radio.DATA[2]=='X' && 
-          radio.DATA[3]==':' && radio.DATA[ackLen-3]==':' &&
-          radio.DATA[ackLen-2]=='O' && radio.DATA[ackLen-1]=='K')
-      {
-        uint16_t tmp=0;
-#if defined(__arm__)
-        // On the ARM platform, uint16_t = short unsigned int, so %hu formatting is needed:
-        sscanf((const char*)radio.DATA, "FLX:%hu:OK", &tmp);
-#else
-        // On the AVR platform, uint16_t = unsigned int, so %u formatting is needed:
-        sscanf((const char*)radio.DATA, "FLX:%u:OK", &tmp);
-#endif
-        return tmp == seq;
-      }
+      uint16_t ackSeq;
+      if (parseHEXPacketACK(radio, ackSeq))
+        return ackSeq == seq;
     }
 
     if (millis()-now > TIMEOUT)
@@ -554,7 +904,7 @@ void PrintHex83(uint8_t* data, uint8_t length)
 //===================================================================================================================
 // resetUsingWatchdog() - Use watchdog to reset the MCU
 //===================================================================================================================
-void resetUsingWatchdog(uint8_t DEBUG)
+void resetUsingWatchdog(uint8_t DEBUG __attribute__((unused))) //only AVR prints
 {
 #ifdef __AVR__
   //wdt_disable();
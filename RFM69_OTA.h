@@ -48,6 +48,7 @@
 #endif
 
 #define SHIFTCHANNEL 1000000 //amount to shift frequency of HEX transmission to keep original channel free of the HEX transmission traffic
+#define IMAGE_CRC //append the CRC32 of the whole image to FLX?EOF (FLX?EOF:XXXXXXXX), comment out when programming targets running older firmware
 
 #ifndef DEFAULT_TIMEOUT
   #define DEFAULT_TIMEOUT 3000
@@ -57,6 +58,17 @@
   #define ACK_TIMEOUT 20
 #endif
 
+#ifndef OTA_STREAM_WINDOW
+  #define OTA_STREAM_WINDOW 4 //# of decoded HEX records buffered in RAM on the MAIN node in streaming mode (57 bytes each)
+#endif
+
+//header fields of an Intel HEX record, as decoded by decodeHEXRecord()
+struct HEXRecord {
+  uint8_t length;   //# of data bytes
+  uint16_t address; //load offset (big endian in the record)
+  uint8_t type;     //00=data, 01=EOF, 02..05=address records
+};
+
 //functions used in the REMOTE node
 void CheckForWirelessHEX(RFM69& radio, SPIFlash& flash, uint8_t DEBUG=false, uint8_t LEDpin=LED);
 uint8_t HandleHandshakeACK(RFM69& radio, SPIFlash& flash, uint8_t flashCheck=true);
@@ -69,18 +81,23 @@ uint8_t HandleWirelessHEXDataWrapper(RFM69& radio, uint16_t remoteID, SPIFlash&
 
 //functions used in the MAIN node
 uint8_t CheckForSerialHEX(uint8_t* input, uint8_t inputLen, RFM69& radio, uint16_t targetID, uint16_t TIMEOUT=DEFAULT_TIMEOUT, uint16_t ACKTIMEOUT=ACK_TIMEOUT, uint8_t DEBUG=false);
-uint8_t HandleSerialHandshake(RFM69& radio, uint16_t targetID, uint8_t isEOF, uint16_t TIMEOUT=DEFAULT_TIMEOUT, uint16_t ACKTIMEOUT=ACK_TIMEOUT, uint8_t DEBUG=false);
+uint8_t HandleSerialHandshake(RFM69& radio, uint16_t targetID, uint8_t isEOF, uint16_t TIMEOUT=DEFAULT_TIMEOUT, uint16_t ACKTIMEOUT=ACK_TIMEOUT, uint8_t DEBUG=false, uint32_t imageCRC=0);
 uint8_t HandleSerialHEXData(RFM69& radio, uint16_t targetID, uint16_t TIMEOUT=DEFAULT_TIMEOUT, uint16_t ACKTIMEOUT=ACK_TIMEOUT, uint8_t DEBUG=false);
+uint8_t HandleSerialHEXStream(RFM69& radio, uint16_t targetID, uint16_t TIMEOUT=DEFAULT_TIMEOUT, uint16_t ACKTIMEOUT=ACK_TIMEOUT, uint8_t DEBUG=false);
 #ifdef SHIFTCHANNEL
-uint8_t HandleSerialHEXDataWrapper(RFM69& radio, uint16_t targetID, uint16_t TIMEOUT=DEFAULT_TIMEOUT, uint16_t ACKTIMEOUT=ACK_TIMEOUT, uint8_t DEBUG=false);
+uint8_t HandleSerialHEXDataWrapper(RFM69& radio, uint16_t targetID, uint16_t TIMEOUT=DEFAULT_TIMEOUT, uint16_t ACKTIMEOUT=ACK_TIMEOUT, uint8_t DEBUG=false, uint8_t stream=false);
 #endif
 uint8_t waitForAck(RFM69& radio, uint16_t fromNodeID, uint16_t ACKTIMEOUT=ACK_TIMEOUT);
 
 uint8_t validateHEXData(void* data, uint8_t length);
+uint8_t decodeHEXRecord(const char* hex, uint8_t length, uint8_t* data, uint8_t maxDataLen, HEXRecord& record);
 uint8_t prepareSendBuffer(char* hexdata, uint8_t*buf, uint8_t length, uint16_t seq);
 uint8_t sendHEXPacket(RFM69& radio, uint16_t remoteID, uint8_t* sendBuf, uint8_t hexDataLen, uint16_t seq, uint16_t TIMEOUT=DEFAULT_TIMEOUT, uint16_t ACKTIMEOUT=ACK_TIMEOUT, uint8_t DEBUG=false);
 uint8_t BYTEfromHEX(char MSB, char LSB);
+uint8_t CRC32fromHEX(const char* hex, uint32_t& crc);
+uint32_t updateCRC32(uint32_t crc, uint8_t data);
 uint8_t readSerialLine(char* input, char endOfLineChar=10, uint8_t maxLength=115, uint16_t timeout=1000);
+uint8_t pollSerialLine(char* input, uint8_t& inputPos, uint8_t maxLength=115);
 void PrintHex83(uint8_t* data, uint8_t length);
 
 #endif
@@ -0,0 +1,118 @@
+// **********************************************************************************
+// Coordinated polling for sleeping nodes, see RFM69_Poll.h
+// Copyright LowPowerLab LLC 2018, https://www.LowPowerLab.com/contact
+// **********************************************************************************
+// License
+// **********************************************************************************
+// This program is free software; you can redistribute it 
+// and/or modify it under the terms of the GNU General    
+// Public License as published by the Free Software       
+// Foundation; either version 3 of the License, or        
+// (at your option) any later version.                    
+//                                                        
+// This program is distributed in the hope that it will   
+// be useful, but WITHOUT ANY WARRANTY; without even the  
+// implied warranty of MERCHANTABILITY or FITNESS FOR A   
+// PARTICULAR PURPOSE. See the GNU General Public        
+// License for more details.                              
+//                                                        
+// Licence can be viewed at                               
+// http://www.gnu.org/licenses/gpl-3.0.txt
+//
+// Please maintain this license information along with authorship
+// and copyright notices in any redistribution of this code
+// **********************************************************************************
+#include "RFM69_Poll.h"
+
+static void putWord(uint8_t* p, uint16_t v) { p[0] = v; p[1] = v >> 8; }
+static uint16_t getWord(const uint8_t* p) { return p[0] | ((uint16_t)p[1] << 8); }
+
+//=============================================================================
+// RFM69_PollGateway
+//=============================================================================
+RFM69_PollGateway::RFM69_PollGateway(RFM69& radio, RFM69_Queue& queue, uint16_t sleepInterval) : _radio(radio), _queue(queue)
+{
+  _sleepInterval = sleepInterval;
+}
+
+bool RFM69_PollGateway::isPoll(const void* data, uint8_t len)
+{
+  return len >= 2 && ((const uint8_t*)data)[0] == RFM69_POLL_MARKER;
+}
+
+bool RFM69_PollGateway::reply()
+{
+  if (!isPoll(_radio.DATA, _radio.DATALEN)) return false;
+  if (!_radio.ACKRequested()) return true; // nowhere to put the answer
+  uint16_t nodeId = _radio.SENDERID;
+  if ((_radio.DATA[1] & RFM69_POLL_CONFIRM) && _radio.DATALEN >= 4)
+    _queue.removeThrough(nodeId, getWord(_radio.DATA + 2));
+
+  uint8_t buf[RF69_MAX_DATA_LEN];
+  uint8_t maxLen = _radio.getMaxDataLen() - 1; // leave room for the RFM69_ATC RSSI byte
+  uint8_t len = RFM69_POLL_HEADERLEN;
+  buf[0] = RFM69_POLL_MARKER;
+  buf[1] = 0;
+  putWord(buf + 4, 0);
+  for (uint8_t i = _queue.first(nodeId); i != RFM69_QUEUE_NONE; i = _queue.next(i))
+  {
+    const RFM69_Request& req = _queue.get(i);
+    uint8_t cmdLen = strlen(req.data);
+    if (len + cmdLen + 1 > maxLen)
+    {
+      if (len > RFM69_POLL_HEADERLEN) { buf[1] |= RFM69_POLL_MORE; break; }
+      cmdLen = maxLen - len - 1; // a command longer than a reply goes out truncated rather than blocking the others
+    }
+    memcpy(buf + len, req.data, cmdLen);
+    len += cmdLen;
+    buf[len++] = 0;
+    putWord(buf + 4, req.seq);
+    _queue.markSent(i);
+  }
+  putWord(buf + 2, (buf[1] & RFM69_POLL_MORE) ? 0 : _sleepInterval);
+  _radio.sendACK(buf, len);
+  return true;
+}
+
+//=============================================================================
+// RFM69_PollNode
+//=============================================================================
+RFM69_PollNode::RFM69_PollNode(RFM69& radio, uint16_t gatewayId) : _radio(radio)
+{
+  _gateway = gatewayId;
+  _confirm = false;
+  _seq = 0;
+  _flags = 0;
+  _sleepInterval = RFM69_POLL_SLEEP;
+  _len = _count = _pos = 0;
+  _buf[0] = 0;
+}
+
+bool RFM69_PollNode::poll(uint8_t retries, uint8_t retryWaitTime)
+{
+  uint8_t frame[4] = { RFM69_POLL_MARKER, (uint8_t)(_confirm ? RFM69_POLL_CONFIRM : 0) };
+  putWord(frame + 2, _seq);
+  _flags = _len = _count = _pos = 0;
+  if (!_radio.sendWithRetry(_gateway, frame, _confirm ? 4 : 2, retries, retryWaitTime)) return false;
+  if (_radio.DATALEN < RFM69_POLL_HEADERLEN || _radio.DATA[0] != RFM69_POLL_MARKER) return false; // plain ACK, the gateway does not poll
+
+  // the gateway applied our confirmation before answering, what it sent now is the next one
+  _flags = _radio.DATA[1];
+  _sleepInterval = getWord(_radio.DATA + 2);
+  _len = _radio.DATALEN - RFM69_POLL_HEADERLEN;
+  memcpy(_buf, _radio.DATA + RFM69_POLL_HEADERLEN, _len);
+  _buf[_len] = 0;
+  while (next()) _count++;
+  _pos = 0;
+  _confirm = _count > 0;
+  if (_confirm) _seq = getWord(_radio.DATA + 4);
+  return true;
+}
+
+const char* RFM69_PollNode::next()
+{
+  if (_pos >= _len) return 0;
+  const char* cmd = _buf + _pos;
+  _pos += strlen(cmd) + 1;
+  return cmd;
+}
@@ -0,0 +1,96 @@
+// **********************************************************************************
+// Coordinated polling for sleeping nodes: on every wake a node sends a compact poll to the
+// gateway, which answers in the ACK with a batch of the node's queued commands (RFM69_Queue),
+// a "more pending" flag and the interval the node should sleep before its next poll.
+// The node polls again while more are pending, so the queue drains in one wake.
+// Commands stay queued until the node confirms them in its next poll, a lost reply is resent.
+// Copyright LowPowerLab LLC 2018, https://www.LowPowerLab.com/contact
+// **********************************************************************************
+// License
+// **********************************************************************************
+// This program is free software; you can redistribute it 
+// and/or modify it under the terms of the GNU General    
+// Public License as published by the Free Software       
+// Foundation; either version 3 of the License, or        
+// (at your option) any later version.                    
+//                                                        
+// This program is distributed in the hope that it will   
+// be useful, but WITHOUT ANY WARRANTY; without even the  
+// implied warranty of MERCHANTABILITY or FITNESS FOR A   
+// PARTICULAR PURPOSE. See the GNU General Public        
+// License for more details.                              
+//                                                        
+// Licence can be viewed at                               
+// http://www.gnu.org/licenses/gpl-3.0.txt
+//
+// Please maintain this license information along with authorship
+// and copyright notices in any redistribution of this code
+// **********************************************************************************
+#ifndef RFM69_POLL_h
+#define RFM69_POLL_h
+#include "RFM69.h"
+#include "RFM69_Queue.h"
+
+// poll (node -> gateway, requests an ACK): marker, flags, [seq (2, LE)]
+//   RFM69_POLL_CONFIRM: seq is the last command of the previous reply, the gateway drops it and the ones before it
+// reply (ACK payload): marker, flags, sleep interval in s (2, LE), seq (2, LE), commands, each null terminated
+//   RFM69_POLL_MORE: the node has commands queued after this batch, poll again right away
+//   seq is the last command of the batch, confirmed by the next poll (right away or on the next wake).
+//   It is 16 bits and the gateway only drops commands it sent, so a confirmation that arrives late
+//   (a lost reply, a long sleep) never takes commands the node did not get
+#define RFM69_POLL_MARKER    0xA9
+#define RFM69_POLL_CONFIRM   0x01
+#define RFM69_POLL_MORE      0x02
+#define RFM69_POLL_HEADERLEN 6
+
+#ifndef RFM69_POLL_SLEEP
+  #define RFM69_POLL_SLEEP   60 // s, default sleep interval the gateway suggests
+#endif
+
+// gateway side, for every received packet:
+//   if (radio.receiveDone() && !poller.reply()) ... not a poll, process it as usual
+class RFM69_PollGateway {
+  public:
+    RFM69_PollGateway(RFM69& radio, RFM69_Queue& queue, uint16_t sleepInterval=RFM69_POLL_SLEEP);
+    static bool isPoll(const void* data, uint8_t len);
+
+    bool reply(); // call after receiveDone(): answers a poll with the node's next batch, true if the packet was a poll
+    void setSleepInterval(uint16_t seconds) { _sleepInterval = seconds; }
+    uint16_t sleepInterval() { return _sleepInterval; }
+
+  protected:
+    RFM69& _radio;
+    RFM69_Queue& _queue;
+    uint16_t _sleepInterval;
+};
+
+// node side, on every wake:
+//   do {
+//     if (!poller.poll()) break;  // gateway not heard, try again on the next wake
+//     while (const char* cmd = poller.next()) handle(cmd);
+//   } while (poller.more());
+//   sleep poller.sleepInterval() seconds
+class RFM69_PollNode {
+  public:
+    RFM69_PollNode(RFM69& radio, uint16_t gatewayId);
+
+    bool poll(uint8_t retries=2, uint8_t retryWaitTime=RFM69_ACK_TIMEOUT); // true when the gateway answered
+    const char* next();                 // the commands of the last reply in order, 0 after the last one
+    uint8_t commands() { return _count; }
+    bool more() { return _flags & RFM69_POLL_MORE; }
+    uint16_t sleepInterval() { return _sleepInterval; } // s, as suggested in the last reply (RFM69_POLL_SLEEP until one)
+
+  protected:
+    RFM69& _radio;
+    uint16_t _gateway;
+    bool _confirm;    // _seq was received and is not confirmed yet, kept across sleeps
+    uint16_t _seq;
+    uint8_t _flags;
+    uint16_t _sleepInterval;
+    char _buf[RF69_MAX_DATA_LEN+1]; // commands of the last reply
+    uint8_t _len;
+    uint8_t _count;
+    uint8_t _pos;     // next command in _buf
+};
+
+#endif
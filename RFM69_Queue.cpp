@@ -0,0 +1,185 @@
+// **********************************************************************************
+// Fixed capacity queue of pending commands for sleeping nodes, used by gateways
+// **********************************************************************************
+// Copyright LowPowerLab LLC 2018, https://www.LowPowerLab.com/contact
+// **********************************************************************************
+// License
+// **********************************************************************************
+// This program is free software; you can redistribute it 
+// and/or modify it under the terms of the GNU General    
+// Public License as published by the Free Software       
+// Foundation; either version 3 of the License, or        
+// (at your option) any later version.                    
+//                                                        
+// This program is distributed in the hope that it will   
+// be useful, but WITHOUT ANY WARRANTY; without even the  
+// implied warranty of MERCHANTABILITY or FITNESS FOR A   
+// PARTICULAR PURPOSE. See the GNU General Public        
+// License for more details.                              
+//                                                        
+// Licence can be viewed at                               
+// http://www.gnu.org/licenses/gpl-3.0.txt
+//
+// Please maintain this license information along with authorship
+// and copyright notices in any redistribution of this code
+// **********************************************************************************
+#include "RFM69_Queue.h"
+
+RFM69_Queue::RFM69_Queue(RFM69_Request* slots, uint8_t capacity)
+{
+  _slots = slots;
+  _capacity = capacity < RFM69_QUEUE_NONE ? capacity : RFM69_QUEUE_NONE-1;
+  clear();
+}
+
+// drop every command and rebuild the free list
+void RFM69_Queue::clear()
+{
+  for (uint8_t i = 0; i < _capacity; i++)
+    _slots[i].next = (i+1 < _capacity) ? i+1 : RFM69_QUEUE_NONE;
+  _free = _capacity ? 0 : RFM69_QUEUE_NONE;
+  for (uint8_t b = 0; b < RFM69_QUEUE_BUCKETS; b++)
+    _head[b] = _tail[b] = RFM69_QUEUE_NONE;
+  _size = 0;
+  _seq = 0;
+}
+
+// appends a command for nodeId, it is truncated to RFM69_QUEUE_DATALEN-1 chars
+bool RFM69_Queue::insert(uint16_t nodeId, const char* data)
+{
+  if (_free == RFM69_QUEUE_NONE) return false;
+  uint8_t slot = _free;
+  _free = _slots[slot].next;
+
+  RFM69_Request& req = _slots[slot];
+  req.nodeId = nodeId;
+  req.next = RFM69_QUEUE_NONE;
+  req.sent = false;
+  req.seq = _seq++;
+  strncpy(req.data, data, RFM69_QUEUE_DATALEN-1);
+  req.data[RFM69_QUEUE_DATALEN-1] = 0;
+
+  uint8_t b = bucketOf(nodeId);
+  if (_tail[b] == RFM69_QUEUE_NONE) _head[b] = slot;
+  else _slots[_tail[b]].next = slot;
+  _tail[b] = slot;
+  _size++;
+  return true;
+}
+
+bool RFM69_Queue::contains(uint16_t nodeId, const char* data)
+{
+  for (uint8_t i = first(nodeId); i != RFM69_QUEUE_NONE; i = next(i))
+    if (strcmp(_slots[i].data, data) == 0) return true;
+  return false;
+}
+
+uint8_t RFM69_Queue::remove(uint16_t nodeId, const char* data)
+{
+  uint8_t b = bucketOf(nodeId);
+  uint8_t prev = RFM69_QUEUE_NONE;
+  uint8_t i = _head[b];
+  uint8_t removed = 0;
+
+  while (i != RFM69_QUEUE_NONE)
+  {
+    uint8_t following = _slots[i].next;
+    if (_slots[i].nodeId == nodeId && (data == 0 || strcmp(_slots[i].data, data) == 0))
+    {
+      // unlink from the bucket chain, the predecessor is known so this is O(1)
+      if (prev == RFM69_QUEUE_NONE) _head[b] = following;
+      else _slots[prev].next = following;
+      if (_tail[b] == i) _tail[b] = prev;
+      _slots[i].next = _free;
+      _free = i;
+      _size--;
+      removed++;
+    }
+    else prev = i;
+    i = following;
+  }
+  return removed;
+}
+
+// drops the commands a node confirmed it received: seq is the last one of the delivered batch.
+// Only sent commands are matched: the numbers are shared by all nodes, a stale confirmation repeated after
+// a lost reply must not take a newer command that came around to the same seq before it went out.
+// A repeated confirmation finds nothing and removes nothing, so it is safe to retry.
+uint8_t RFM69_Queue::removeThrough(uint16_t nodeId, uint16_t seq)
+{
+  uint8_t last = first(nodeId);
+  while (last != RFM69_QUEUE_NONE && _slots[last].sent && _slots[last].seq != seq) last = next(last);
+  if (last == RFM69_QUEUE_NONE || !_slots[last].sent) return 0; // replies are sent from the first command on
+
+  uint8_t b = bucketOf(nodeId);
+  uint8_t prev = RFM69_QUEUE_NONE;
+  uint8_t i = _head[b];
+  uint8_t removed = 0;
+  while (i != RFM69_QUEUE_NONE)
+  {
+    uint8_t following = _slots[i].next;
+    if (_slots[i].nodeId == nodeId)
+    {
+      if (prev == RFM69_QUEUE_NONE) _head[b] = following;
+      else _slots[prev].next = following;
+      if (_tail[b] == i) _tail[b] = prev;
+      _slots[i].next = _free;
+      _free = i;
+      _size--;
+      removed++;
+      if (i == last) break;
+    }
+    else prev = i;
+    i = following;
+  }
+  return removed;
+}
+
+// internal function - first slot at or after 'slot' in its bucket chain that belongs to nodeId
+uint8_t RFM69_Queue::nextInBucket(uint8_t slot, uint16_t nodeId)
+{
+  while (slot != RFM69_QUEUE_NONE && _slots[slot].nodeId != nodeId)
+    slot = _slots[slot].next;
+  return slot;
+}
+
+uint8_t RFM69_Queue::first(uint16_t nodeId)
+{
+  return nextInBucket(_head[bucketOf(nodeId)], nodeId);
+}
+
+uint8_t RFM69_Queue::next(uint8_t slot)
+{
+  return nextInBucket(_slots[slot].next, _slots[slot].nodeId);
+}
+
+uint8_t RFM69_Queue::firstAll()
+{
+  for (uint8_t b = 0; b < RFM69_QUEUE_BUCKETS; b++)
+    if (_head[b] != RFM69_QUEUE_NONE) return _head[b];
+  return RFM69_QUEUE_NONE;
+}
+
+uint8_t RFM69_Queue::nextAll(uint8_t slot)
+{
+  if (_slots[slot].next != RFM69_QUEUE_NONE) return _slots[slot].next;
+  for (uint8_t b = bucketOf(_slots[slot].nodeId) + 1; b < RFM69_QUEUE_BUCKETS; b++)
+    if (_head[b] != RFM69_QUEUE_NONE) return _head[b];
+  return RFM69_QUEUE_NONE;
+}
+
+uint8_t RFM69_Queue::pack(uint16_t nodeId, char* buf, uint8_t maxLen)
+{
+  uint8_t len = 0;
+  for (uint8_t i = first(nodeId); i != RFM69_QUEUE_NONE; i = next(i))
+  {
+    uint8_t cmdLen = strlen(_slots[i].data);
+    //check if payload has room to add this queued command, prefixed with a space if there are previous ones
+    if (len + (len ? 1 : 0) + cmdLen > maxLen) continue;
+    if (len) buf[len++] = ' ';
+    memcpy(buf + len, _slots[i].data, cmdLen);
+    len += cmdLen;
+  }
+  if (len < maxLen) buf[len] = 0;
+  return len;
+}
@@ -0,0 +1,86 @@
+// **********************************************************************************
+// Fixed capacity queue of pending commands for sleeping nodes, used by gateways
+// Commands are kept in a caller provided array of slots (no malloc, no heap fragmentation)
+// and chained per node ID hash bucket, so finding the commands of the node that just
+// requested an ACK does not walk the commands queued for every other node.
+// **********************************************************************************
+// Copyright LowPowerLab LLC 2018, https://www.LowPowerLab.com/contact
+// **********************************************************************************
+// License
+// **********************************************************************************
+// This program is free software; you can redistribute it 
+// and/or modify it under the terms of the GNU General    
+// Public License as published by the Free Software       
+// Foundation; either version 3 of the License, or        
+// (at your option) any later version.                    
+//                                                        
+// This program is distributed in the hope that it will   
+// be useful, but WITHOUT ANY WARRANTY; without even the  
+// implied warranty of MERCHANTABILITY or FITNESS FOR A   
+// PARTICULAR PURPOSE. See the GNU General Public        
+// License for more details.                              
+//                                                        
+// Licence can be viewed at                               
+// http://www.gnu.org/licenses/gpl-3.0.txt
+//
+// Please maintain this license information along with authorship
+// and copyright notices in any redistribution of this code
+// **********************************************************************************
+#ifndef RFM69_QUEUE_h
+#define RFM69_QUEUE_h
+#include "RFM69.h"
+
+#define RFM69_QUEUE_DATALEN  RF69_MAX_DATA_LEN // max command length, including the null terminator
+#define RFM69_QUEUE_BUCKETS  32   // # of node ID hash buckets, power of 2
+#define RFM69_QUEUE_NONE     0xFF // end of chain/no slot, so max capacity is 254 slots
+
+struct RFM69_Request {
+  uint16_t nodeId;
+  uint8_t next;                    // next slot in the same bucket (or in the free list)
+  bool sent;                       // handed to the node (markSent()), only those can be confirmed
+  uint16_t seq;                    // insertion sequence # (wraps), identifies a delivered command, see removeThrough()
+  char data[RFM69_QUEUE_DATALEN];  // null terminated command
+};
+
+class RFM69_Queue {
+  public:
+    // slots must outlive the queue, ex: RFM69_Request slots[10]; RFM69_Queue queue(slots, 10);
+    RFM69_Queue(RFM69_Request* slots, uint8_t capacity);
+
+    void clear();
+    bool insert(uint16_t nodeId, const char* data); // false when full
+    bool contains(uint16_t nodeId, const char* data);
+    uint8_t remove(uint16_t nodeId, const char* data=0); // removes all commands for nodeId, or only those matching data; returns # removed
+    void markSent(uint8_t slot) { _slots[slot].sent = true; }
+    uint8_t removeThrough(uint16_t nodeId, uint16_t seq); // removes the node's sent commands numbered up to seq, returns # removed
+
+    // iterate the commands of one node in insertion order:
+    //   for (uint8_t i = queue.first(id); i != RFM69_QUEUE_NONE; i = queue.next(i)) queue.get(i).data ...
+    uint8_t first(uint16_t nodeId);
+    uint8_t next(uint8_t slot);
+    // iterate every command (grouped by bucket, insertion order within a node)
+    uint8_t firstAll();
+    uint8_t nextAll(uint8_t slot);
+    const RFM69_Request& get(uint8_t slot) { return _slots[slot]; }
+
+    // packs as many of the node's commands as fit in maxLen into buf, space separated (ACK payload), returns the length
+    uint8_t pack(uint16_t nodeId, char* buf, uint8_t maxLen);
+
+    uint8_t size() { return _size; }
+    uint8_t capacity() { return _capacity; }
+    bool full() { return _free == RFM69_QUEUE_NONE; }
+
+  protected:
+    static uint8_t bucketOf(uint16_t nodeId) { return nodeId & (RFM69_QUEUE_BUCKETS-1); }
+    uint8_t nextInBucket(uint8_t slot, uint16_t nodeId);
+
+    RFM69_Request* _slots;
+    uint8_t _capacity;
+    uint8_t _size;
+    uint8_t _free;                          // head of the free slot list
+    uint16_t _seq;                          // seq of the next insert
+    uint8_t _head[RFM69_QUEUE_BUCKETS];
+    uint8_t _tail[RFM69_QUEUE_BUCKETS];
+};
+
+#endif
@@ -0,0 +1,206 @@
+// **********************************************************************************
+// Beacon synchronized TDMA: the gateway broadcasts a beacon every period with its clock
+// and the slot assignments, each assigned node transmits only in its own slot and sleeps
+// the rest of the time. Nodes without a slot use the contention period (CSMA) after the
+// last slot, the gateway hands them a slot in the next beacon.
+// **********************************************************************************
+// Copyright LowPowerLab LLC 2018, https://www.LowPowerLab.com/contact
+// **********************************************************************************
+// License
+// **********************************************************************************
+// This program is free software; you can redistribute it 
+// and/or modify it under the terms of the GNU General    
+// Public License as published by the Free Software       
+// Foundation; either version 3 of the License, or        
+// (at your option) any later version.                    
+//                                                        
+// This program is distributed in the hope that it will   
+// be useful, but WITHOUT ANY WARRANTY; without even the  
+// implied warranty of MERCHANTABILITY or FITNESS FOR A   
+// PARTICULAR PURPOSE. See the GNU General Public        
+// License for more details.                              
+//                                                        
+// Licence can be viewed at                               
+// http://www.gnu.org/licenses/gpl-3.0.txt
+//
+// Please maintain this license information along with authorship
+// and copyright notices in any redistribution of this code
+// **********************************************************************************
+#include "RFM69_TDMA.h"
+
+static void putWord(uint8_t* p, uint16_t v) { p[0] = v; p[1] = v >> 8; }
+static uint16_t getWord(const uint8_t* p) { return p[0] | ((uint16_t)p[1] << 8); }
+
+//=============================================================================
+// RFM69_TDMAGateway
+//=============================================================================
+RFM69_TDMAGateway::RFM69_TDMAGateway(RFM69& radio, uint16_t period, uint16_t slotLength) : _radio(radio)
+{
+  _period = period;
+  _slotLength = slotLength ? slotLength : 1;
+  _seq = 0;
+  _started = false;
+  _nextBeacon = _beaconAt = 0;
+  for (uint8_t i = 0; i < RFM69_TDMA_MAX_SLOTS; i++) { _nodes[i] = 0; _idle[i] = 0; }
+}
+
+uint8_t RFM69_TDMAGateway::maxSlots()
+{
+  uint16_t fit = _period / _slotLength;
+  fit = fit > 2 ? fit - 2 : 0; // the beacon and at least one slot of contention
+  uint8_t room = (_radio.getMaxDataLen() - RFM69_TDMA_HEADERLEN) / 2;
+  if (fit > room) fit = room;
+  return fit < RFM69_TDMA_MAX_SLOTS ? fit : RFM69_TDMA_MAX_SLOTS;
+}
+
+uint8_t RFM69_TDMAGateway::slots()
+{
+  uint8_t n = maxSlots();
+  while (n && !_nodes[n-1]) n--;
+  return n;
+}
+
+int8_t RFM69_TDMAGateway::heard(uint16_t nodeId)
+{
+  if (!nodeId || nodeId == RF69_BROADCAST_ADDR) return -1;
+  int8_t free = -1;
+  uint8_t n = maxSlots();
+  for (uint8_t i = 0; i < n; i++) {
+    if (_nodes[i] == nodeId) { _idle[i] = 0; return i; }
+    if (!_nodes[i] && free < 0) free = i;
+  }
+  if (free >= 0) { _nodes[free] = nodeId; _idle[free] = 0; }
+  return free;
+}
+
+void RFM69_TDMAGateway::release(uint16_t nodeId)
+{
+  for (uint8_t i = 0; i < RFM69_TDMA_MAX_SLOTS; i++)
+    if (_nodes[i] == nodeId) _nodes[i] = 0;
+}
+
+uint16_t RFM69_TDMAGateway::owner()
+{
+  if (!_started) return 0;
+  uint32_t slot = (millis() - _beaconAt) / _slotLength;
+  if (slot == 0 || slot > slots()) return 0;
+  return _nodes[slot - 1];
+}
+
+bool RFM69_TDMAGateway::update()
+{
+  uint32_t now = millis();
+  if (_started && (int32_t)(now - _nextBeacon) < 0) return false;
+  _nextBeacon = (_started && now - _nextBeacon < _period) ? _nextBeacon + _period : now + _period; // no drift, unless we fell behind
+  _started = true;
+
+  uint8_t n = maxSlots();
+  for (uint8_t i = 0; i < n; i++)
+    if (_nodes[i] && ++_idle[i] > RFM69_TDMA_EXPIRE) _nodes[i] = 0;
+  n = slots();
+
+  uint8_t beacon[RFM69_TDMA_HEADERLEN + 2 * RFM69_TDMA_MAX_SLOTS];
+  beacon[0] = RFM69_TDMA_MARKER;
+  beacon[1] = ++_seq;
+  beacon[2] = now; beacon[3] = now >> 8; beacon[4] = now >> 16; beacon[5] = now >> 24;
+  putWord(beacon + 6, _period);
+  putWord(beacon + 8, _slotLength);
+  beacon[10] = n;
+  for (uint8_t i = 0; i < n; i++) putWord(beacon + RFM69_TDMA_HEADERLEN + 2 * i, _nodes[i]);
+
+  uint8_t len = RFM69_TDMA_HEADERLEN + 2 * n;
+  _radio.send(RF69_BROADCAST_ADDR, beacon, len);
+  _beaconAt = millis() - _radio.getAirtime(len) / 1000; // send() returns once the beacon is out, slots count from its start
+  return true;
+}
+
+//=============================================================================
+// RFM69_TDMANode
+//=============================================================================
+RFM69_TDMANode::RFM69_TDMANode(RFM69& radio, uint16_t nodeId) : _radio(radio)
+{
+  _nodeId = nodeId;
+  _gateway = 0;
+  _period = 0;
+  _slotLength = 0;
+  _slots = 0;
+  _slot = -1;
+  _seq = 0;
+  _beaconAt = _gatewayTime = 0;
+  _slept = 0;
+}
+
+bool RFM69_TDMANode::isBeacon(const void* data, uint8_t len)
+{
+  const uint8_t* p = (const uint8_t*)data;
+  return len >= RFM69_TDMA_HEADERLEN && p[0] == RFM69_TDMA_MARKER && len >= RFM69_TDMA_HEADERLEN + 2 * p[10];
+}
+
+bool RFM69_TDMANode::receive()
+{
+  const uint8_t* p = _radio.DATA;
+  if (!isBeacon(p, _radio.DATALEN) || getWord(p + 6) == 0 || getWord(p + 8) == 0) return false;
+  _beaconAt = now() - _radio.getAirtime(_radio.DATALEN) / 1000; // the packet is complete, it started an airtime ago
+  _gateway = _radio.SENDERID;
+  _seq = p[1];
+  _gatewayTime = p[2] | ((uint32_t)p[3] << 8) | ((uint32_t)p[4] << 16) | ((uint32_t)p[5] << 24);
+  _period = getWord(p + 6);
+  _slotLength = getWord(p + 8);
+  _slots = p[10];
+  _slot = -1;
+  for (uint8_t i = 0; i < _slots; i++)
+    if (getWord(p + RFM69_TDMA_HEADERLEN + 2 * i) == _nodeId) _slot = i;
+  return true;
+}
+
+bool RFM69_TDMANode::synced()
+{
+  return _period && now() - _beaconAt < (uint32_t)_period * RFM69_TDMA_MAX_MISSED;
+}
+
+uint16_t RFM69_TDMANode::beaconWindow()
+{
+  return 2 * RFM69_TDMA_GUARD + _radio.getAirtime(RFM69_TDMA_HEADERLEN + 2 * RFM69_TDMA_MAX_SLOTS) / 1000 + 1;
+}
+
+uint32_t RFM69_TDMANode::untilBeacon()
+{
+  if (!synced()) return 0; // listen until one comes
+  uint32_t next = _period - phase();
+  if (next <= RFM69_TDMA_GUARD) return 0;
+  if (now() - _beaconAt >= _period && phase() + RFM69_TDMA_GUARD < beaconWindow()) return 0; // this one is late
+  return next - RFM69_TDMA_GUARD;
+}
+
+uint32_t RFM69_TDMANode::slotRemaining()
+{
+  if (!synced()) return 0;
+  uint32_t start = (uint32_t)(_slot >= 0 ? _slot + 1 : _slots + 1) * _slotLength;
+  uint32_t end = _slot >= 0 ? start + _slotLength : _period - _slotLength;
+  uint32_t at = phase();
+  if (at < start || at + RFM69_TDMA_GUARD >= end) return 0;
+  return end - RFM69_TDMA_GUARD - at;
+}
+
+uint32_t RFM69_TDMANode::untilSlot()
+{
+  if (!synced() || slotRemaining()) return 0;
+  uint32_t start = (uint32_t)(_slot >= 0 ? _slot + 1 : _slots + 1) * _slotLength;
+  uint32_t at = phase();
+  return at < start ? start - at : _period - at + start;
+}
+
+bool RFM69_TDMANode::send(const void* data, uint8_t len, uint8_t retries)
+{
+  for (uint8_t i = 0; i <= retries; i++) { // as many tries (each with its ACK wait) as fit before the slot ends
+    uint32_t attempt = _radio.getAirtime(len) + _radio.getACKTimeout(_gateway, i);
+    uint32_t remaining = slotRemaining() * 1000;
+    if (remaining < attempt) return false;
+    // our own slot is ours, no CSMA; the contention period is shared, but the carrier sense must not outlast it
+    if (_slot < 0 && !_radio.waitCanSend((remaining - attempt) / 1000)) return false;
+    _radio.preloadFrame(_gateway, data, len, true, i > 0);
+    _radio.sendPreloaded();
+    if (_radio.waitForACK(_gateway, RFM69_ACK_TIMEOUT_ADAPTIVE, i)) return true;
+  }
+  return false;
+}
@@ -0,0 +1,119 @@
+// **********************************************************************************
+// Beacon synchronized TDMA: the gateway broadcasts a beacon every period with its clock
+// and the slot assignments, each assigned node transmits only in its own slot and sleeps
+// the rest of the time. Nodes without a slot use the contention period (CSMA) after the
+// last slot, the gateway hands them a slot in the next beacon.
+// **********************************************************************************
+// Copyright LowPowerLab LLC 2018, https://www.LowPowerLab.com/contact
+// **********************************************************************************
+// License
+// **********************************************************************************
+// This program is free software; you can redistribute it 
+// and/or modify it under the terms of the GNU General    
+// Public License as published by the Free Software       
+// Foundation; either version 3 of the License, or        
+// (at your option) any later version.                    
+//                                                        
+// This program is distributed in the hope that it will   
+// be useful, but WITHOUT ANY WARRANTY; without even the  
+// implied warranty of MERCHANTABILITY or FITNESS FOR A   
+// PARTICULAR PURPOSE. See the GNU General Public        
+// License for more details.                              
+//                                                        
+// Licence can be viewed at                               
+// http://www.gnu.org/licenses/gpl-3.0.txt
+//
+// Please maintain this license information along with authorship
+// and copyright notices in any redistribution of this code
+// **********************************************************************************
+#ifndef RFM69_TDMA_h
+#define RFM69_TDMA_h
+#include "RFM69.h"
+
+// One superframe, starting when the beacon starts on air:
+// | beacon | slot 0 | slot 1 | ... | slot n-1 | contention ...               | beacon
+// 0        slotLen  2*slotLen                  (n+1)*slotLen       period-slotLen period
+//
+// beacon payload: marker, sequence, gateway millis() (4, LE), period (2, LE), slotLength (2, LE),
+//                 slot count, then the node id (2, LE) owning each slot, 0 for a free slot
+#define RFM69_TDMA_MARKER     0xA8
+#define RFM69_TDMA_HEADERLEN  11
+
+#ifndef RFM69_TDMA_MAX_SLOTS
+  #define RFM69_TDMA_MAX_SLOTS 16
+#endif
+#ifndef RFM69_TDMA_GUARD
+  #define RFM69_TDMA_GUARD     4  // ms, nodes wake this early for a beacon and stop sending this long before their slot ends
+#endif
+#ifndef RFM69_TDMA_MAX_MISSED
+  #define RFM69_TDMA_MAX_MISSED 3  // beacons a node can miss and still use its slot
+#endif
+#ifndef RFM69_TDMA_EXPIRE
+  #define RFM69_TDMA_EXPIRE    10  // superframes a node can stay silent before the gateway frees its slot
+#endif
+
+class RFM69_TDMAGateway {
+  public:
+    RFM69_TDMAGateway(RFM69& radio, uint16_t period=1000, uint16_t slotLength=50);
+
+    bool update();                 // call from loop(): broadcasts the beacon every period, true when it did
+    int8_t heard(uint16_t nodeId); // call for every packet received: assigns a slot to new nodes, returns it (-1 = full)
+    void release(uint16_t nodeId);
+
+    uint8_t slots();               // length of the slot table sent in the beacon
+    uint8_t maxSlots();            // slots that fit in the period and in a beacon
+    uint16_t owner();              // node whose slot is on air now, 0 for the beacon and the contention period
+
+  protected:
+    RFM69& _radio;
+    uint16_t _period;
+    uint16_t _slotLength;
+    uint16_t _nodes[RFM69_TDMA_MAX_SLOTS]; // 0 = free
+    uint8_t _idle[RFM69_TDMA_MAX_SLOTS];   // beacons sent since the owner was heard
+    uint8_t _seq;
+    bool _started;
+    uint32_t _nextBeacon; // millis() the next beacon is due
+    uint32_t _beaconAt;   // millis() the last beacon started on air
+};
+
+// node side:
+//   if (radio.receiveDone() && tdma.receive()) ... beacon, resynchronized
+//   if (tdma.untilSlot() == 0) tdma.send(data, len);
+//   sleep for min(untilSlot(), untilBeacon()), then tdma.slept(ms) if millis() was stopped
+class RFM69_TDMANode {
+  public:
+    RFM69_TDMANode(RFM69& radio, uint16_t nodeId);
+    static bool isBeacon(const void* data, uint8_t len);
+
+    bool receive();               // call after receiveDone(), true if the packet was a beacon
+    bool synced();                // a beacon was heard within the last RFM69_TDMA_MAX_MISSED periods
+    int8_t slot() { return _slot; } // -1 = none yet, sending in the contention period
+    uint16_t gateway() { return _gateway; }
+
+    uint32_t untilSlot();         // ms until our slot (or the contention period) opens, 0 while it is open
+    uint32_t untilBeacon();       // ms until the radio must listen for the next beacon, 0 while it should
+    uint32_t slotRemaining();     // ms we can still transmit in the open slot
+    uint16_t beaconWindow();      // ms to listen around the expected beacon time
+    bool send(const void* data, uint8_t len, uint8_t retries=2); // to the gateway, false if not ACKed or outside our slot
+
+    void slept(uint32_t ms) { _slept += ms; } // the MCU slept ms with millis() stopped (WDT, listenModeSleep)
+    uint32_t now() { return millis() + _slept; }
+    uint32_t gatewayTime() { return _gatewayTime + (now() - _beaconAt); } // gateway's millis() now
+
+  protected:
+    uint32_t phase() { return (now() - _beaconAt) % _period; } // ms into the current superframe
+
+    RFM69& _radio;
+    uint16_t _nodeId;
+    uint16_t _gateway;
+    uint16_t _period;     // 0 = never synced
+    uint16_t _slotLength;
+    uint8_t _slots;
+    int8_t _slot;
+    uint8_t _seq;
+    uint32_t _beaconAt;   // now() when the last beacon started on air
+    uint32_t _gatewayTime;
+    uint32_t _slept;
+};
+
+#endif
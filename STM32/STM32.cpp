@@ -2,6 +2,7 @@
 #include <stm32f1xx_hal.h>
 
 unsigned long millis() { return 0;}
+unsigned long micros() { return millis() * 1000UL; }
 uint32_t abs(uint32_t val)  { return val >= 0 ? val : val *= -1; }
 
 void detachInterrupt(struct gpio_pin &irqnum) {}
@@ -2,6 +2,7 @@
 
 #include <stdint.h>
 #include <cstdio> /* sprintf and sscanf */
+#include <cstring> /* memcpy and memcmp */
 
 #include "Serial.h"
 
@@ -51,6 +52,7 @@ struct gpio_pin {
 #define F(str) str
 
 unsigned long millis();
+unsigned long micros();
 uint32_t abs(uint32_t val);
 
 
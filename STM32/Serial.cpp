@@ -26,6 +26,8 @@ void SerialDebug::println(const char *val, int type) {}
 void SerialDebug::println(int val, int type) {}
 void SerialDebug::println(float val) {}
 void SerialDebug::setTimeout(int val) {}
+int SerialDebug::available() { return 0; }
+int SerialDebug::read() { return -1; }
 int SerialDebug::readBytesUntil(const char, const char*, int len)
 {
 	return 0;
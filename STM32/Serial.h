@@ -20,6 +20,8 @@ public:
 	void println(float val);
 
 	void setTimeout(int val);
+	int available();
+	int read();
 	int readBytesUntil(const char, const char*, int len);
 };
 